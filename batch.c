@@ -0,0 +1,589 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2008 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrean
+ * San Diego, CA   92122
+ * pierce@cirrus.ucsd.edu
+ */
+
+
+/*******************************************************************************
+ * 	batch.c
+ *
+ *	Renders the frames of a variable straight to PPM files, without an
+ *	X display, so that movies can be made on machines that have none 
+ *	(the -batch option).
+ *
+ *	The netCDF library is not thread safe, so the main thread does the
+ *	reading: it reads each frame into one of a small ring of slots, 
+ *	along with a copy of the view (and, with -minmax frame, the frame's 
+ *	range, which is smoothed against the frames before it so must be
+ *	worked out in order).  A pool of worker threads takes the frames 
+ *	from there and does everything else: each turns its frame into 
+ *	pixels with data_to_pixels, exactly as the interactive path does but
+ *	with scratch space of its own, then writes it out with 
+ *	frameexport_write_ppm.  A worker always takes the oldest waiting 
+ *	frame, and files are written strictly in turn, so the frames come 
+ *	out in order.
+ *******************************************************************************/
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+extern Options   options;
+extern ncv_pixel *pixel_transform;
+
+#define BATCH_N_EXTRA_COLORS	10	/* same as N_EXTRA_COLORS in x_interface.c */
+#define BATCH_SLOTS_PER_WORKER	2
+
+#define SLOT_FREE	0
+#define SLOT_FULL	1	/* holds a frame waiting for a worker */
+#define SLOT_BUSY	2	/* a worker is reading the frame */
+
+typedef struct _batch_cmap {
+	char	*name;
+	unsigned char r[256], g[256], b[256];
+	struct _batch_cmap *next;
+} BatchCmap;
+
+typedef struct {
+	int		state;
+	size_t		seq,		/* position in the output order */
+			frameno;	/* place along the scan axis */
+	View		view;		/* the frame, as the main thread read it */
+	float		*data;
+	size_t		*var_place;
+	ncv_pixel	*pixels;
+} BatchSlot;
+
+static BatchCmap	*cmap_list = NULL;
+static unsigned char	palette[256][3];
+static ncv_pixel	identity_transform[256];
+
+static BatchSlot	*slot;
+static int		n_slots;
+static size_t		image_width, image_height, next_to_write;
+static int		producer_done, n_errors;
+static pthread_mutex_t	batch_lock    = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	batch_changed = PTHREAD_COND_INITIALIZER;
+
+unsigned char 	interp( int i, int range_i, unsigned char *mat, int n_entries );
+
+static int	batch_set_axes( View *v );
+static void	batch_set_range( View *v, size_t first, size_t last );
+static int	batch_set_palette( void );
+static void	batch_read_frame( View *v, size_t frameno );
+static BatchSlot *batch_oldest_slot( int state );
+static void	*batch_worker( void *arg );
+
+/*******************************************************************************
+ * Colormaps come here instead of going to the display when in batch mode.
+ * As with the interactive colormaps, the first one seen with a given name
+ * is the one that is kept.
+ */
+	void
+batch_add_colormap( char *name, unsigned char r[256], unsigned char g[256], unsigned char b[256] )
+{
+	BatchCmap *cm, *last;
+
+	last = NULL;
+	for( cm=cmap_list; cm != NULL; cm=cm->next ) {
+		if( strcmp( cm->name, name ) == 0 )
+			return;
+		last = cm;
+		}
+
+	cm = (BatchCmap *)malloc( sizeof(BatchCmap) );
+	if( cm == NULL ) {
+		fprintf( stderr, "ncview: batch_add_colormap: failed on malloc\n" );
+		exit( -1 );
+		}
+	cm->name = (char *)malloc( strlen(name)+1 );
+	if( cm->name == NULL ) {
+		fprintf( stderr, "ncview: batch_add_colormap: failed on malloc\n" );
+		exit( -1 );
+		}
+	strcpy( cm->name, name );
+	memcpy( cm->r, r, 256 );
+	memcpy( cm->g, g, 256 );
+	memcpy( cm->b, b, 256 );
+	cm->next = NULL;
+
+	if( last == NULL )
+		cmap_list = cm;
+	else
+		last->next = cm;
+}
+
+/*******************************************************************************
+ * Render the frames asked for on the command line.  Returns 0 on success,
+ * -1 if anything went wrong.
+ */
+	int
+batch_render( void )
+{
+	NCVar		*var;
+	View		view;
+	size_t		x_size, y_size, n_frames, first, last, f, seq;
+	int		i, n_threads;
+	pthread_t	*thread;
+	BatchSlot	*s;
+
+	if( (var = get_var( options.batch_var )) == NULL ) {
+		fprintf( stderr, "ncview: -batch: there is no variable named %s\n", options.batch_var );
+		return( -1 );
+		}
+	load_var_dims( var );
+
+	initialize_colormaps();
+	if( cmap_list == NULL )
+		create_default_colormap();
+	if( batch_set_palette() < 0 )
+		return( -1 );
+
+	/* Each frame is read exactly once, so there is no point caching it */
+	slabcache_init( 0L );
+
+	/* data_to_pixels puts out colormap indices, with no pixel translation */
+	options.display_type = TrueColor;
+	options.blowup       = options.batch_mag;
+	for( i=0; i<256; i++ )
+		identity_transform[i] = (ncv_pixel)i;
+	pixel_transform = identity_transform;
+
+	view.variable    = var;
+	view.skip        = 1;
+	view.have_frame_range    = FALSE;
+	view.frame_range_current = FALSE;
+	view.have_prev_range     = FALSE;
+	view.n_frame_ranges      = 0L;
+	view.frame_ranges        = NULL;
+	view.var_place   = (size_t *)malloc( var->n_dims*sizeof(size_t) );
+	if( view.var_place == NULL ) {
+		fprintf( stderr, "ncview: batch_render: failed on malloc\n" );
+		exit( -1 );
+		}
+	for( i=0; i<var->n_dims; i++ )
+		*(view.var_place+i) = 0L;
+	if( batch_set_axes( &view ) < 0 )
+		return( -1 );
+
+	x_size = *(var->size + view.x_axis_id);
+	y_size = *(var->size + view.y_axis_id);
+	view.data = (float *)malloc( x_size*y_size*sizeof(float) );
+	if( view.data == NULL ) {
+		fprintf( stderr, "ncview: batch_render: failed to allocate %ld x %ld data array\n",
+			(long)x_size, (long)y_size );
+		exit( -1 );
+		}
+	view_get_scaled_size( options.blowup, x_size, y_size, &image_width, &image_height );
+
+	if( view.scan_axis_id == -1 )
+		n_frames = 1L;
+	else
+		n_frames = *(var->size + view.scan_axis_id);
+	first = 0L;
+	last  = n_frames-1L;
+	if( options.batch_first > 0 ) {
+		first = options.batch_first-1L;
+		last  = options.batch_last-1L;
+		if( last >= n_frames ) {
+			fprintf( stderr, "ncview: -batch_frames: %s only has %ld frames\n", 
+				var->name, (long)n_frames );
+			return( -1 );
+			}
+		}
+
+	batch_set_range( &view, first, last );
+
+	n_threads = options.batch_threads;
+	if( n_threads < 1 )
+		n_threads = (int)sysconf( _SC_NPROCESSORS_ONLN );
+	if( n_threads < 1 )
+		n_threads = 1;
+	if( (size_t)n_threads > last-first+1L )
+		n_threads = (int)(last-first+1L);
+
+	/* From here on, the frames are read into the slots */
+	free( view.data );
+	view.data = NULL;
+
+	n_slots = BATCH_SLOTS_PER_WORKER * n_threads;
+	slot    = (BatchSlot *)malloc( n_slots*sizeof(BatchSlot) );
+	thread  = (pthread_t *)malloc( n_threads*sizeof(pthread_t) );
+	if( (slot == NULL) || (thread == NULL) ) {
+		fprintf( stderr, "ncview: batch_render: failed on malloc\n" );
+		exit( -1 );
+		}
+	for( i=0; i<n_slots; i++ ) {
+		(slot+i)->state     = SLOT_FREE;
+		(slot+i)->data      = (float *)malloc( x_size*y_size*sizeof(float) );
+		(slot+i)->var_place = (size_t *)malloc( var->n_dims*sizeof(size_t) );
+		(slot+i)->pixels    = (ncv_pixel *)malloc( image_width*image_height*sizeof(ncv_pixel) );
+		if( ((slot+i)->data == NULL) || ((slot+i)->var_place == NULL) ) {
+			fprintf( stderr, "ncview: batch_render: failed to allocate %ld x %ld data array\n",
+				(long)x_size, (long)y_size );
+			exit( -1 );
+			}
+		if( (slot+i)->pixels == NULL ) {
+			fprintf( stderr, "ncview: batch_render: failed to allocate %ld x %ld image\n",
+				(long)image_width, (long)image_height );
+			exit( -1 );
+			}
+		}
+
+	next_to_write = 0L;
+	producer_done = FALSE;
+	n_errors      = 0;
+	for( i=0; i<n_threads; i++ )
+		if( pthread_create( thread+i, NULL, batch_worker, NULL ) != 0 ) {
+			fprintf( stderr, "ncview: batch_render: can't start worker thread\n" );
+			exit( -1 );
+			}
+
+	for( f=first, seq=0L; f<=last; f++, seq++ ) {
+		pthread_mutex_lock( &batch_lock );
+		while( (s = batch_oldest_slot( SLOT_FREE )) == NULL )
+			pthread_cond_wait( &batch_changed, &batch_lock );
+		pthread_mutex_unlock( &batch_lock );
+
+		/* Nobody else touches a free slot, so this can be done unlocked.
+		 * The slot gets its own copy of the view, so that the worker 
+		 * sees the place and range this frame was read with.
+		 */
+		view.data = s->data;
+		batch_read_frame( &view, f );
+		if( options.range_mode == RANGE_MODE_FRAME )
+			set_frame_range( &view );
+		s->view           = view;
+		s->view.var_place = s->var_place;
+		s->view.pixels    = s->pixels;
+		for( i=0; i<var->n_dims; i++ )
+			*(s->var_place+i) = *(view.var_place+i);
+
+		pthread_mutex_lock( &batch_lock );
+		s->seq     = seq;
+		s->frameno = f;
+		s->state   = SLOT_FULL;
+		pthread_cond_broadcast( &batch_changed );
+		pthread_mutex_unlock( &batch_lock );
+		}
+
+	pthread_mutex_lock( &batch_lock );
+	producer_done = TRUE;
+	pthread_cond_broadcast( &batch_changed );
+	pthread_mutex_unlock( &batch_lock );
+
+	for( i=0; i<n_threads; i++ )
+		pthread_join( *(thread+i), NULL );
+
+	for( i=0; i<n_slots; i++ ) {
+		free( (slot+i)->data );
+		free( (slot+i)->var_place );
+		free( (slot+i)->pixels );
+		}
+	free( slot );
+	free( thread );
+	free( view.var_place );
+	if( view.frame_ranges != NULL )
+		free( view.frame_ranges );
+
+	if( n_errors > 0 )
+		return( -1 );
+
+	fprintf( stderr, "ncview: wrote %ld frames of %s, %ld x %ld, to %s.NNNNN.ppm\n",
+		(long)next_to_write, var->name, (long)image_width, (long)image_height,
+		options.batch_prefix );
+	return( 0 );
+}
+
+/*******************************************************************************
+ * Picks the X, Y, and scan axes, either from -batch_axes or the same way
+ * the interactive display does: X and Y are the last two scannable dims,
+ * and the first one is scanned.  Returns 0 on success, -1 on failure.
+ */
+	static int
+batch_set_axes( View *v )
+{
+	NCVar		*var;
+	Stringlist	*dims, *d;
+	int		n, id, tmp;
+
+	var  = v->variable;
+	dims = fi_scannable_dims( var->first_file->id, var->name );
+	n    = n_strings_in_list( dims );
+	if( n < 2 ) {
+		fprintf( stderr, "ncview: -batch: %s does not have two dimensions to display\n", var->name );
+		return( -1 );
+		}
+
+	if( options.batch_x_dim != NULL ) {
+		v->x_axis_id = fi_dim_name_to_id( var->first_file->id, var->name, options.batch_x_dim );
+		v->y_axis_id = fi_dim_name_to_id( var->first_file->id, var->name, options.batch_y_dim );
+		if( (v->x_axis_id == -1) || (v->y_axis_id == -1) || (v->x_axis_id == v->y_axis_id) ) {
+			fprintf( stderr, "ncview: -batch_axes: %s,%s are not two different dimensions of %s\n",
+				options.batch_x_dim, options.batch_y_dim, var->name );
+			return( -1 );
+			}
+		/* As in the interactive version, transposing is not allowed */
+		if( v->x_axis_id < v->y_axis_id ) {
+			fprintf( stderr, "ncview: -batch_axes: transposing the data is not allowed, switching the axes\n" );
+			tmp          = v->x_axis_id;
+			v->x_axis_id = v->y_axis_id;
+			v->y_axis_id = tmp;
+			}
+		}
+	else
+		{
+		d = dims;
+		while( ((Stringlist *)(d->next))->next != NULL )
+			d = d->next;
+		v->y_axis_id = fi_dim_name_to_id( var->first_file->id, var->name, d->string );
+		d = d->next;
+		v->x_axis_id = fi_dim_name_to_id( var->first_file->id, var->name, d->string );
+		}
+
+	v->scan_axis_id = -1;
+	for( d=dims; d != NULL; d=d->next ) {
+		id = fi_dim_name_to_id( var->first_file->id, var->name, d->string );
+		if( (id != v->x_axis_id) && (id != v->y_axis_id) ) {
+			v->scan_axis_id = id;
+			break;
+			}
+		}
+
+	return( 0 );
+}
+
+/*******************************************************************************
+ * Sets the data range, from -batch_range or, like the default "-minmax fast",
+ * from the first, middle, and last frames being rendered.  There is nobody 
+ * to ask, so a computed range is just limited to any valid_range given in
+ * the file.
+ */
+	static void
+batch_set_range( View *v, size_t first, size_t last )
+{
+	NCVar	*var;
+	float	min, max, valid_min, valid_max, *data;
+	size_t	frame[3], n;
+	int	k;
+
+	var = v->variable;
+
+	if( options.batch_have_range ) {
+		min = options.batch_min;
+		max = options.batch_max;
+		}
+	else
+		{
+		frame[0] = first;
+		frame[1] = (first+last)/2L;
+		frame[2] = last;
+		n    = *(var->size + v->x_axis_id) * *(var->size + v->y_axis_id);
+		data = (float *)v->data;
+		min  =  9.9e30;
+		max  = -9.9e30;
+		for( k=0; k<3; k++ ) {
+			if( (k > 0) && (frame[k] == frame[k-1]) )
+				continue;
+			batch_read_frame( v, frame[k] );
+			data_valid_range( data, n, var->fill_value, &min, &max );
+			}
+		if( min > max ) 	/* nothing but fill values */
+			min = max = 0.0;
+
+		if( netcdf_min_max_option_set( var, &valid_min, &valid_max )) {
+			if( min < valid_min )
+				min = valid_min;
+			if( max > valid_max )
+				max = valid_max;
+			}
+		if( netcdf_min_option_set( var, &valid_min ) && (min < valid_min) )
+			min = valid_min;
+		if( netcdf_max_option_set( var, &valid_max ) && (max > valid_max) )
+			max = valid_max;
+		}
+
+	/* data_to_pixels would put up a dialog about a range like this */
+	if( min == max ) {
+		if( max == 0.0 )
+			max = 1.0;
+		else if( max > 0.0 )
+			min = 0.0;
+		else
+			max = 0.0;
+		}
+
+	var->global_min     = min;
+	var->global_max     = max;
+	var->user_min       = min;
+	var->user_max       = max;
+	var->have_set_range = TRUE;
+
+	if( options.debug )
+		fprintf( stderr, "batch: range for %s is %g to %g\n", var->name, min, max );
+}
+
+/*******************************************************************************
+ * The colors are set up exactly as x_create_colormap does it, so the frames
+ * look the same as they do on the screen.
+ */
+	static int
+batch_set_palette( void )
+{
+	BatchCmap *cm;
+	int	i;
+
+	cm = cmap_list;
+	if( options.batch_cmap != NULL ) {
+		while( (cm != NULL) && (strcmp( cm->name, options.batch_cmap ) != 0) )
+			cm = cm->next;
+		if( cm == NULL ) {
+			fprintf( stderr, "ncview: -batch_cmap: no colormap named %s; known colormaps are:",
+				options.batch_cmap );
+			for( cm=cmap_list; cm != NULL; cm=cm->next )
+				fprintf( stderr, " %s", cm->name );
+			fprintf( stderr, "\n" );
+			return( -1 );
+			}
+		}
+
+	for( i=0; i<256; i++ ) {
+		palette[i][0] = 255;
+		palette[i][1] = 255;
+		palette[i][2] = 255;
+		}
+	palette[1][0] = 0;
+	palette[1][1] = 0;
+	palette[1][2] = 0;
+
+	for( i=BATCH_N_EXTRA_COLORS; (i<options.n_colors+BATCH_N_EXTRA_COLORS) && (i<256); i++ ) {
+		palette[i][0] = interp( i-BATCH_N_EXTRA_COLORS, options.n_colors, cm->r, 256 );
+		palette[i][1] = interp( i-BATCH_N_EXTRA_COLORS, options.n_colors, cm->g, 256 );
+		palette[i][2] = interp( i-BATCH_N_EXTRA_COLORS, options.n_colors, cm->b, 256 );
+		}
+
+	return( 0 );
+}
+
+/*******************************************************************************/
+	static void
+batch_read_frame( View *v, size_t frameno )
+{
+	size_t	count[MAX_VAR_DIMS];
+	int	i;
+
+	for( i=0; i<v->variable->n_dims; i++ )
+		*(count+i) = 1L;
+	*(count+v->x_axis_id) = *(v->variable->size + v->x_axis_id);
+	*(count+v->y_axis_id) = *(v->variable->size + v->y_axis_id);
+
+	if( v->scan_axis_id != -1 )
+		*(v->var_place + v->scan_axis_id) = frameno;
+
+	fi_get_data( v->variable, v->var_place, count, v->data );
+	v->data_status = VDS_VALID;
+}
+
+/*******************************************************************************
+ * Returns the slot in the given state that holds the earliest frame, or 
+ * NULL if there isn't one.  Must be called with batch_lock held.
+ */
+	static BatchSlot *
+batch_oldest_slot( int state )
+{
+	BatchSlot *s, *oldest;
+	int	i;
+
+	oldest = NULL;
+	for( i=0; i<n_slots; i++ ) {
+		s = slot+i;
+		if( (s->state == state) && ((oldest == NULL) || (s->seq < oldest->seq)) )
+			oldest = s;
+		}
+
+	return( oldest );
+}
+
+/*******************************************************************************
+ * Worker thread.  Because workers always take the earliest frame waiting,
+ * whichever frame is next to be written has already been taken by a 
+ * worker that is not itself waiting to write, so waiting for our turn 
+ * can't deadlock.  The slot is held until the frame has been written, so
+ * it is the slots running out that keeps the main thread from reading 
+ * too far ahead.
+ */
+	static void *
+batch_worker( void *arg )
+{
+	unsigned char	*image;
+	char		filename[2048];
+	RenderScratch	*scratch;
+	BatchSlot	*s;
+	int		err;
+
+	image = (unsigned char *)malloc( frameexport_ppm_size( image_width, image_height ));
+	if( image == NULL ) {
+		fprintf( stderr, "ncview: batch_worker: failed to allocate %ld x %ld image\n",
+			(long)image_width, (long)image_height );
+		exit( -1 );
+		}
+	scratch = render_scratch_new();
+
+	for( ;; ) {
+		pthread_mutex_lock( &batch_lock );
+		while( ((s = batch_oldest_slot( SLOT_FULL )) == NULL) && (! producer_done) )
+			pthread_cond_wait( &batch_changed, &batch_lock );
+		if( s == NULL ) {
+			pthread_mutex_unlock( &batch_lock );
+			break;
+			}
+		s->state = SLOT_BUSY;
+		pthread_mutex_unlock( &batch_lock );
+
+		s->view.scratch = scratch;
+		err = data_to_pixels( &s->view );
+		if( err < 0 )
+			fprintf( stderr, "ncview: -batch: failed to make frame %ld\n", (long)(s->frameno+1L) );
+
+		pthread_mutex_lock( &batch_lock );
+		while( next_to_write != s->seq )
+			pthread_cond_wait( &batch_changed, &batch_lock );
+		pthread_mutex_unlock( &batch_lock );
+
+		if( err == 0 ) {
+			sprintf( filename, "%s.%05ld.ppm", options.batch_prefix, (long)s->frameno );
+			err = frameexport_write_ppm( filename, s->pixels, image_width, image_height,
+					palette, image );
+			}
+
+		pthread_mutex_lock( &batch_lock );
+		if( err < 0 )
+			n_errors++;
+		next_to_write++;
+		s->state = SLOT_FREE;
+		pthread_cond_broadcast( &batch_changed );
+		pthread_mutex_unlock( &batch_lock );
+		}
+
+	render_scratch_free( scratch );
+	free( image );
+	return( NULL );
+}
@@ -0,0 +1,601 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2008 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrean
+ * San Diego, CA   92122
+ * pierce@cirrus.ucsd.edu
+ */
+
+/*******************************************************************************
+ * 	bench.c
+ *
+ *	The benchmark program, ncview_bench, built with "make bench".  It
+ *	needs no display.  It writes synthetic netCDF files of the asked
+ *	for shape, type, packing, fraction of missing values, and number
+ *	of files, opens them the same way ncview does, and then times the
+ *	routines that reading and drawing a frame spend their time in:
+ *
+ *		fi_get_data		one frame
+ *		fi_get_data_iterate	a time series through all the files
+ *		init_min_max		with -minmax fast
+ *		expand_data		replicate and bilinear
+ *		contract_data		mean and mode
+ *		data_to_pixels		scaling the data to colormap indices
+ *		make_tc_data		16, 24, and 32 bit TrueColor
+ *
+ *	Each is run once to warm up, then -reps times.  The results go
+ *	to a CSV (the default) or JSON file, one row per routine, so runs
+ *	from different versions can be compared.  Options:
+ *
+ *	-nx N -ny N	size of each frame (default 720 x 360)
+ *	-nt N		frames in each file (default 12)
+ *	-files N	number of files the variable is split across (default 1)
+ *	-type T		float, double, short, or byte (default float)
+ *	-packed		store short or byte data with scale_factor and add_offset
+ *	-fill F		fraction of points that are missing (default 0.1)
+ *	-mag N		blowup used for expand_data (default 3)
+ *	-shrink N	shrink factor used for contract_data (default 3)
+ *	-reps N		timed runs of each routine (default 20)
+ *	-json		write JSON instead of CSV
+ *	-o FILE		where to write the results (default ncview_bench.csv or .json)
+ *	-dir DIR	where to make the data files (default /tmp)
+ *	-keep		don't remove the data files afterwards
+ *	-make_only	just make the data files, print their names, and exit
+ *			(bench_play.sh uses this)
+ *******************************************************************************/
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#define BENCH_MAX_RESULTS	16
+#define BENCH_VAR_NAME		"field"
+#define BENCH_PI		3.14159265358979
+
+typedef struct {
+	char	*kernel, *variant;
+	double	min, median, mean;	/* seconds per call */
+	double	n_points;		/* points handled per call */
+} BenchResult;
+
+extern Options   options;
+extern ncv_pixel *pixel_transform;
+
+static size_t	nx = 720L, ny = 360L, nt = 12L;
+static int	n_files = 1, packed = FALSE, n_reps = 20, mag = 3, shrink = 3, want_json = FALSE;
+static int	keep_files = FALSE, make_only = FALSE;
+static nc_type	data_type = NC_FLOAT;
+static double	fill_frac = 0.1;
+static char	*out_fname = NULL, *data_dir = "/tmp";
+
+static NCVar	*var;
+static View	bview;
+static size_t	n_frames;
+static float	*work, *series;
+static unsigned char *tc_buf;
+static ncv_pixel identity_transform[256];
+
+static BenchResult result[BENCH_MAX_RESULTS];
+static int	n_results = 0;
+
+static int	bench_parse_args( int argc, char **argv );
+static void	bench_make_file( char *fname, int file_no );
+static void	bench_nc_check( int err, char *what );
+static char	*bench_type_name( nc_type type );
+static void	bench_run( char *kernel, char *variant, void (*fn)( int rep ), double n_points );
+static int	bench_write_results( void );
+static int	double_cmp( const void *a, const void *b );
+
+static void	k_get_data	( int rep );
+static void	k_get_data_iterate( int rep );
+static void	k_min_max	( int rep );
+static void	k_expand	( int rep );
+static void	k_contract	( int rep );
+static void	k_data_to_pixels( int rep );
+static void	k_tc_16		( int rep );
+static void	k_tc_24		( int rep );
+static void	k_tc_32		( int rep );
+
+/*******************************************************************************
+ * Called from main() in place of everything else when ncview.c is compiled
+ * with NCVIEW_BENCH.
+ */
+	int
+bench_main( int argc, char **argv )
+{
+	Stringlist	*files;
+	char		fname[1024];
+	size_t		big_nx, big_ny;
+	int		i, retval;
+
+	initialize_misc();
+	if( bench_parse_args( argc, argv ) < 0 )
+		return( -1 );
+	if( out_fname == NULL )
+		out_fname = want_json ? "ncview_bench.json" : "ncview_bench.csv";
+
+	files = NULL;
+	for( i=0; i<n_files; i++ ) {
+		snprintf( fname, 1024, "%s/ncview_bench_%ld.%02d.nc", data_dir, (long)getpid(), i );
+		bench_make_file( fname, i );
+		add_to_stringlist( &files, fname, NULL );
+		if( make_only )
+			printf( "%s\n", fname );
+		}
+	if( make_only )
+		return( 0 );
+
+	/* Set up the same way main() does, but without the display */
+	determine_file_type( files );
+	slabcache_init( 0L );
+	initialize_file_interface( files );
+	if( (var = get_var( BENCH_VAR_NAME )) == NULL ) {
+		fprintf( stderr, "ncview_bench: variable %s was not found in the files\n", BENCH_VAR_NAME );
+		return( -1 );
+		}
+	load_var_dims( var );
+	n_frames = *(var->size);
+
+	/* data_to_pixels puts out colormap indices, with no pixel translation */
+	options.display_type   = TrueColor;
+	options.min_max_method = MIN_MAX_METHOD_FAST;
+	for( i=0; i<256; i++ )
+		identity_transform[i] = (ncv_pixel)i;
+	pixel_transform = identity_transform;
+
+	view_get_scaled_size( mag, nx, ny, &big_nx, &big_ny );
+
+	bview.variable     = var;
+	bview.x_axis_id    = 2;
+	bview.y_axis_id    = 1;
+	bview.scan_axis_id = 0;
+	bview.skip         = 1;
+	bview.data_status  = VDS_VALID;
+	bview.have_frame_range    = FALSE;
+	bview.frame_range_current = FALSE;
+	bview.have_prev_range     = FALSE;
+	bview.n_frame_ranges      = 0L;
+	bview.frame_ranges        = NULL;
+	bview.var_place = (size_t *)malloc( var->n_dims*sizeof(size_t) );
+	bview.data      = (float *)malloc( nx*ny*sizeof(float) );
+	bview.pixels    = (ncv_pixel *)malloc( nx*ny*sizeof(ncv_pixel) );
+	work            = (float *)malloc( big_nx*big_ny*sizeof(float) );
+	series          = (float *)malloc( n_frames*sizeof(float) );
+	tc_buf          = (unsigned char *)malloc( (4L*nx + 4L)*ny );
+	if( (bview.var_place == NULL) || (bview.data == NULL) || (bview.pixels == NULL) ||
+	    (work == NULL) || (series == NULL) || (tc_buf == NULL) ) {
+		fprintf( stderr, "ncview_bench: failed on malloc\n" );
+		exit( -1 );
+		}
+	for( i=0; i<var->n_dims; i++ )
+		*(bview.var_place+i) = 0L;
+
+	bench_run( "fi_get_data", "frame", k_get_data, (double)(nx*ny) );
+	if( var->is_virtual )
+		bench_run( "fi_get_data_iterate", "time series", k_get_data_iterate, (double)n_frames );
+	bench_run( "init_min_max", "fast", k_min_max,
+		(double)(nx*ny) * (double)((n_frames < 3) ? n_frames : 3) );
+
+	/* The rest work on the first frame */
+	k_get_data( 0 );
+
+	options.blowup      = mag;
+	options.blowup_type = BLOWUP_REPLICATE;
+	bench_run( "expand_data", "replicate", k_expand, (double)(big_nx*big_ny) );
+	options.blowup_type = BLOWUP_BILINEAR;
+	bench_run( "expand_data", "bilinear", k_expand, (double)(big_nx*big_ny) );
+
+	options.blowup        = -shrink;
+	options.shrink_method = SHRINK_METHOD_MEAN;
+	bench_run( "contract_data", "mean", k_contract, (double)(nx*ny) );
+	options.shrink_method = SHRINK_METHOD_MODE;
+	bench_run( "contract_data", "mode", k_contract, (double)(nx*ny) );
+
+	options.blowup      = 1;
+	options.blowup_type = BLOWUP_REPLICATE;
+	bench_run( "data_to_pixels", "mag 1", k_data_to_pixels, (double)(nx*ny) );
+
+	bench_run( "make_tc_data", "16 bit", k_tc_16, (double)(nx*ny) );
+	bench_run( "make_tc_data", "24 bit", k_tc_24, (double)(nx*ny) );
+	bench_run( "make_tc_data", "32 bit", k_tc_32, (double)(nx*ny) );
+
+	retval = bench_write_results();
+
+	if( ! keep_files ) {
+		for( i=0; i<n_files; i++ ) {
+			snprintf( fname, 1024, "%s/ncview_bench_%ld.%02d.nc", data_dir, (long)getpid(), i );
+			unlink( fname );
+			}
+		}
+
+	return( retval );
+}
+
+/*******************************************************************************/
+	static int
+bench_parse_args( int argc, char **argv )
+{
+	int	i;
+
+	for( i=1; i<argc; i++ ) {
+		if( (strcmp( argv[i], "-nx" ) == 0) && (i+1 < argc) )
+			nx = (size_t)atol( argv[++i] );
+		else if( (strcmp( argv[i], "-ny" ) == 0) && (i+1 < argc) )
+			ny = (size_t)atol( argv[++i] );
+		else if( (strcmp( argv[i], "-nt" ) == 0) && (i+1 < argc) )
+			nt = (size_t)atol( argv[++i] );
+		else if( (strcmp( argv[i], "-files" ) == 0) && (i+1 < argc) )
+			n_files = atoi( argv[++i] );
+		else if( (strcmp( argv[i], "-type" ) == 0) && (i+1 < argc) ) {
+			i++;
+			if( strcmp( argv[i], "float" ) == 0 )
+				data_type = NC_FLOAT;
+			else if( strcmp( argv[i], "double" ) == 0 )
+				data_type = NC_DOUBLE;
+			else if( strcmp( argv[i], "short" ) == 0 )
+				data_type = NC_SHORT;
+			else if( strcmp( argv[i], "byte" ) == 0 )
+				data_type = NC_BYTE;
+			else
+				{
+				fprintf( stderr, "ncview_bench: -type must be float, double, short, or byte\n" );
+				return( -1 );
+				}
+			}
+		else if( strcmp( argv[i], "-packed" ) == 0 )
+			packed = TRUE;
+		else if( (strcmp( argv[i], "-fill" ) == 0) && (i+1 < argc) )
+			fill_frac = atof( argv[++i] );
+		else if( (strcmp( argv[i], "-mag" ) == 0) && (i+1 < argc) )
+			mag = atoi( argv[++i] );
+		else if( (strcmp( argv[i], "-shrink" ) == 0) && (i+1 < argc) )
+			shrink = atoi( argv[++i] );
+		else if( (strcmp( argv[i], "-reps" ) == 0) && (i+1 < argc) )
+			n_reps = atoi( argv[++i] );
+		else if( strcmp( argv[i], "-json" ) == 0 )
+			want_json = TRUE;
+		else if( (strcmp( argv[i], "-o" ) == 0) && (i+1 < argc) )
+			out_fname = argv[++i];
+		else if( (strcmp( argv[i], "-dir" ) == 0) && (i+1 < argc) )
+			data_dir = argv[++i];
+		else if( strcmp( argv[i], "-keep" ) == 0 )
+			keep_files = TRUE;
+		else if( strcmp( argv[i], "-make_only" ) == 0 )
+			make_only = TRUE;
+		else
+			{
+			fprintf( stderr, "ncview_bench: unrecognized option or missing value: %s\n", argv[i] );
+			fprintf( stderr, "useage: ncview_bench [-nx N] [-ny N] [-nt N] [-files N] [-type float|double|short|byte]\n" );
+			fprintf( stderr, "	[-packed] [-fill F] [-mag N] [-shrink N] [-reps N] [-json] [-o FILE] [-dir DIR] [-keep] [-make_only]\n" );
+			return( -1 );
+			}
+		}
+
+	if( (nx < 2) || (ny < 2) || (nt < 1) || (n_files < 1) || (n_reps < 1) ||
+	    (mag < 2) || (shrink < 2) || (fill_frac < 0.0) || (fill_frac >= 1.0) ) {
+		fprintf( stderr, "ncview_bench: sizes must be at least 2 (frames, files, and reps at least 1),\n" );
+		fprintf( stderr, "-mag and -shrink at least 2, and -fill from 0 up to, but not including, 1\n" );
+		return( -1 );
+		}
+	if( packed && ((data_type == NC_FLOAT) || (data_type == NC_DOUBLE)) ) {
+		fprintf( stderr, "ncview_bench: -packed needs -type short or -type byte\n" );
+		return( -1 );
+		}
+
+	return( 0 );
+}
+
+/*******************************************************************************
+ * The data are smooth waves that move a little from frame to frame, with
+ * a pseudo-random fill_frac of the points missing.  The same arguments
+ * always give the same files.  Coordinates are lon and lat, and time is
+ * in days, so the files look like ordinary model output.
+ */
+	static void
+bench_make_file( char *fname, int file_no )
+{
+	int		ncid, dimid[3], varid, timeid, latid, lonid;
+	size_t		i, j, t, start[3], count[3];
+	double		fill_value, scale_factor, add_offset, range, val, tval;
+	float		*frame, *coord;
+	float		f_scale, f_offset;
+	unsigned long	seed;
+
+	switch( data_type ) {
+		case NC_SHORT:	fill_value = -32767.0;	range = 30000.0;	break;
+		case NC_BYTE:	fill_value = -127.0;	range = 120.0;		break;
+		default:	fill_value = 1.0e35;	range = 20.0;		break;
+		}
+	add_offset   = 280.0;
+	scale_factor = 20.0/range;
+
+	bench_nc_check( nc_create( fname, NC_CLOBBER, &ncid ), "nc_create" );
+	bench_nc_check( nc_def_dim( ncid, "time", NC_UNLIMITED, dimid+0 ), "nc_def_dim" );
+	bench_nc_check( nc_def_dim( ncid, "lat",  ny, dimid+1 ), "nc_def_dim" );
+	bench_nc_check( nc_def_dim( ncid, "lon",  nx, dimid+2 ), "nc_def_dim" );
+
+	bench_nc_check( nc_def_var( ncid, "time", NC_DOUBLE, 1, dimid+0, &timeid ), "nc_def_var" );
+	bench_nc_check( nc_put_att_text( ncid, timeid, "units", 30, "days since 2000-01-01 00:00:00" ), "nc_put_att" );
+	bench_nc_check( nc_def_var( ncid, "lat", NC_FLOAT, 1, dimid+1, &latid ), "nc_def_var" );
+	bench_nc_check( nc_put_att_text( ncid, latid, "units", 13, "degrees_north" ), "nc_put_att" );
+	bench_nc_check( nc_def_var( ncid, "lon", NC_FLOAT, 1, dimid+2, &lonid ), "nc_def_var" );
+	bench_nc_check( nc_put_att_text( ncid, lonid, "units", 12, "degrees_east" ), "nc_put_att" );
+
+	bench_nc_check( nc_def_var( ncid, BENCH_VAR_NAME, data_type, 3, dimid, &varid ), "nc_def_var" );
+	bench_nc_check( nc_put_att_double( ncid, varid, "_FillValue", data_type, 1, &fill_value ), "nc_put_att" );
+	if( packed ) {
+		f_scale  = (float)scale_factor;
+		f_offset = (float)add_offset;
+		bench_nc_check( nc_put_att_float( ncid, varid, "scale_factor", NC_FLOAT, 1, &f_scale  ), "nc_put_att" );
+		bench_nc_check( nc_put_att_float( ncid, varid, "add_offset",   NC_FLOAT, 1, &f_offset ), "nc_put_att" );
+		}
+	bench_nc_check( nc_enddef( ncid ), "nc_enddef" );
+
+	coord = (float *)malloc( ((nx > ny) ? nx : ny)*sizeof(float) );
+	frame = (float *)malloc( nx*ny*sizeof(float) );
+	if( (coord == NULL) || (frame == NULL) ) {
+		fprintf( stderr, "ncview_bench: failed on malloc\n" );
+		exit( -1 );
+		}
+	for( j=0; j<ny; j++ )
+		*(coord+j) = -90.0 + 180.0*((float)j + 0.5)/(float)ny;
+	bench_nc_check( nc_put_var_float( ncid, latid, coord ), "nc_put_var" );
+	for( i=0; i<nx; i++ )
+		*(coord+i) = 360.0*((float)i + 0.5)/(float)nx;
+	bench_nc_check( nc_put_var_float( ncid, lonid, coord ), "nc_put_var" );
+
+	seed     = 12345UL + (unsigned long)file_no;
+	start[1] = 0L;
+	start[2] = 0L;
+	count[0] = 1L;
+	count[1] = ny;
+	count[2] = nx;
+	for( t=0; t<nt; t++ ) {
+		tval = (double)(file_no*nt + t);
+		for( j=0; j<ny; j++ )
+		for( i=0; i<nx; i++ ) {
+			seed = seed*1103515245UL + 12345UL;
+			if( (double)((seed>>16) & 0x7fff)/32768.0 < fill_frac ) {
+				*(frame+i+j*nx) = (float)fill_value;
+				continue;
+				}
+			val = sin( 6.0*BENCH_PI*(double)i/(double)nx + 0.1*tval ) *
+			      cos( 4.0*BENCH_PI*(double)j/(double)ny );
+			if( (data_type == NC_FLOAT) || (data_type == NC_DOUBLE) )
+				val = add_offset + range*val;
+			else
+				val = floor( range*val + 0.5 );
+			*(frame+i+j*nx) = (float)val;
+			}
+		start[0] = t;
+		bench_nc_check( nc_put_vara_double( ncid, timeid, start, count, &tval ), "nc_put_vara" );
+		bench_nc_check( nc_put_vara_float( ncid, varid, start, count, frame ), "nc_put_vara" );
+		}
+
+	bench_nc_check( nc_close( ncid ), "nc_close" );
+	free( coord );
+	free( frame );
+}
+
+/*******************************************************************************/
+	static void
+bench_nc_check( int err, char *what )
+{
+	if( err == NC_NOERR )
+		return;
+	fprintf( stderr, "ncview_bench: error making the data files, on %s: %s\n", what, nc_strerror(err) );
+	exit( -1 );
+}
+
+/*******************************************************************************/
+	static char *
+bench_type_name( nc_type type )
+{
+	switch( type ) {
+		case NC_DOUBLE:	return( "double" );
+		case NC_SHORT:	return( "short" );
+		case NC_BYTE:	return( "byte" );
+		default:	return( "float" );
+		}
+}
+
+/*******************************************************************************
+ * Time n_reps calls of fn, after one untimed call to warm up the caches.
+ */
+	static void
+bench_run( char *kernel, char *variant, void (*fn)( int rep ), double n_points )
+{
+	double		*t, t0, total;
+	int		rep;
+	BenchResult	*r;
+
+	if( n_results == BENCH_MAX_RESULTS ) {
+		fprintf( stderr, "ncview_bench: internal error, too many results\n" );
+		exit( -1 );
+		}
+
+	t = (double *)malloc( n_reps*sizeof(double) );
+	if( t == NULL ) {
+		fprintf( stderr, "ncview_bench: failed on malloc\n" );
+		exit( -1 );
+		}
+
+	fn( 0 );
+	total = 0.0;
+	for( rep=0; rep<n_reps; rep++ ) {
+		t0 = timing_now();
+		fn( rep+1 );
+		*(t+rep) = timing_now() - t0;
+		total += *(t+rep);
+		}
+	qsort( t, n_reps, sizeof(double), double_cmp );
+
+	r = result + n_results++;
+	r->kernel   = kernel;
+	r->variant  = variant;
+	r->min      = *t;
+	r->median   = *(t + (n_reps-1)/2);
+	r->mean     = total/(double)n_reps;
+	r->n_points = n_points;
+	free( t );
+
+	fprintf( stderr, "%-20s %-12s %10.3f ms\n", kernel, variant, 1000.0*r->median );
+}
+
+/*******************************************************************************/
+	static int
+bench_write_results( void )
+{
+	FILE		*f;
+	int		i;
+	BenchResult	*r;
+	double		rate;
+
+	if( (f = fopen( out_fname, "w" )) == NULL ) {
+		fprintf( stderr, "ncview_bench: can't open \"%s\" for writing\n", out_fname );
+		return( -1 );
+		}
+
+	if( want_json ) {
+		fprintf( f, "{\"program\":\"%s\",\n", PROGRAM_ID );
+		fprintf( f, " \"nx\":%ld,\"ny\":%ld,\"nt\":%ld,\"files\":%d,\"type\":\"%s\",\"packed\":%s,\"fill\":%g,\"mag\":%d,\"shrink\":%d,\"reps\":%d,\n",
+			(long)nx, (long)ny, (long)nt, n_files, bench_type_name( data_type ),
+			packed ? "true" : "false", fill_frac, mag, shrink, n_reps );
+		fprintf( f, " \"results\":[\n" );
+		}
+	else
+		fprintf( f, "kernel,variant,nx,ny,nt,files,type,packed,fill,reps,min_ms,median_ms,mean_ms,mpoints_per_s\n" );
+
+	for( i=0; i<n_results; i++ ) {
+		r    = result+i;
+		rate = (r->median > 0.0) ? 1.0e-6*r->n_points/r->median : 0.0;
+		if( want_json )
+			fprintf( f, "  {\"kernel\":\"%s\",\"variant\":\"%s\",\"min_ms\":%.4f,\"median_ms\":%.4f,\"mean_ms\":%.4f,\"mpoints_per_s\":%.2f}%s\n",
+				r->kernel, r->variant, 1000.0*r->min, 1000.0*r->median, 1000.0*r->mean, rate,
+				(i == n_results-1) ? "" : "," );
+		else
+			fprintf( f, "%s,%s,%ld,%ld,%ld,%d,%s,%d,%g,%d,%.4f,%.4f,%.4f,%.2f\n",
+				r->kernel, r->variant, (long)nx, (long)ny, (long)nt, n_files,
+				bench_type_name( data_type ), packed, fill_frac, n_reps,
+				1000.0*r->min, 1000.0*r->median, 1000.0*r->mean, rate );
+		}
+
+	if( want_json )
+		fprintf( f, " ]}\n" );
+	fclose( f );
+
+	fprintf( stderr, "results written to %s\n", out_fname );
+	return( 0 );
+}
+
+/*******************************************************************************/
+	static int
+double_cmp( const void *a, const void *b )
+{
+	double	da, db;
+
+	da = *(double *)a;
+	db = *(double *)b;
+	if( da < db )
+		return( -1 );
+	if( da > db )
+		return( 1 );
+	return( 0 );
+}
+
+/*******************************************************************************
+ * The routines being timed.  'rep' is 0 for the warm up call.
+ */
+	static void
+k_get_data( int rep )
+{
+	size_t	count[3];
+
+	*(bview.var_place+0) = rep % n_frames;
+	*(bview.var_place+1) = 0L;
+	*(bview.var_place+2) = 0L;
+	count[0] = 1L;
+	count[1] = ny;
+	count[2] = nx;
+	fi_get_data( var, bview.var_place, count, bview.data );
+}
+
+/* fi_get_data hands any read of more than one frame of a variable that
+ * is split across files to fi_get_data_iterate.
+ */
+	static void
+k_get_data_iterate( int rep )
+{
+	size_t	start[3], count[3];
+
+	start[0] = 0L;
+	start[1] = (rep*7L) % ny;
+	start[2] = (rep*13L) % nx;
+	count[0] = n_frames;
+	count[1] = 1L;
+	count[2] = 1L;
+	fi_get_data( var, start, count, series );
+}
+
+	static void
+k_min_max( int rep )
+{
+	init_min_max( var );
+}
+
+	static void
+k_expand( int rep )
+{
+	expand_data( work, &bview, 0L, 0L, nx*mag, ny*mag );
+}
+
+	static void
+k_contract( int rep )
+{
+	size_t	small_nx, small_ny;
+
+	view_get_scaled_size( options.blowup, nx, ny, &small_nx, &small_ny );
+	contract_data( work, &bview, var->fill_value, 0L, 0L, small_nx, small_ny );
+}
+
+	static void
+k_data_to_pixels( int rep )
+{
+	if( data_to_pixels( &bview ) < 0 ) {
+		fprintf( stderr, "ncview_bench: data_to_pixels failed\n" );
+		exit( -1 );
+		}
+}
+
+	static void
+k_tc_16( int rep )
+{
+	x_bench_tc_data( 16, bview.pixels, (long)nx, (long)ny, tc_buf );
+}
+
+	static void
+k_tc_24( int rep )
+{
+	x_bench_tc_data( 24, bview.pixels, (long)nx, (long)ny, tc_buf );
+}
+
+	static void
+k_tc_32( int rep )
+{
+	x_bench_tc_data( 32, bview.pixels, (long)nx, (long)ny, tc_buf );
+}
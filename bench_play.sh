@@ -0,0 +1,87 @@
+#!/bin/sh
+##	Playback benchmark: runs "ncview -bench_play" under a virtual
+##	X server (Xvfb) on data made by ncview_bench, for each field size
+##	and magnification, with and without saved frames, and collects the
+##	results into one CSV file.  "Without" turns off both the frame store
+##	and the server side frame pixmaps, so every frame is rendered.  Needs Xvfb, and ncview and ncview_bench
+##	The time per frame runs from the step to the frame until it has
+##	been read (on the worker thread, as in normal use) and drawn.
+##	to be built ("make ncview bench").  Run it with "make bench_play".
+##
+##	These can be set in the environment to change what is run:
+##
+##	SIZES	field sizes, as NXxNY		(default "360x180 720x360 1440x720")
+##	MAGS	magnifications			(default "1 2 -2")
+##	NT	frames in the data file		(default 24)
+##	FRAMES	frames to play each time	(default 96)
+##	OUT	where the results go		(default bench_play.csv)
+##	DISP	display number for Xvfb		(default 99)
+##
+SIZES=${SIZES:-"360x180 720x360 1440x720"}
+MAGS=${MAGS:-"1 2 -2"}
+NT=${NT:-24}
+FRAMES=${FRAMES:-96}
+OUT=${OUT:-bench_play.csv}
+DISP=${DISP:-99}
+
+for prog in ./ncview ./ncview_bench; do
+	if test ! -x $prog; then
+		echo "bench_play.sh: $prog has not been built; run \"make ncview bench\" first" 1>&2
+		exit 1
+	fi
+done
+if ! command -v Xvfb > /dev/null 2>&1; then
+	echo "bench_play.sh: Xvfb is needed, but is not on the path" 1>&2
+	exit 1
+fi
+
+## Stop anything this script started, however it ends
+DATADIR=`mktemp -d ${TMPDIR:-/tmp}/ncview_bench_play.XXXXXX`
+XVFB_PID=
+cleanup() {
+	if test -n "$XVFB_PID"; then kill $XVFB_PID 2> /dev/null; fi
+	rm -rf $DATADIR
+}
+trap cleanup 0 1 2 15
+
+## A fixed screen size, depth, and font path keep runs comparable
+Xvfb :$DISP -screen 0 1920x1200x24 -nolisten tcp > $DATADIR/xvfb.log 2>&1 &
+XVFB_PID=$!
+sleep 2
+if ! kill -0 $XVFB_PID 2> /dev/null; then
+	echo "bench_play.sh: Xvfb did not start; see below" 1>&2
+	cat $DATADIR/xvfb.log 1>&2
+	exit 1
+fi
+
+echo "variable,nx,ny,mag,save_frames,frames,seconds,fps,p50_ms,p95_ms,p99_ms,max_ms,peak_rss_kb" > $OUT
+
+for size in $SIZES; do
+	nx=`echo $size | sed 's/x.*//'`
+	ny=`echo $size | sed 's/.*x//'`
+	files=`./ncview_bench -make_only -dir $DATADIR -nx $nx -ny $ny -nt $NT 2> /dev/null`
+	if test -z "$files"; then
+		echo "bench_play.sh: could not make the $size data file" 1>&2
+		exit 1
+	fi
+	for mag in $MAGS; do
+		for save in on off; do
+			if test $save = on; then
+				saveopt=
+			else
+				saveopt="-no_saveframes -pixmap_mem 0"
+			fi
+			line=`DISPLAY=:$DISP ./ncview -bench_play $FRAMES -bench_mag $mag $saveopt $files 2> $DATADIR/ncview.log | grep '^bench_play,'`
+			if test -z "$line"; then
+				echo "bench_play.sh: ncview failed on $size, magnification $mag, saved frames $save:" 1>&2
+				tail -5 $DATADIR/ncview.log 1>&2
+				continue
+			fi
+			echo "$line" | sed 's/^bench_play,//' >> $OUT
+			echo "$size mag $mag save_frames $save: `echo $line | cut -d, -f9` fps"
+		done
+	done
+	rm -f $files
+done
+
+echo "results written to $OUT"
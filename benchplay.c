@@ -0,0 +1,188 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2008 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrean
+ * San Diego, CA   92122
+ * pierce@cirrus.ucsd.edu
+ */
+
+/*******************************************************************************
+ * 	benchplay.c
+ *
+ *	The -bench_play option: once the windows are up, selects the first
+ *	variable and plays it forwards for the asked for number of frames,
+ *	through the same animation timer, event loop, and drawing code that
+ *	the "forward" button uses, but with no delay between frames.  As
+ *	when ncview is used, frames are read on the worker thread.  Each
+ *	frame is waited for until it has been read and the X server has
+ *	finished drawing it, so the times include the reading and the 
+ *	server's share.  Then the frame rate, the
+ *	percentiles of the time per frame, and the peak memory use are
+ *	printed, and ncview exits.  bench_play.sh runs this under Xvfb for
+ *	a range of field sizes and magnifications.
+ *******************************************************************************/
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#include <sys/resource.h>
+
+extern Options	options;
+extern NCVar	*variables;
+
+static NCVar	*var;
+static double	*latency, t_start, t_step;
+static long	n_played = 0L;
+static int	stepped = FALSE;
+
+static Boolean	bench_play_begin( XtPointer client_data );
+static void	bench_play_step( XtPointer client_data, XtIntervalId *id );
+static void	bench_play_report( double elapsed );
+static int	double_cmp( const void *a, const void *b );
+
+/*******************************************************************************
+ * Called from main() just before the event loop starts; the playing itself
+ * only starts once the startup events have been handled.
+ */
+	void
+bench_play_init( void )
+{
+	latency = (double *)malloc( options.bench_play*sizeof(double) );
+	if( latency == NULL ) {
+		fprintf( stderr, "ncview: bench_play_init: failed on malloc of %ld times\n",
+			options.bench_play );
+		exit( -1 );
+		}
+	in_work_proc_set( bench_play_begin, NULL );
+}
+
+/*******************************************************************************/
+	static Boolean
+bench_play_begin( XtPointer client_data )
+{
+	var = variables;
+	if( var->effective_dimensionality < 3 ) {
+		fprintf( stderr, "ncview: -bench_play: variable %s has no dimension to play along\n",
+			var->name );
+		exit( -1 );
+		}
+
+	in_indicate_active_var( var->name );
+	if( set_scan_variable( var ) < 0 ) {
+		fprintf( stderr, "ncview: -bench_play: can't show variable %s\n", var->name );
+		exit( -1 );
+		}
+
+	/* Step to the magnification one at a time, the same as the M button */
+	if( options.bench_mag != 0 ) {
+		while( options.blowup < options.bench_mag )
+			view_change_blowup( 1, FALSE );
+		while( options.blowup > options.bench_mag )
+			view_change_blowup( -1, FALSE );
+		view_change_blowup( 0, TRUE );
+		}
+
+	/* The range scan runs on the worker; it isn't part of playing */
+	while( ! worker_idle() )
+		in_process_event();
+
+	in_sync();
+	t_start = timing_now();
+	in_timer_set( bench_play_step, NULL );
+
+	return( True );
+}
+
+/*******************************************************************************
+ * A frame that has to be read from the file is read on the worker thread and
+ * drawn when it comes in, after change_view has returned.  Until then the
+ * animation timer is held, so this isn't called again until the frame is up;
+ * the time for a frame is from the step that asked for it to the next step.
+ */
+	static void
+bench_play_step( XtPointer client_data, XtIntervalId *id )
+{
+	double	now;
+
+	in_sync();
+	now = timing_now();
+	if( stepped )
+		*(latency + n_played++) = now - t_step;
+
+	if( n_played == options.bench_play ) {
+		bench_play_report( now - t_start );
+		exit( 0 );
+		}
+
+	t_step  = now;
+	stepped = TRUE;
+	change_view( 1, FRAMES );
+	in_timer_set( bench_play_step, NULL );
+}
+
+/*******************************************************************************
+ * The result goes to stdout as one comma separated line that starts with
+ * "bench_play,", so that scripts can pick it out; see bench_play.sh for the
+ * names of the fields.  A more readable version goes to stderr.
+ */
+	static void
+bench_play_report( double elapsed )
+{
+	struct rusage	usage;
+	long		n, nx, ny;
+	double		fps, p50, p95, p99, max;
+
+	n = n_played;
+	qsort( latency, n, sizeof(double), double_cmp );
+	p50 = 1000.0 * *(latency + (n-1)/2);
+	p95 = 1000.0 * *(latency + (long)(0.95*(double)(n-1)));
+	p99 = 1000.0 * *(latency + (long)(0.99*(double)(n-1)));
+	max = 1000.0 * *(latency + n-1);
+	fps = (elapsed > 0.0) ? (double)n/elapsed : 0.0;
+
+	getrusage( RUSAGE_SELF, &usage );
+
+	nx = (long)*(var->size + var->n_dims-1);
+	ny = (long)*(var->size + var->n_dims-2);
+
+	printf( "bench_play,%s,%ld,%ld,%d,%d,%ld,%.3f,%.2f,%.3f,%.3f,%.3f,%.3f,%ld\n",
+		var->name, nx, ny, options.blowup, options.save_frames, n, elapsed, fps,
+		p50, p95, p99, max, (long)usage.ru_maxrss );
+	fflush( stdout );
+
+	fprintf( stderr, "ncview: played %ld frames of %s (%ld x %ld, magnification %d, saved frames %s)\n",
+		n, var->name, nx, ny, options.blowup, options.save_frames ? "on" : "off" );
+	fprintf( stderr, "ncview: %.2f frames/sec; ms per frame: median %.3f, 95%% %.3f, 99%% %.3f, max %.3f; peak RSS %ld KB\n",
+		fps, p50, p95, p99, max, (long)usage.ru_maxrss );
+}
+
+/*******************************************************************************/
+	static int
+double_cmp( const void *a, const void *b )
+{
+	double	da, db;
+
+	da = *(double *)a;
+	db = *(double *)b;
+	if( da < db )
+		return( -1 );
+	if( da > db )
+		return( 1 );
+	return( 0 );
+}
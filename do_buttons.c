@@ -42,6 +42,8 @@ do_range( int modifier )
 	init_saveframes();
 	if( modifier == MOD_3 )
 		view_set_range_frame();
+	else if( modifier == MOD_2 )
+		view_toggle_range_mode();
 	else
 		view_set_range();
 }
@@ -65,6 +67,9 @@ do_restart( int modifier )
 	void
 do_rewind( int modifier )
 {
+	int	n_frames;
+
+	n_frames = in_timer_frame_advance();
 	in_timer_clear();
 
 	if( modifier == MOD_2 ) {
@@ -73,7 +78,7 @@ do_rewind( int modifier )
 		}
 	else
 		{
-		change_view( -1, FRAMES );
+		change_view( -n_frames, FRAMES );
 		in_timer_set( do_rewind, (XtPointer)(MOD_1) );
 		}
 }
@@ -116,6 +121,9 @@ do_forward( int modifier )
 	void
 do_fastforward( int modifier )
 {
+	int	n_frames;
+
+	n_frames = in_timer_frame_advance();
 	in_timer_clear();
 
 	if( modifier == MOD_2 ) {
@@ -124,7 +132,7 @@ do_fastforward( int modifier )
 		}
 	else
 		{
-		if( change_view( 1, FRAMES ) == 0 )
+		if( change_view( n_frames, FRAMES ) == 0 )
 			in_timer_set( do_fastforward, (XtPointer)(MOD_1) );
 		}
 }
@@ -48,15 +48,35 @@
 
 #define	ID_FONT_SIZE_SCALE	0.7	/* How much smaller ID font size is than regular */
 
+#define PS_ENC_BUFSIZE		65536	/* Encoded image data is written in chunks this big */
+#define PS_ENC_LINE_LEN		76
+
+/* RunLength then ASCII85 encoding of the image data */
+typedef struct {
+	FILE		*f;
+	unsigned char	tuple[4];
+	int		n_tuple, line_len;
+	size_t		n_buf;
+	char		buf[PS_ENC_BUFSIZE];
+} PSEncoder;
+
 extern View 	*view;
 extern Options 	options;
 
 static PrintOptions printopts;
+static PSEncoder    ps_enc;
 
 static void print_header( FILE *out_file, float scale, size_t x, size_t y, size_t top_of_image );
 static void calc_scale( float *scale, size_t x, size_t y );
 static void set_font( FILE *outf, char *name, int size );
 static void do_outline( FILE *f, size_t x, size_t y );
+static void print_image( FILE *f, size_t x_size, size_t y_size, size_t scaled_x_size, 
+			size_t scaled_y_size );
+static void ps_encode_image( FILE *f, ncv_pixel *pixels, size_t n );
+static void ps_enc_byte( PSEncoder *e, unsigned char c );
+static void ps_enc_tuple( PSEncoder *e, int n_bytes );
+static void ps_enc_char( PSEncoder *e, char c );
+static void ps_enc_flush( PSEncoder *e );
 static void print_other_info( FILE *out_file, float output_scale, size_t x_size, size_t y_size, 
 			size_t center_x, size_t center_y, size_t top_of_image, size_t bot_of_image );
 
@@ -96,15 +116,12 @@ print_init( void )
 	void
 do_print( void )
 {
-	long	i, j;
 	size_t	x_size, y_size, scaled_x_size, scaled_y_size, top_of_image, bot_of_image, 
 		center_x, center_y, left_of_image, right_of_image;
 	char	outfname[1024], tstr[1500];
 	int     outfid;
 	FILE	*outf;
 	float	output_scale;
-	int	r, g, b, n_print;
-	ncv_pixel pix;
 
 #ifdef DEBUG
 	fprintf( stderr, "entering do_print()\n" );
@@ -161,21 +178,8 @@ do_print( void )
 
 	/***** dump out the color image *****/
 	if( ! printopts.test_only ) {
-		view_draw( FALSE ); /* Don't allow saveframes -- force reload of image data */
-		n_print = 0;
-		for( j=0; j<scaled_y_size; j++ ) {
-			for( i=0; i<scaled_x_size; i++ ) {
-				pix = *(view->pixels + j*scaled_x_size + i);
-				pix_to_rgb( pix, &r, &g, &b );
-				fprintf( outf, "%02x%02x%02x", (r>>8), (g>>8), (b>>8)); 
-				n_print += 6;
-				if( n_print > 70 ) {
-					fprintf( outf, "\n" );
-					n_print = 0;
-					}
-				}
-			}
-		fprintf( outf, "\n\n" );
+		view_draw_all_pixels(); /* Don't allow saveframes -- force reload of image data */
+		print_image( outf, x_size, y_size, scaled_x_size, scaled_y_size );
 		}
 	
 	/* Outline the color contour with lines */
@@ -206,7 +210,7 @@ print_other_info( FILE *outf, float output_scale, size_t x_size, size_t y_size,
 	FDBlist	*fdb;
 	NCDim	*d;
 	int	i, type, has_bounds;
-	size_t	*actual_place;
+	size_t	actual_place[MAX_VAR_DIMS];
 	time_t	sec_since_1970;
 	double	temp_double, bound_min, bound_max;
 
@@ -291,8 +295,12 @@ print_other_info( FILE *outf, float output_scale, size_t x_size, size_t y_size,
 			}
 
 		/*** Range of data ***/
-		sprintf( tstr, "Range of %s: %g to %g %s", main_long_name, 
-			view->variable->user_min, view->variable->user_max, main_units );
+		if( (options.range_mode == RANGE_MODE_FRAME) && view->have_frame_range )
+			sprintf( tstr, "Range of %s in this frame: %g to %g %s", main_long_name, 
+				view->frame_min, view->frame_max, main_units );
+		else
+			sprintf( tstr, "Range of %s: %g to %g %s", main_long_name, 
+				view->variable->user_min, view->variable->user_max, main_units );
 		fprintf( outf, "gsave (%s) show grestore\n", tstr );
 		fprintf( outf, "0 %d rmoveto\n", -(printopts.leading+printopts.font_size) );
 
@@ -347,7 +355,6 @@ print_other_info( FILE *outf, float output_scale, size_t x_size, size_t y_size,
 			
 		/*** Name of file ***/
 		tstr[0] = '\0';
-		actual_place = (size_t *)malloc( sizeof(size_t)*20 );
 		virt_to_actual_place( view->variable, view->var_place, actual_place, &fdb );
 		if( (fi_recdim_id( view->variable->first_file->id ) != view->x_axis_id ) &&
 		    (fi_recdim_id( view->variable->first_file->id ) != view->y_axis_id)) 
@@ -429,7 +436,7 @@ do_outline( FILE *f, size_t x, size_t y )
 print_header( FILE *f, float scale, size_t x, size_t y, size_t top_of_image )
 {
 	fprintf( f, "%%!\n" );
-	fprintf( f, "/picstr %ld string def\n", x*3 );
+	fprintf( f, "%% The image needs PostScript Level 2\n" );
 	fprintf( f, "gsave\n" );
 
 	/* This sets the position of the output image on the page */
@@ -451,13 +458,195 @@ print_header( FILE *f, float scale, size_t x, size_t y, size_t top_of_image )
 		fprintf( f, "%ld 0 lineto\n", x );
 		fprintf( f, "closepath stroke\n" );
 		}
-	else
-		{
-		fprintf( f, "%ld %ld 8\n", x, y );
-		fprintf( f, "[1 0 0 -1 0 1]\n" );
-		fprintf( f, "{currentfile picstr readhexstring pop}\n" );
-		fprintf( f, "false 3\n" );
-		fprintf( f, "colorimage\n\n" );
+}
+
+/*************************************************************************
+ * Put out the image as 8-bit pixel values in an Indexed color space that
+ * holds just the colors used, RunLength encoded and then wrapped in 
+ * ASCII85.  When the view is magnified by replicating pixels, the 
+ * unmagnified image is written and the PostScript transform does the 
+ * magnifying.  Bilinear magnification makes new pixel values, and shrunk
+ * views are already small, so those are written as they are drawn.
+ */
+	static void
+print_image( FILE *f, size_t x_size, size_t y_size, size_t scaled_x_size, size_t scaled_y_size )
+{
+	ncv_pixel *pixels, *saved_pixels, max_pix;
+	size_t	nx, ny, i;
+	int	mag, saved_blowup, r, g, b, err;
+
+	pixels = view->pixels;
+	nx     = scaled_x_size;
+	ny     = scaled_y_size;
+	mag    = 1;
+
+	if( (options.blowup > 1) && (options.blowup_type == BLOWUP_REPLICATE) &&
+	    ((pixels = (ncv_pixel *)malloc( x_size*y_size*sizeof(ncv_pixel) )) != NULL) ) {
+		saved_pixels   = view->pixels;
+		saved_blowup   = options.blowup;
+		view->pixels   = pixels;
+		options.blowup = 1;
+		err = data_to_pixels( view );
+		view->pixels   = saved_pixels;
+		options.blowup = saved_blowup;
+
+		if( err < 0 ) {
+			free( pixels );
+			pixels = view->pixels;
+			}
+		else
+			{
+			nx  = x_size;
+			ny  = y_size;
+			mag = saved_blowup;
+			}
+		}
+	if( pixels == NULL )	/* couldn't get the memory, so print it as drawn */
+		pixels = view->pixels;
+
+	max_pix = 0;
+	for( i=0; i<nx*ny; i++ )
+		if( *(pixels+i) > max_pix )
+			max_pix = *(pixels+i);
+
+	fprintf( f, "gsave\n" );
+	if( mag > 1 )
+		fprintf( f, "%d %d scale\n", mag, mag );
+	fprintf( f, "[/Indexed /DeviceRGB %d\n<", (int)max_pix );
+	for( i=0; i<=max_pix; i++ ) {
+		pix_to_rgb( (ncv_pixel)i, &r, &g, &b );
+		fprintf( f, "%02x%02x%02x", (r>>8), (g>>8), (b>>8) );
+		if( (i % 12) == 11 )
+			fprintf( f, "\n" );
+		}
+	fprintf( f, ">] setcolorspace\n" );
+	fprintf( f, "<< /ImageType 1 /Width %ld /Height %ld /BitsPerComponent 8\n", (long)nx, (long)ny );
+	fprintf( f, "   /Decode [0 255] /ImageMatrix [1 0 0 -1 0 0]\n" );
+	fprintf( f, "   /DataSource currentfile /ASCII85Decode filter /RunLengthDecode filter\n" );
+	fprintf( f, ">> image\n" );
+	ps_encode_image( f, pixels, nx*ny );
+	fprintf( f, "\ngrestore\n\n" );
+
+	if( pixels != view->pixels )
+		free( pixels );
+}
+
+/*************************************************************************
+ * RunLength encode the pixels, as RunLengthDecode wants them: a length
+ * byte n < 128 is followed by n+1 literal bytes, n > 128 by one byte to
+ * be repeated 257-n times, and 128 ends the data.  The result goes 
+ * through the ASCII85 encoder.
+ */
+	static void
+ps_encode_image( FILE *f, ncv_pixel *pixels, size_t n )
+{
+	PSEncoder *e;
+	size_t	i, run, start, k;
+
+	e           = &ps_enc;
+	e->f        = f;
+	e->n_tuple  = 0;
+	e->line_len = 0;
+	e->n_buf    = 0L;
+
+	i = 0L;
+	while( i < n ) {
+		run = 1L;
+		while( (i+run < n) && (run < 128) && (*(pixels+i+run) == *(pixels+i)) )
+			run++;
+
+		if( run > 1 ) {
+			ps_enc_byte( e, (unsigned char)(257-run) );
+			ps_enc_byte( e, *(pixels+i) );
+			i += run;
+			}
+		else
+			{
+			/* Literals, up to where the next run starts */
+			start = i++;
+			while( (i < n) && (i-start < 128) && 
+			       (! ((i+1 < n) && (*(pixels+i) == *(pixels+i+1)))) )
+				i++;
+			ps_enc_byte( e, (unsigned char)(i-start-1) );
+			for( k=start; k<i; k++ )
+				ps_enc_byte( e, *(pixels+k) );
+			}
+		}
+	ps_enc_byte( e, 128 );
+
+	/* A partial last group of n bytes is padded with zeros, and only
+	 * its first n+1 characters are written.
+	 */
+	if( e->n_tuple > 0 ) {
+		for( k=e->n_tuple; k<4; k++ )
+			e->tuple[k] = 0;
+		ps_enc_tuple( e, e->n_tuple );
+		}
+	/* The end marker can't be split across lines */
+	if( e->n_buf + 2 > PS_ENC_BUFSIZE )
+		ps_enc_flush( e );
+	e->buf[e->n_buf++] = '~';
+	e->buf[e->n_buf++] = '>';
+	ps_enc_flush( e );
+}
+
+/*************************************************************************/
+	static void
+ps_enc_byte( PSEncoder *e, unsigned char c )
+{
+	e->tuple[e->n_tuple++] = c;
+	if( e->n_tuple == 4 ) {
+		ps_enc_tuple( e, 4 );
+		e->n_tuple = 0;
+		}
+}
+
+/*************************************************************************
+ * Write the ASCII85 characters for the first n_bytes bytes of the tuple
+ */
+	static void
+ps_enc_tuple( PSEncoder *e, int n_bytes )
+{
+	unsigned long	v;
+	char		c[5];
+	int		k;
+
+	v = ((unsigned long)e->tuple[0] << 24) | ((unsigned long)e->tuple[1] << 16) |
+	    ((unsigned long)e->tuple[2] << 8)  |  (unsigned long)e->tuple[3];
+
+	if( (v == 0L) && (n_bytes == 4) ) {
+		ps_enc_char( e, 'z' );
+		return;
 		}
+
+	for( k=4; k>=0; k-- ) {
+		c[k] = (char)('!' + (v % 85L));
+		v /= 85L;
+		}
+	for( k=0; k<=n_bytes; k++ )
+		ps_enc_char( e, c[k] );
+}
+
+/*************************************************************************/
+	static void
+ps_enc_char( PSEncoder *e, char c )
+{
+	if( e->n_buf + 2 > PS_ENC_BUFSIZE )
+		ps_enc_flush( e );
+
+	e->buf[e->n_buf++] = c;
+	if( ++e->line_len == PS_ENC_LINE_LEN ) {
+		e->buf[e->n_buf++] = '\n';
+		e->line_len = 0;
+		}
+}
+
+/*************************************************************************/
+	static void
+ps_enc_flush( PSEncoder *e )
+{
+	if( e->n_buf > 0 )
+		fwrite( e->buf, 1, e->n_buf, e->f );
+	e->n_buf = 0L;
 }
 
@@ -35,11 +35,29 @@
 #include "ncview.defines.h"
 #include "ncview.protos.h"
 
+#ifdef INC_UDUNITS
+#include "utCalendar_cal.h"
+#endif
+
+#include <pthread.h>
+
 static int   file_type;
 extern NCVar *variables;
 extern Options options;
 
+/* The netCDF library is not thread safe, so every call into it goes
+ * through fi_lock/fi_unlock.  It is recursive so that the fi_ routines
+ * can call each other, and so that code outside this file can hold it
+ * across several calls.
+ */
+static pthread_mutex_t	file_lock;
+static pthread_once_t	file_lock_once = PTHREAD_ONCE_INIT;
+static void		file_lock_init( void );
+
 static void fi_get_data_iterate( NCVar *var, size_t *virt_start_pos, size_t *count, void *data );
+#ifdef INC_UDUNITS
+static void fi_recdim_conversion( FDBlist *file, NCVar *var, NCDim *d );
+#endif
 
 /************************************************************************************/
 /* return TRUE if passed the name of a file which these routines were designed
@@ -48,7 +66,12 @@ static void fi_get_data_iterate( NCVar *var, size_t *virt_start_pos, size_t *cou
 	int
 fi_confirm( char *name )
 {
-	return( netcdf_fi_confirm( name ));
+	int	ret_val;
+
+	fi_lock();
+	ret_val = netcdf_fi_confirm( name );
+	fi_unlock();
+	return( ret_val );
 }
 
 /************************************************************************************/
@@ -58,13 +81,18 @@ fi_confirm( char *name )
 	int
 fi_writable( char *name )
 {
+	int	ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF )
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_writable: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_fi_writable( name ));
+	fi_lock();
+	ret_val = netcdf_fi_writable( name );
+	fi_unlock();
+	return( ret_val );
 }
 
 /************************************************************************************/
@@ -79,11 +107,14 @@ fi_initialize( char *name, int nfiles )
 {
 	int	id;
 	Stringlist *var_list;
+	double	t0;
 
 	if( file_type == FILE_TYPE_NETCDF ) {
 		if( options.debug ) 
 			fprintf( stderr, "Initializing file %s\n", name );
+		fi_lock();
 		id = netcdf_fi_initialize( name );
+		fi_unlock();
 		}
 	else
 		{
@@ -94,8 +125,10 @@ fi_initialize( char *name, int nfiles )
 
 	if( options.debug ) 
 		fprintf( stderr, "Getting list of variables for file %s\n", name );
+	TIMING_BEGIN( t0 );
 	var_list = fi_list_vars( id );
 	add_vars_to_list( var_list, id, name, nfiles );
+	TIMING_END( TIMING_VAR_SCAN, t0 );
 	
 	if( options.debug ) 
 		fprintf( stderr, "Done initializing file %s\n", name );
@@ -114,13 +147,18 @@ fi_initialize( char *name, int nfiles )
 	Stringlist *
 fi_list_vars( int fileid )
 {
+	Stringlist	*ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF )
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_list_vars: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_fi_list_vars( fileid ));
+	fi_lock();
+	ret_val = netcdf_fi_list_vars( fileid );
+	fi_unlock();
+	return( ret_val );
 }
 
 /************************************************************************************
@@ -129,13 +167,18 @@ fi_list_vars( int fileid )
 	char *
 fi_title( int fileid )
 {
+	char	*ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF )
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_title: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_title( fileid ));
+	fi_lock();
+	ret_val = netcdf_title( fileid );
+	fi_unlock();
+	return( ret_val );
 }
 
 /************************************************************************************
@@ -144,13 +187,18 @@ fi_title( int fileid )
 	char *
 fi_long_var_name( int fileid, char *var_name )
 {
+	char	*ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF )
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_title: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_long_var_name( fileid, var_name ));
+	fi_lock();
+	ret_val = netcdf_long_var_name( fileid, var_name );
+	fi_unlock();
+	return( ret_val );
 }
 
 /************************************************************************************
@@ -159,13 +207,18 @@ fi_long_var_name( int fileid, char *var_name )
 	char *
 fi_var_units( int fileid, char *var_name )
 {
+	char	*ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF )
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_var_units: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_var_units( fileid, var_name ));
+	fi_lock();
+	ret_val = netcdf_var_units( fileid, var_name );
+	fi_unlock();
+	return( ret_val );
 }
 
 /************************************************************************************
@@ -174,6 +227,8 @@ fi_var_units( int fileid, char *var_name )
 	char *
 fi_dim_calendar( int fileid, char *dim_name )
 {
+	char	*ret_val;
+
 	/* Command line specified calendar OVERRIDES info in the file */
 	if( options.calendar != NULL )
 		return( options.calendar );
@@ -184,7 +239,10 @@ fi_dim_calendar( int fileid, char *dim_name )
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_dim_calendar( fileid, dim_name ));
+	fi_lock();
+	ret_val = netcdf_dim_calendar( fileid, dim_name );
+	fi_unlock();
+	return( ret_val );
 }
 
 /************************************************************************************
@@ -193,13 +251,18 @@ fi_dim_calendar( int fileid, char *dim_name )
 	char *
 fi_dim_units( int fileid, char *dim_name )
 {
+	char	*ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF )
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_dim_units: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_dim_units( fileid, dim_name ));
+	fi_lock();
+	ret_val = netcdf_dim_units( fileid, dim_name );
+	fi_unlock();
+	return( ret_val );
 }
 
 /************************************************************************************/
@@ -210,13 +273,18 @@ fi_dim_units( int fileid, char *dim_name )
 	int
 fi_n_dims( int id, char *var_name )
 {
+	int	ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF )
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_n_dims: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_fi_n_dims( id, var_name ));
+	fi_lock();
+	ret_val = netcdf_fi_n_dims( id, var_name );
+	fi_unlock();
+	return( ret_val );
 }
 
 /***********************************************************************************
@@ -228,13 +296,18 @@ fi_n_dims( int id, char *var_name )
 	Stringlist *
 fi_scannable_dims( int fileid, char *var_name )
 {
+	Stringlist	*ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF )
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_scannable_dims: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_scannable_dims( fileid, var_name ));
+	fi_lock();
+	ret_val = netcdf_scannable_dims( fileid, var_name );
+	fi_unlock();
+	return( ret_val );
 }
 
 /************************************************************************************
@@ -245,13 +318,18 @@ fi_scannable_dims( int fileid, char *var_name )
 	size_t *
 fi_var_size( int fileid, char *var_name )
 {
+	size_t	*ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF )
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_var_size: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_fi_var_size( fileid, var_name ));
+	fi_lock();
+	ret_val = netcdf_fi_var_size( fileid, var_name );
+	fi_unlock();
+	return( ret_val );
 }
 
 /************************************************************************************
@@ -262,13 +340,18 @@ fi_var_size( int fileid, char *var_name )
 	char *
 fi_dim_id_to_name( int fileid, char *var_name, int dim_id )
 {
+	char	*ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF )
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_dim_id_to_name: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_dim_id_to_name( fileid, var_name, dim_id ));
+	fi_lock();
+	ret_val = netcdf_dim_id_to_name( fileid, var_name, dim_id );
+	fi_unlock();
+	return( ret_val );
 }
 
 /************************************************************************************
@@ -280,12 +363,17 @@ fi_dim_id_to_name( int fileid, char *var_name, int dim_id )
 	int
 fi_dim_name_to_id( int fileid, char *var_name, char *dim_name )
 {
+	int	ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF ) {
 		fprintf( stderr, "?unknown file_type passed to fi_var_size: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_dim_name_to_id( fileid, var_name, dim_name ));
+	fi_lock();
+	ret_val = netcdf_dim_name_to_id( fileid, var_name, dim_name );
+	fi_unlock();
+	return( ret_val );
 }
 
 /************************************************************************************/
@@ -304,7 +392,7 @@ fi_dim_name_to_id( int fileid, char *var_name, char *dim_name )
 	void
 fi_get_data( NCVar *var, size_t *virt_start_pos, size_t *count, void *data )
 {
-	size_t	*act_start_pos;
+	size_t	act_start_pos[MAX_VAR_DIMS];
 	FDBlist	*file;
 
 	/* Check to see if we should loop over the timelike indices
@@ -314,25 +402,55 @@ fi_get_data( NCVar *var, size_t *virt_start_pos, size_t *count, void *data )
 		return;
 		}
 		
-	act_start_pos = (size_t *)malloc(var->n_dims * sizeof(size_t));
-	if( act_start_pos == NULL ) {
-		fprintf( stderr, "error allocating space for act_start_pos\n" );
-		fprintf( stderr, "in routine fi_get_data\n" );
-		exit( -1 );
-		}
 	virt_to_actual_place( var, virt_start_pos, act_start_pos, &file );
 
-	if( file_type == FILE_TYPE_NETCDF )
+	if( file_type == FILE_TYPE_NETCDF ) {
+		fi_lock();
 		netcdf_fi_get_data( file->id, var->name, act_start_pos, 
 			  count, data, (NetCDFOptions *)var->first_file->aux_data );
+		fi_unlock();
+		}
 	else
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_get_data: %d\n",
 			file_type );
 		exit( -1 );
 		}
+}
+
+/*****************************************************************************
+ * Like fi_get_data, but only every stride[i]'th point along each dimension
+ * is read, and count[i] is the number of points to read along it.  This is
+ * used to get a quick low resolution look at a large field.  Returns 0 on
+ * success, or -1 if the read would have to span more than one file (the
+ * caller should then use fi_get_data).
+ */
+	int
+fi_get_data_strided( NCVar *var, size_t *virt_start_pos, size_t *count, ptrdiff_t *stride, 
+		void *data )
+{
+	size_t	act_start_pos[MAX_VAR_DIMS];
+	FDBlist	*file;
+
+	if( (var->is_virtual == TRUE) && (count[0] > 1) )
+		return( -1 );
+		
+	virt_to_actual_place( var, virt_start_pos, act_start_pos, &file );
+
+	if( file_type == FILE_TYPE_NETCDF ) {
+		fi_lock();
+		netcdf_fi_get_data_strided( file->id, var->name, act_start_pos, 
+			  count, stride, data, (NetCDFOptions *)var->first_file->aux_data );
+		fi_unlock();
+		}
+	else
+		{
+		fprintf( stderr, "?unknown file_type passed to fi_get_data_strided: %d\n",
+			file_type );
+		exit( -1 );
+		}
 
-	free( act_start_pos );
+	return( 0 );
 }
 
 /*****************************************************************************
@@ -342,17 +460,10 @@ fi_get_data( NCVar *var, size_t *virt_start_pos, size_t *count, void *data )
 	void
 fi_get_data_iterate( NCVar *var, size_t *virt_start_pos, size_t *count, void *data )
 {
-	size_t	it, *act_start_pos, start2[20], count2[20], prod_lower_dims;
+	size_t	it, act_start_pos[MAX_VAR_DIMS], start2[MAX_VAR_DIMS], count2[MAX_VAR_DIMS], prod_lower_dims;
 	FDBlist	*file;
 	int	i;
 
-	act_start_pos = (size_t *)malloc(var->n_dims * sizeof(size_t));
-	if( act_start_pos == NULL ) {
-		fprintf( stderr, "error allocating space for act_start_pos\n" );
-		fprintf( stderr, "in routine fi_get_data\n" );
-		exit( -1 );
-		}
-
 	prod_lower_dims = 1L;
 	for( i=1; i<var->n_dims; i++ ) {
 		start2[i] = virt_start_pos[i];
@@ -364,10 +475,13 @@ fi_get_data_iterate( NCVar *var, size_t *virt_start_pos, size_t *count, void *da
 	for( it=virt_start_pos[0]; it<(virt_start_pos[0]+count[0]); it++ ) {
 		start2[0] = it;
 		virt_to_actual_place( var, start2, act_start_pos, &file );
-		if( file_type == FILE_TYPE_NETCDF )
+		if( file_type == FILE_TYPE_NETCDF ) {
+			fi_lock();
 			netcdf_fi_get_data( file->id, var->name, act_start_pos, 
 				  count2, ((float *)data)+it*prod_lower_dims, 
 				  	(NetCDFOptions *)var->first_file->aux_data );
+			fi_unlock();
+			}
 		else
 			{
 			fprintf( stderr, "?unknown file_type passed to fi_get_data: %d\n",
@@ -375,8 +489,6 @@ fi_get_data_iterate( NCVar *var, size_t *virt_start_pos, size_t *count, void *da
 			exit( -1 );
 			}
 		}
-
-	free( act_start_pos );
 }
 
 /************************************************************************************
@@ -385,8 +497,11 @@ fi_get_data_iterate( NCVar *var, size_t *virt_start_pos, size_t *count, void *da
 	void
 fi_close( int fileid )
 {
-	if( file_type == FILE_TYPE_NETCDF )
+	if( file_type == FILE_TYPE_NETCDF ) {
+		fi_lock();
 		netcdf_fi_close( fileid );
+		fi_unlock();
+		}
 	else
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_close: %d\n",
@@ -401,13 +516,18 @@ fi_close( int fileid )
 	char *
 fi_dim_longname( int fileid, char *dim_name )
 {
+	char	*ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF )
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_has_dim_values: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_dim_longname( fileid, dim_name ) );
+	fi_lock();
+	ret_val = netcdf_dim_longname( fileid, dim_name );
+	fi_unlock();
+	return( ret_val );
 }
 
 /**************************************************************************************
@@ -418,20 +538,18 @@ void fi_dim_value_convert( double *dimval, FDBlist *file, NCVar *var, NCDim *d )
 #ifdef INC_UDUNITS
 	double converted_dimval;
 	int	year0, month0, hour0, min0, day0, err;
-	int	year1, month1, hour1, min1, day1;
-	double	sec0, sec1, converted_return_value;
+	float	sec0;
 
-	if( (file->recdim_units 	   == NULL) ||
-	    (var->first_file->recdim_units == NULL) ||
-	    (var->first_file->udunits 	   == NULL) ||
-	    (file->udunits 		   == NULL) ||
-	    (! d->timelike )                        ||
-	    (strcmp(file->recdim_units,var->first_file->recdim_units) == 0) ) 
-	    	return;
-/*	    
-printf( "different units encountered: converting recdim value of %lf from %s to %s\n",
-	*dimval, file->recdim_units, var->first_file->recdim_units );
-*/
+	if( file->recdim_conv == RECDIM_CONV_UNKNOWN )
+		fi_recdim_conversion( file, var, d );
+
+	if( file->recdim_conv == RECDIM_CONV_AFFINE ) {
+		*dimval = *dimval * file->recdim_scale + file->recdim_offset;
+		return;
+		}
+
+	if( (file->recdim_conv != RECDIM_CONV_CALENDAR) || (! d->timelike) )
+		return;
 
 	/* Convert the dim value to a date using the units given 
 	 * in the file that this dim value came from
@@ -442,28 +560,69 @@ printf( "different units encountered: converting recdim value of %lf from %s to
 		err = utInvCalendar_cal( year0, month0, day0, hour0, min0, sec0, 
 			var->first_file->udunits, &converted_dimval,
 			d->calendar );
-		if( err == 0 ) {
+		if( err == 0 )
+			*dimval = converted_dimval;
+		}
+#endif
+}
 
-/*
-printf( "utInvCalendar successed \n" );
-printf( "Successuflly converted date %d/%02d/%02d %02d:%02d from %lf %s to %lf %s (calendar=%s)\n",
-	year0, month0, day0, hour0, min0, *dimval, file->recdim_units,
-	converted_dimval, var->first_file->recdim_units, d->calendar );
-*/
+#ifdef INC_UDUNITS
+/**************************************************************************************
+ * Work out, once per file, how fi_dim_value_convert should put this file's 
+ * record dim values into the units used by the first file.  When the units only
+ * differ in scale and reference date, and the calendar is one we know, going to 
+ * a date and back is the same as multiplying by a scale and adding an offset, 
+ * so that is what gets used.  The scale is just the ratio of the units.  The 
+ * offset is the value of this file's reference date in the first file's units;
+ * that depends on the calendar, so it is found by converting zero the long way.
+ */
+	static void
+fi_recdim_conversion( FDBlist *file, NCVar *var, NCDim *d )
+{
+	double	slope, intercept, offset;
+	int	year0, month0, hour0, min0, day0, std_cal, fixed_cal;
+	float	sec0;
+	char	*cal;
 
-			*dimval = converted_dimval;
+	file->recdim_conv = RECDIM_CONV_NONE;
+	if( (file->recdim_units 	   == NULL) ||
+	    (var->first_file->recdim_units == NULL) ||
+	    (var->first_file->udunits 	   == NULL) ||
+	    (file->udunits 		   == NULL) ||
+	    (! d->timelike )                        ||
+	    (strcmp(file->recdim_units,var->first_file->recdim_units) == 0) ) 
+	    	return;
 
-/*
-err = utCalendar_cal( *dimval, var->first_file->udunits, 
-&year1, &month1, &day1, &hour1, &min1, &sec1, d->calendar );
-printf( "Check date of new value: %lf = %d/%02d/%02d %02d:%02d %s (calendar=%s)\n",
-	*dimval, year1, month1, day1, hour1, min1, 
-	var->first_file->recdim_units, d->calendar );
-*/
-				}
-			}
-#endif
+	file->recdim_conv = RECDIM_CONV_CALENDAR;
+	if( utConvert( file->udunits, var->first_file->udunits, &slope, &intercept ) != 0 )
+		return;
+
+	cal       = d->calendar;
+	std_cal   = (cal == NULL) || (strncasecmp(cal,"standard",8)==0) || (strncasecmp(cal,"gregorian",9)==0);
+	fixed_cal = (cal != NULL) && ((strncasecmp(cal,"365_day",7)==0) || (strncasecmp(cal,"noleap",6)==0) || 
+			(strncasecmp(cal,"360_day",7)==0));
+
+	if( std_cal )
+		offset = intercept;
+	else if( fixed_cal ) {
+		if( utCalendar_cal( 0.0, file->udunits, &year0, &month0, &day0, &hour0, &min0, 
+				&sec0, cal ) != 0 )
+			return;
+		if( utInvCalendar_cal( year0, month0, day0, hour0, min0, sec0, 
+				var->first_file->udunits, &offset, cal ) != 0 )
+			return;
+		}
+	else
+		return;
+
+	file->recdim_conv   = RECDIM_CONV_AFFINE;
+	file->recdim_scale  = slope;
+	file->recdim_offset = offset;
+	if( options.debug )
+		fprintf( stderr, "recdim values in file %s are converted from \"%s\" to \"%s\" as value*%lg + %lg\n",
+			file->filename, file->recdim_units, var->first_file->recdim_units, slope, offset );
 }
+#endif
 
 /*************************************************************************************
  * Return the value of a dimension at a specific point.  Returns the type
@@ -477,26 +636,13 @@ fi_dim_value( NCVar *var, int dim_id, size_t virt_place, double *return_val_doub
 	char *return_val_char, int *return_has_bounds, double *return_bounds_min, 
 	double *return_bounds_max )
 {
-	size_t	actual_place, *virt_start_pos, *act_start_pos;
+	size_t	actual_place, virt_start_pos[MAX_VAR_DIMS], act_start_pos[MAX_VAR_DIMS];
 	FDBlist	*file;
 	int	i, err;
 	char	*dim_name, *dim_units;
 	nc_type	ret_val;
 	NCDim	*d;
 
-	act_start_pos  = (size_t *)malloc(var->n_dims * sizeof(size_t));
-	if( act_start_pos == NULL ) {
-		fprintf( stderr, "error allocating space for act_start_pos\n" );
-		fprintf( stderr, "in routine fi_dim_value\n" );
-		exit( -1 );
-		}
-	virt_start_pos = (size_t *)malloc(var->n_dims * sizeof(size_t));
-	if( virt_start_pos == NULL ) {
-		fprintf( stderr, "error allocating space for virt_start_pos\n" );
-		fprintf( stderr, "in routine fi_dim_value\n" );
-		exit( -1 );
-		}
-
 	for( i=0; i<var->n_dims; i++ )
 		*(virt_start_pos+i) = 0L;
 	*(virt_start_pos+dim_id) = virt_place;
@@ -507,18 +653,19 @@ fi_dim_value( NCVar *var, int dim_id, size_t virt_place, double *return_val_doub
 
 	d = (*(var->dim+dim_id));
 	dim_name  = d->name;
-	if( file_type == FILE_TYPE_NETCDF )
+	if( file_type == FILE_TYPE_NETCDF ) {
+		fi_lock();
 		ret_val = netcdf_dim_value( file->id, dim_name, actual_place, 
 				return_val_double, return_val_char, virt_place,
 				return_has_bounds, return_bounds_min, return_bounds_max );
+		fi_unlock();
+		}
 	else
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_dim_value: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	free( act_start_pos );
-	free( virt_start_pos );
 
 #ifdef INC_UDUNITS
 	/* Now we have to figure out if we need to change units on the
@@ -541,13 +688,18 @@ fi_dim_value( NCVar *var, int dim_id, size_t virt_place, double *return_val_doub
 	int
 fi_has_dim_values( int fileid, char *dim_name )
 {
+	int	ret_val;
+
 	if( file_type != FILE_TYPE_NETCDF )
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_has_dim_values: %d\n",
 			file_type );
 		exit( -1 );
 		}
-	return( netcdf_has_dim_values( fileid, dim_name ) );
+	fi_lock();
+	ret_val = netcdf_has_dim_values( fileid, dim_name );
+	fi_unlock();
+	return( ret_val );
 }
 
 /*************************************************************************************
@@ -558,13 +710,18 @@ fi_has_dim_values( int fileid, char *dim_name )
 	void
 determine_file_type( Stringlist *input_files )
 {
+	int	ok;
+
 	if( input_files == NULL ) {
 		fprintf( stderr, "ncview: takes at least one file name as argument\n" );
 		useage();
 		exit( -1 );
 		}
 
-	if( netcdf_fi_confirm( input_files->string ) )
+	fi_lock();
+	ok = netcdf_fi_confirm( input_files->string );
+	fi_unlock();
+	if( ok )
 		file_type = FILE_TYPE_NETCDF;
 	else
 		{
@@ -581,8 +738,11 @@ determine_file_type( Stringlist *input_files )
 	void
 fi_fill_aux_data( int id, char *var_name, FDBlist *fdb )
 {
-	if( file_type == FILE_TYPE_NETCDF )
+	if( file_type == FILE_TYPE_NETCDF ) {
+		fi_lock();
 		netcdf_fill_aux_data( id, var_name, fdb );
+		fi_unlock();
+		}
 	else
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_has_dim_values: %d\n",
@@ -599,9 +759,12 @@ fi_fill_aux_data( int id, char *var_name, FDBlist *fdb )
 	void
 fi_fill_value( NCVar *var, float *fill_value )
 {
-	if( file_type == FILE_TYPE_NETCDF )
+	if( file_type == FILE_TYPE_NETCDF ) {
+		fi_lock();
 		netcdf_fill_value( var->first_file->id, var->name, 
 				fill_value, (NetCDFOptions *)var->first_file->aux_data );
+		fi_unlock();
+		}
 	else
 		{
 		fprintf( stderr, "?unknown file_type passed to fi_fill_value: %d\n",
@@ -613,5 +776,40 @@ fi_fill_value( NCVar *var, float *fill_value )
 	int 	
 fi_recdim_id( int fileid )
 {
-	return( netcdf_fi_recdim_id( fileid ));
+	int	ret_val;
+
+	fi_lock();
+	ret_val = netcdf_fi_recdim_id( fileid );
+	fi_unlock();
+	return( ret_val );
+}
+
+/************************************************************************************
+ * Serialize access to the data files, which are read from both the main
+ * thread and the worker thread (see worker.c).
+ */
+	void
+fi_lock( void )
+{
+	pthread_once( &file_lock_once, file_lock_init );
+	pthread_mutex_lock( &file_lock );
+}
+
+/************************************************************************************/
+	void
+fi_unlock( void )
+{
+	pthread_mutex_unlock( &file_lock );
+}
+
+/************************************************************************************/
+	static void
+file_lock_init( void )
+{
+	pthread_mutexattr_t	attr;
+
+	pthread_mutexattr_init( &attr );
+	pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+	pthread_mutex_init( &file_lock, &attr );
+	pthread_mutexattr_destroy( &attr );
 }
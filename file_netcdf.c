@@ -45,6 +45,7 @@ int netcdf_dimvar_id( int fileid, char *dim_name );
 int get_att_util( int id, int varid, char *var_name, char *att_name, int expected_len, void *value );
 
 char *nc_type_to_string( nc_type type );
+static void netcdf_clean_data( float *data, size_t tot_size, NetCDFOptions *aux_data );
 
 /*******************************************************************************************/
 int netcdf_fi_confirm( char *name )
@@ -76,8 +77,11 @@ int netcdf_fi_writable( char *name )
 int netcdf_fi_initialize( char *name )
 {
 	int	cdfid;
+	double	t0;
 
+	TIMING_BEGIN( t0 );
 	cdfid = ncopen( name, NC_NOWRITE );
+	TIMING_END( TIMING_OPEN, t0 );
 
 	if( cdfid < 0 ) {
 		fprintf( stderr, "fi_initialize: can't properly open file %s\n",
@@ -362,6 +366,7 @@ void netcdf_fi_get_data( int fileid, char *var_name, size_t *start_pos,
 {
 	int	i, err, varid;
 	size_t	tot_size, n_dims;
+	double	t0;
 
 	tot_size = 1L;
 	n_dims = netcdf_fi_n_dims( fileid, var_name );
@@ -383,7 +388,9 @@ void netcdf_fi_get_data( int fileid, char *var_name, size_t *start_pos,
 			fprintf( stderr, "[%d]: %ld %ld\n", i, *(start_pos+i), *(count+i) );
 		}
 
+	TIMING_BEGIN( t0 );
 	err = nc_get_vara_float( fileid, varid, start_pos, count, data );
+	TIMING_END( TIMING_READ, t0 );
 	if( err != NC_NOERR ) {
 		fprintf( stderr, "netcdf_fi_get_data: error on nc_get_vara_float call\n" );
 		fprintf( stderr, "cdfid=%d   variable=%s\n", fileid, var_name );
@@ -395,12 +402,6 @@ void netcdf_fi_get_data( int fileid, char *var_name, size_t *start_pos,
 		exit( -1 );
 		}
 
-	/* Eliminate nans */
-        for( i=0L; i<tot_size; i++ ) {
-		if( isnan(data[i]))
-			data[i] = FILL_FLOAT;
-		}
-
 #ifdef ELIM_DENORMS
         /* Eliminate denormalized numbers and NaNs */
 	n_nans = 0L;
@@ -434,6 +435,70 @@ void netcdf_fi_get_data( int fileid, char *var_name, size_t *start_pos,
 	*/
 #endif
 
+	TIMING_BEGIN( t0 );
+	netcdf_clean_data( data, tot_size, aux_data );
+	TIMING_END( TIMING_UNPACK, t0 );
+
+	if( options.debug ) 
+		fprintf( stderr, "returning from netcdf_fi_get_data\n" );
+}
+
+/*******************************************************************************************/
+/* Same as netcdf_fi_get_data, but only every stride[i]'th point is read along
+ * each dimension; count[i] is the number of points to read along it.
+ */
+void netcdf_fi_get_data_strided( int fileid, char *var_name, size_t *start_pos, 
+		size_t *count, ptrdiff_t *stride, float *data, NetCDFOptions *aux_data )
+{
+	int	i, err, varid;
+	size_t	tot_size, n_dims;
+	double	t0;
+
+	tot_size = 1L;
+	n_dims = netcdf_fi_n_dims( fileid, var_name );
+	for( i=0; i<n_dims; i++ )
+		tot_size *= *(count+i);
+
+	err = nc_inq_varid( fileid, var_name, &varid );
+	if( err != NC_NOERR ) {
+		fprintf( stderr, "Error in netcdf_fi_get_data_strided: could not find var named \"%s\" in file!\n",
+			var_name );
+		exit(-1);
+		}
+
+	TIMING_BEGIN( t0 );
+	err = nc_get_vars_float( fileid, varid, start_pos, count, stride, data );
+	TIMING_END( TIMING_READ, t0 );
+	if( err != NC_NOERR ) {
+		fprintf( stderr, "netcdf_fi_get_data_strided: error on nc_get_vars_float call\n" );
+		fprintf( stderr, "cdfid=%d   variable=%s\n", fileid, var_name );
+		fprintf( stderr, "start, count, stride:\n" );
+		for( i=0; i<n_dims; i++ )
+			fprintf( stderr, "[%1d]: %ld  %ld  %ld\n", 
+				i, *(start_pos+i), *(count+i), (long)(*(stride+i)) );
+		fprintf( stderr, "%s\n", nc_strerror(err) );
+		exit( -1 );
+		}
+
+	TIMING_BEGIN( t0 );
+	netcdf_clean_data( data, tot_size, aux_data );
+	TIMING_END( TIMING_UNPACK, t0 );
+}
+
+/*******************************************************************************************/
+/* Replace NaNs with the fill value, and implement the "add_offset" and "scale_factor"
+ * attributes, on data just read from the file.
+ */
+static void netcdf_clean_data( float *data, size_t tot_size, NetCDFOptions *aux_data )
+{
+	size_t	i;
+
+	/* Eliminate nans */
+        for( i=0L; i<tot_size; i++ ) {
+		if( isnan(data[i]))
+			data[i] = FILL_FLOAT;
+		}
+
 	/* Implement the "add_offset" and "scale_factor" attributes */
 	if( aux_data->add_offset_set && aux_data->scale_factor_set )
 		for( i=0; i<tot_size; i++ )
@@ -445,9 +510,6 @@ void netcdf_fi_get_data( int fileid, char *var_name, size_t *start_pos,
 	else if( aux_data->scale_factor_set ) 
 		for( i=0; i<tot_size; i++ )
 			*(data+i) = *(data+i) * aux_data->scale_factor;
-
-	if( options.debug ) 
-		fprintf( stderr, "returning from netcdf_fi_get_data\n" );
 }
 
 /*******************************************************************************************/
@@ -1508,7 +1570,7 @@ int netcdf_dimvar_bounds_id( int fileid, char *dim_name, int *nvertices )
 {
 	int	reg_dimvar_id, bounds_dimvar_id, dimvar_ndims, err, name_length;
 	char	*attname = "bounds";
-	char 	*bounds_dimvarname;
+	char 	bounds_dimvarname[MAX_NC_NAME+1];
 	nc_type	type;
 	size_t	st_nvertices;
 	int dimids[MAX_NC_DIMS]; 
@@ -1524,22 +1586,18 @@ int netcdf_dimvar_bounds_id( int fileid, char *dim_name, int *nvertices )
 		return( -1 );
 
 	err = ncattinq( fileid, reg_dimvar_id, attname, &type, &name_length );
-	if( (err < 0) || (type != NC_CHAR))
+	if( (err < 0) || (type != NC_CHAR) || (name_length > MAX_NC_NAME))
 		return( -1 );
 
-	bounds_dimvarname = (char *)malloc( name_length+1 );
 	err = ncattget( fileid, reg_dimvar_id, attname, bounds_dimvarname );
-	if( err < 0 ) {
-		free( bounds_dimvarname );
+	if( err < 0 )
 		return( -1 );
-		}
 
 	if( *(bounds_dimvarname+name_length-1) != '\0' )
 		*(bounds_dimvarname + name_length) = '\0';
 
 	err = nc_inq_varid( fileid, bounds_dimvarname, &bounds_dimvar_id );
 	if( err != 0 ) {
-		free( bounds_dimvarname );
 		return( -1 );
 		}
 
@@ -1548,7 +1606,6 @@ int netcdf_dimvar_bounds_id( int fileid, char *dim_name, int *nvertices )
 	if( (err != NC_NOERR) || (dimvar_ndims != 2)) {
 		fprintf( stderr, "Currently can only handle bounds dims with ndims=2; bounds var %s has ndims=%d.  Ignoring!\n", 
 				bounds_dimvarname, dimvar_ndims );
-		free( bounds_dimvarname );
 		return( -1 );
 		}
 
@@ -1558,19 +1615,15 @@ int netcdf_dimvar_bounds_id( int fileid, char *dim_name, int *nvertices )
 	err = nc_inq_vardimid( fileid, bounds_dimvar_id, dimids );
 	if( err != NC_NOERR ) {
 		fprintf( stderr, "Error reading bounds info for boundary variable %s.  Ignoring!\n", bounds_dimvarname );
-		free( bounds_dimvarname );
 		return( -1 );
 		}
 	err = nc_inq_dimlen( fileid, dimids[1], &st_nvertices );
 	if( err != NC_NOERR ) {
 		fprintf( stderr, "Error reading nvertices info for boundary variable %s.  Ignoring!\n", bounds_dimvarname );
-		free( bounds_dimvarname );
 		return( -1 );
 		}
 	*nvertices = (int)st_nvertices;
 
-	free( bounds_dimvarname );
-
 	return( bounds_dimvar_id );
 }
 
@@ -0,0 +1,380 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2008 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrean
+ * San Diego, CA   92122
+ * pierce@cirrus.ucsd.edu
+ */
+
+
+/*******************************************************************************
+ * 	frameexport.c
+ *
+ *	Writes the frames being displayed out to disk when -frames is given,
+ *	either as one PPM file per frame or as a single YUV4MPEG2 (.y4m) 
+ *	stream, which most video tools can read directly.
+ *
+ *	The drawing code only copies the frame's pixels and the colors
+ *	they stand for into a short queue; a writer thread takes them from
+ *	there, converts them, and writes them out with large buffered
+ *	writes.  If the writer falls behind and the queue fills up, the 
+ *	drawing waits for it, so no frames are lost.
+ *******************************************************************************/
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+extern Options options;
+
+#define EXPORT_QUEUE_LEN	8
+#define EXPORT_STREAM_BUFSIZE	(4L*1024L*1024L)
+#define EXPORT_DEFAULT_FPS	10.0
+
+typedef struct {
+	ncv_pixel	*pixels;
+	size_t		pixels_size;		/* allocated size of pixels */
+	size_t		width, height, frameno;
+	unsigned char	palette[256][3];
+} ExportFrame;
+
+static ExportFrame	queue[EXPORT_QUEUE_LEN];
+static int		q_head = 0, q_count = 0;	/* q_head is the oldest */
+static int		started = FALSE, stopping = FALSE, failed = FALSE;
+static pthread_t	writer;
+static pthread_mutex_t	export_lock      = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	export_not_empty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	export_not_full  = PTHREAD_COND_INITIALIZER;
+
+/* Only touched by the writer thread */
+static FILE		*stream = NULL;
+static size_t		stream_width, stream_height;
+static unsigned char	*out_buf = NULL;
+static size_t		out_buf_size = 0L;
+
+static void	*export_writer( void *arg );
+static void	export_write_ppm( ExportFrame *f );
+static void	export_write_y4m( ExportFrame *f );
+static unsigned char *export_buffer( size_t n );
+static unsigned char export_byte( double v );
+
+/*******************************************************************************
+ * Queue up a frame to be written.  'palette' gives the red, green, and blue
+ * of each pixel value.  Waits if the writer is too far behind.
+ */
+	void
+frameexport_put( ncv_pixel *pixels, size_t width, size_t height, size_t frameno, 
+		unsigned char palette[256][3] )
+{
+	ExportFrame	*f;
+
+	pthread_mutex_lock( &export_lock );
+
+	if( failed ) {
+		pthread_mutex_unlock( &export_lock );
+		return;
+		}
+
+	if( ! started ) {
+		if( pthread_create( &writer, NULL, export_writer, NULL ) != 0 ) {
+			fprintf( stderr, "ncview: can't start the frame writing thread, frames will not be saved\n" );
+			failed = TRUE;
+			pthread_mutex_unlock( &export_lock );
+			return;
+			}
+		started = TRUE;
+		}
+
+	while( q_count == EXPORT_QUEUE_LEN )
+		pthread_cond_wait( &export_not_full, &export_lock );
+
+	/* The slot past the newest is not being looked at by the writer */
+	f = queue + (q_head + q_count) % EXPORT_QUEUE_LEN;
+	pthread_mutex_unlock( &export_lock );
+
+	if( width*height > f->pixels_size ) {
+		if( f->pixels != NULL )
+			free( f->pixels );
+		f->pixels = (ncv_pixel *)malloc( width*height*sizeof(ncv_pixel) );
+		if( f->pixels == NULL ) {
+			fprintf( stderr, "ncview: frameexport_put: failed to allocate %ld x %ld frame\n",
+				(long)width, (long)height );
+			exit( -1 );
+			}
+		f->pixels_size = width*height;
+		}
+	memcpy( f->pixels, pixels, width*height*sizeof(ncv_pixel) );
+	memcpy( f->palette, palette, sizeof(f->palette) );
+	f->width   = width;
+	f->height  = height;
+	f->frameno = frameno;
+
+	pthread_mutex_lock( &export_lock );
+	q_count++;
+	pthread_cond_signal( &export_not_empty );
+	pthread_mutex_unlock( &export_lock );
+}
+
+/*******************************************************************************
+ * Write out everything still queued and finish the stream.  Must be called
+ * before exiting, or the last frames are lost.
+ */
+	void
+frameexport_close( void )
+{
+	pthread_mutex_lock( &export_lock );
+	if( ! started ) {
+		pthread_mutex_unlock( &export_lock );
+		return;
+		}
+	stopping = TRUE;
+	pthread_cond_signal( &export_not_empty );
+	pthread_mutex_unlock( &export_lock );
+
+	pthread_join( writer, NULL );
+	started = FALSE;
+}
+
+/*******************************************************************************/
+	static void *
+export_writer( void *arg )
+{
+	ExportFrame	*f;
+	int		skip;
+
+	for( ;; ) {
+		pthread_mutex_lock( &export_lock );
+		while( (q_count == 0) && (! stopping) )
+			pthread_cond_wait( &export_not_empty, &export_lock );
+		if( q_count == 0 ) {
+			pthread_mutex_unlock( &export_lock );
+			break;
+			}
+		f    = queue + q_head;
+		skip = failed;
+		pthread_mutex_unlock( &export_lock );
+
+		if( skip )
+			;
+		else if( options.frames_y4m != NULL )
+			export_write_y4m( f );
+		else
+			export_write_ppm( f );
+
+		pthread_mutex_lock( &export_lock );
+		q_head = (q_head + 1) % EXPORT_QUEUE_LEN;
+		q_count--;
+		pthread_cond_signal( &export_not_full );
+		pthread_mutex_unlock( &export_lock );
+		}
+
+	if( stream != NULL ) {
+		if( fclose( stream ) != 0 )
+			fprintf( stderr, "ncview: error writing file %s\n", options.frames_y4m );
+		stream = NULL;
+		}
+	return( NULL );
+}
+
+/*******************************************************************************
+ * One PPM file per frame, named after the frame number as it always has been.
+ */
+	static void
+export_write_ppm( ExportFrame *f )
+{
+	char		filename[2048];
+
+	sprintf( filename, "frame.%05ld.ppm", (long)f->frameno );
+	frameexport_write_ppm( filename, f->pixels, f->width, f->height, f->palette,
+		export_buffer( frameexport_ppm_size( f->width, f->height )));
+}
+
+/*******************************************************************************
+ * The most bytes frameexport_write_ppm needs in its buffer for a frame of
+ * this size.
+ */
+	size_t
+frameexport_ppm_size( size_t width, size_t height )
+{
+	return( 64L + 3L*width*height );
+}
+
+/*******************************************************************************
+ * Writes one frame to the named PPM file, with each pixel given the color
+ * 'palette' has for it.  'buf' is where the file is put together, and must
+ * hold frameexport_ppm_size() bytes.  This can be called from any thread, 
+ * as long as each has its own buffer.  Returns 0 on success, -1 on failure.
+ */
+	int
+frameexport_write_ppm( char *filename, ncv_pixel *pixels, size_t width, size_t height, 
+		unsigned char palette[256][3], unsigned char *buf )
+{
+	FILE		*out_file;
+	size_t		i, n, header_len;
+	unsigned char	*rgb, *color;
+
+	sprintf( (char *)buf, "P6\n%ld %ld\n255\n", (long)width, (long)height );
+	header_len = strlen( (char *)buf );
+	n   = header_len + 3L*width*height;
+	rgb = buf + header_len;
+	for( i=0; i<width*height; i++ ) {
+		color = palette[*(pixels+i)];
+		*rgb++ = *color;
+		*rgb++ = *(color+1);
+		*rgb++ = *(color+2);
+		}
+
+	if( (out_file = fopen( filename, "w" )) == NULL ) {
+		fprintf( stderr, "ncview: can't open file %s for writing\n", filename );
+		return( -1 );
+		}
+	if( fwrite( buf, 1, n, out_file ) != n ) {
+		fprintf( stderr, "ncview: error writing file %s\n", filename );
+		fclose( out_file );
+		return( -1 );
+		}
+	if( fclose( out_file ) != 0 ) {
+		fprintf( stderr, "ncview: error writing file %s\n", filename );
+		return( -1 );
+		}
+
+	return( 0 );
+}
+
+/*******************************************************************************
+ * Round to a byte.  Fully saturated blue and red come out at 256 for Cb and
+ * Cr, which would not fit, so the value is clamped to 0..255 first.
+ */
+	static unsigned char
+export_byte( double v )
+{
+	if( v > 255.0 )
+		v = 255.0;
+	if( v < 0.0 )
+		v = 0.0;
+	return( (unsigned char)v );
+}
+
+/*******************************************************************************
+ * Append the frame to the YUV4MPEG2 stream, as full range 4:2:0 YCbCr.  All
+ * frames in a stream must be the same size, so frames of another size than
+ * the first (after changing the magnification, say) are left out.
+ */
+	static void
+export_write_y4m( ExportFrame *f )
+{
+	unsigned char	y_of[256], cb_of[256], cr_of[256], *buf, *yp, *cbp, *crp;
+	size_t		i, j, cw, ch, n, i2, j2;
+	ncv_pixel	*row0, *row1;
+	float		r, g, b, fps;
+	int		k, fps_num, fps_den;
+	static int	warned = FALSE;
+
+	if( stream == NULL ) {
+		if( (stream = fopen( options.frames_y4m, "w" )) == NULL ) {
+			fprintf( stderr, "ncview: can't open file %s for writing, frames will not be saved\n", 
+				options.frames_y4m );
+			pthread_mutex_lock( &export_lock );
+			failed = TRUE;
+			pthread_mutex_unlock( &export_lock );
+			return;
+			}
+		setvbuf( stream, NULL, _IOFBF, EXPORT_STREAM_BUFSIZE );
+
+		fps = (options.target_fps > 0.0) ? options.target_fps : EXPORT_DEFAULT_FPS;
+		fps_den = 1000;
+		fps_num = (int)(fps*fps_den + 0.5);
+		stream_width  = f->width;
+		stream_height = f->height;
+		fprintf( stream, "YUV4MPEG2 W%ld H%ld F%d:%d Ip A1:1 C420jpeg XCOLORRANGE=FULL\n",
+			(long)stream_width, (long)stream_height, fps_num, fps_den );
+		}
+
+	if( (f->width != stream_width) || (f->height != stream_height) ) {
+		if( ! warned ) {
+			fprintf( stderr, "ncview: frames that are not %ld x %ld are left out of %s\n",
+				(long)stream_width, (long)stream_height, options.frames_y4m );
+			warned = TRUE;
+			}
+		return;
+		}
+
+	for( k=0; k<256; k++ ) {
+		r = (float)f->palette[k][0];
+		g = (float)f->palette[k][1];
+		b = (float)f->palette[k][2];
+		y_of[k]  = export_byte(  0.299   *r + 0.587   *g + 0.114   *b         + 0.5 );
+		cb_of[k] = export_byte( -0.168736*r - 0.331264*g + 0.5     *b + 128.0 + 0.5 );
+		cr_of[k] = export_byte(  0.5     *r - 0.418688*g - 0.081312*b + 128.0 + 0.5 );
+		}
+
+	cw  = (f->width +1)/2;
+	ch  = (f->height+1)/2;
+	n   = f->width*f->height + 2L*cw*ch;
+	buf = export_buffer( n );
+	yp  = buf;
+	cbp = buf + f->width*f->height;
+	crp = cbp + cw*ch;
+
+	for( i=0; i<f->width*f->height; i++ )
+		*(yp+i) = y_of[*(f->pixels+i)];
+
+	/* Each chroma sample is the average over its 2 x 2 block; an odd last
+	 * row or column is paired with itself.
+	 */
+	for( j=0; j<ch; j++ ) {
+		row0 = f->pixels + (2*j)*f->width;
+		row1 = (2*j+1 < f->height) ? row0 + f->width : row0;
+		for( i=0; i<cw; i++ ) {
+			i2 = 2*i;
+			j2 = (i2+1 < f->width) ? i2+1 : i2;
+			*(cbp + i + j*cw) = (unsigned char)(( cb_of[*(row0+i2)] + cb_of[*(row0+j2)] + 
+							      cb_of[*(row1+i2)] + cb_of[*(row1+j2)] + 2 ) / 4 );
+			*(crp + i + j*cw) = (unsigned char)(( cr_of[*(row0+i2)] + cr_of[*(row0+j2)] + 
+							      cr_of[*(row1+i2)] + cr_of[*(row1+j2)] + 2 ) / 4 );
+			}
+		}
+
+	fputs( "FRAME\n", stream );
+	if( fwrite( buf, 1, n, stream ) != n ) {
+		fprintf( stderr, "ncview: error writing file %s, frames will no longer be saved\n", 
+			options.frames_y4m );
+		pthread_mutex_lock( &export_lock );
+		failed = TRUE;
+		pthread_mutex_unlock( &export_lock );
+		}
+}
+
+/*******************************************************************************
+ * The writer's output buffer, kept between frames.
+ */
+	static unsigned char *
+export_buffer( size_t n )
+{
+	if( n > out_buf_size ) {
+		if( out_buf != NULL )
+			free( out_buf );
+		out_buf = (unsigned char *)malloc( n );
+		if( out_buf == NULL ) {
+			fprintf( stderr, "ncview: frame writer: failed to allocate %ld bytes\n", (long)n );
+			exit( -1 );
+			}
+		out_buf_size = n;
+		}
+	return( out_buf );
+}
@@ -0,0 +1,434 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2008 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrean
+ * San Diego, CA   92122
+ * pierce@cirrus.ucsd.edu
+ */
+
+/*******************************************************************************
+ * 	framestore.c
+ *
+ *	Keeps already-rendered frames around so that animating through
+ *	them again does not require re-reading and re-rendering the data.
+ *
+ *	Frames are held run-length encoded.  Each row of a frame starts
+ *	with a tag byte: ROW_REPEAT means the row is the same as the one
+ *	above it (which is what every row but the first of a magnified
+ *	block looks like), and ROW_PACKED means a PackBits-style row
+ *	follows.  In a packed row, a control byte c < 128 is followed by
+ *	c+1 literal pixels, and c >= 128 is followed by a single pixel to
+ *	be repeated c-125 times.  Fill regions, smooth fields, and
+ *	replicated pixels all compress well this way, and decoding is
+ *	little more than a memcpy/memset per run.
+ *
+ *	The store is limited to a memory budget; when a new frame won't
+ *	fit, the least recently used frames are thrown out to make room.
+ *	Frames are also counted against the -memlimit limit (see
+ *	membudget.c), which can ask for frames to be thrown out when
+ *	something else needs the memory.
+ *
+ *	Frames are drawn differently depending on options.range_mode, so
+ *	the store remembers which mode its frames were drawn in.  It won't
+ *	hand them out in the other mode, and throws them all out when a
+ *	frame drawn in the other mode is put in.
+ *******************************************************************************/
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+extern Options    options;
+extern FrameStore framestore;
+
+#define ROW_REPEAT	0
+#define ROW_PACKED	1
+
+#define MIN_RUN		3
+#define MAX_RUN		130
+#define MAX_LITERAL	128
+
+static size_t	encode_frame( ncv_pixel *pixels, size_t width, size_t height, unsigned char *out );
+static size_t	encode_row( ncv_pixel *row, size_t width, unsigned char *out );
+static void	decode_frame( unsigned char *in, size_t width, size_t height, ncv_pixel *pixels );
+static size_t	evict_lru( void );
+static void	drop_frame( size_t frameno );
+static size_t	framestore_evict( size_t want );
+
+static int	reported_full = FALSE;
+
+/*******************************************************************************
+ * Set up the frame store to hold 'n_frames' frames of the given size, using
+ * at most 'budget' bytes for the encoded frames (0 means no limit).  Any
+ * frames previously held are thrown away.  Returns 0 on success, -1 if the
+ * bookkeeping arrays could not be allocated.
+ */
+	int
+framestore_init( size_t n_frames, size_t width, size_t height, size_t budget )
+{
+	size_t	i;
+
+	framestore_free();
+	membudget_set_evict( MEM_FRAMES, framestore_evict );
+
+	framestore.n_frames   = n_frames;
+	framestore.width      = width;
+	framestore.height     = height;
+	framestore.budget     = budget;
+	framestore.bytes_held = 0L;
+	framestore.raw_held   = 0L;
+	framestore.n_held     = 0L;
+	framestore.clock      = 0L;
+	framestore.range_mode = options.range_mode;
+
+	framestore.frame     = (unsigned char **)malloc( n_frames*sizeof(unsigned char *));
+	framestore.frame_len = (size_t *)malloc( n_frames*sizeof(size_t));
+	framestore.last_used = (unsigned long *)malloc( n_frames*sizeof(unsigned long));
+	framestore.decode    = (ncv_pixel *)membudget_malloc( MEM_FRAMES, width*height*sizeof(ncv_pixel));
+
+	/* Worst case: a tag byte per row, and one control byte per MAX_LITERAL pixels */
+	framestore.encode    = (unsigned char *)membudget_malloc( MEM_FRAMES, 
+					height*(width + width/MAX_LITERAL + 2));
+
+	if( (framestore.frame     == NULL) || (framestore.frame_len == NULL) ||
+	    (framestore.last_used == NULL) || (framestore.decode    == NULL) ||
+	    (framestore.encode    == NULL) ) {
+		framestore_free();
+		return( -1 );
+		}
+
+	for( i=0; i<n_frames; i++ ) {
+		*(framestore.frame     + i) = NULL;
+		*(framestore.frame_len + i) = 0L;
+		*(framestore.last_used + i) = 0L;
+		}
+
+	reported_full    = FALSE;
+	framestore.valid = TRUE;
+	return( 0 );
+}
+
+/*******************************************************************************
+ * Release everything held by the frame store and mark it invalid.
+ */
+	void
+framestore_free( void )
+{
+	if( framestore.frame != NULL ) {
+		framestore_invalidate_all();
+		free( framestore.frame );
+		}
+	if( framestore.frame_len != NULL )
+		free( framestore.frame_len );
+	if( framestore.last_used != NULL )
+		free( framestore.last_used );
+	membudget_free( MEM_FRAMES, framestore.decode, 
+			framestore.width*framestore.height*sizeof(ncv_pixel) );
+	membudget_free( MEM_FRAMES, framestore.encode,
+			framestore.height*(framestore.width + framestore.width/MAX_LITERAL + 2) );
+
+	framestore.frame     = NULL;
+	framestore.frame_len = NULL;
+	framestore.last_used = NULL;
+	framestore.decode    = NULL;
+	framestore.encode    = NULL;
+	framestore.valid     = FALSE;
+}
+
+/*******************************************************************************
+ * Throw out all the frames, but keep the store set up for frames of the
+ * same size.
+ */
+	void
+framestore_invalidate_all( void )
+{
+	size_t	i;
+
+	if( framestore.frame == NULL )
+		return;
+
+	for( i=0; i<framestore.n_frames; i++ )
+		drop_frame( i );
+}
+
+/*******************************************************************************
+ * Returns a pointer to the decoded frame, or NULL if that frame is not held
+ * (or is held at a different size or range mode than requested).  The 
+ * returned pixels are only good until the next call to this routine.
+ */
+	ncv_pixel *
+framestore_get( size_t frameno, size_t width, size_t height )
+{
+	if( (! framestore.valid) || (frameno >= framestore.n_frames) )
+		return( NULL );
+	if( (width != framestore.width) || (height != framestore.height) )
+		return( NULL );
+	if( framestore.range_mode != options.range_mode )
+		return( NULL );
+	if( *(framestore.frame + frameno) == NULL )
+		return( NULL );
+
+	*(framestore.last_used + frameno) = ++framestore.clock;
+	decode_frame( *(framestore.frame + frameno), width, height, framestore.decode );
+	return( framestore.decode );
+}
+
+/*******************************************************************************
+ * Encode the passed frame and add it to the store, evicting old frames
+ * if needed to stay under the budget.  The frame is not kept if there is
+ * no room for it under the memory limit.
+ */
+	void
+framestore_put( size_t frameno, ncv_pixel *pixels, size_t width, size_t height )
+{
+	size_t	len;
+	unsigned char *enc;
+	char	stats[256];
+
+	if( (! framestore.valid) || (frameno >= framestore.n_frames) )
+		return;
+	if( (width != framestore.width) || (height != framestore.height) )
+		return;
+	if( framestore.range_mode != options.range_mode ) {
+		framestore_invalidate_all();
+		framestore.range_mode = options.range_mode;
+		}
+
+	drop_frame( frameno );
+
+	len = encode_frame( pixels, width, height, framestore.encode );
+
+	if( (framestore.budget > 0) && (len > framestore.budget) )
+		return;		/* would never fit */
+
+	while( (framestore.budget > 0) && (framestore.n_held > 0) &&
+	       (framestore.bytes_held + len > framestore.budget) ) {
+		if( ! reported_full ) {
+			framestore_stats_string( stats );
+			fprintf( stderr, "ncview: frame store is full, discarding least recently used frames (%s)\n",
+				stats );
+			reported_full = TRUE;
+			}
+		evict_lru();
+		}
+
+	if( ! membudget_reserve( MEM_FRAMES, len ))
+		return;
+	enc = (unsigned char *)malloc( len );
+	if( enc == NULL ) {
+		membudget_release( MEM_FRAMES, len );
+		return;
+		}
+	memcpy( enc, framestore.encode, len );
+
+	*(framestore.frame     + frameno) = enc;
+	*(framestore.frame_len + frameno) = len;
+	*(framestore.last_used + frameno) = ++framestore.clock;
+	framestore.bytes_held += len;
+	framestore.raw_held   += width*height;
+	framestore.n_held++;
+
+	if( options.debug ) {
+		framestore_stats_string( stats );
+		fprintf( stderr, "framestore: stored frame %ld in %ld bytes; %s\n",
+			(long)frameno, (long)len, stats );
+		}
+}
+
+/*******************************************************************************
+ * Describe how full the store is and how well the frames are compressing.
+ * 's' must have room for at least 132 characters.
+ */
+	void
+framestore_stats_string( char *s )
+{
+	double	ratio;
+
+	if( framestore.bytes_held > 0 )
+		ratio = (double)framestore.raw_held / (double)framestore.bytes_held;
+	else
+		ratio = 0.0;
+
+	if( framestore.budget > 0 )
+		sprintf( s, "%ld frames, %.1f of %.1f MB, compression %.1f:1",
+			(long)framestore.n_held,
+			(double)framestore.bytes_held/1048576.0,
+			(double)framestore.budget/1048576.0,
+			ratio );
+	else
+		sprintf( s, "%ld frames, %.1f MB, compression %.1f:1",
+			(long)framestore.n_held,
+			(double)framestore.bytes_held/1048576.0,
+			ratio );
+}
+
+/*******************************************************************************/
+	static void
+drop_frame( size_t frameno )
+{
+	if( *(framestore.frame + frameno) == NULL )
+		return;
+
+	free( *(framestore.frame + frameno) );
+	membudget_release( MEM_FRAMES, *(framestore.frame_len + frameno) );
+	framestore.bytes_held -= *(framestore.frame_len + frameno);
+	framestore.raw_held   -= framestore.width*framestore.height;
+	framestore.n_held--;
+	*(framestore.frame     + frameno) = NULL;
+	*(framestore.frame_len + frameno) = 0L;
+}
+
+/*******************************************************************************
+ * Called by the memory budget to get back at least 'want' bytes.  Returns
+ * how many were freed.
+ */
+	static size_t
+framestore_evict( size_t want )
+{
+	size_t	freed, len;
+
+	freed = 0L;
+	while( (freed < want) && (framestore.n_held > 0) ) {
+		if( (len = evict_lru()) == 0L )
+			break;
+		freed += len;
+		}
+	return( freed );
+}
+
+/*******************************************************************************
+ * Throw out the frame that was used longest ago, and return its size.  A
+ * linear scan is fine here, it is tiny compared to rendering the frame that
+ * is replacing it.
+ */
+	static size_t
+evict_lru( void )
+{
+	size_t		i, oldest, len;
+	unsigned long	oldest_time;
+
+	oldest      = framestore.n_frames;
+	oldest_time = 0L;
+	for( i=0; i<framestore.n_frames; i++ ) {
+		if( *(framestore.frame + i) == NULL )
+			continue;
+		if( (oldest == framestore.n_frames) || (*(framestore.last_used + i) < oldest_time) ) {
+			oldest      = i;
+			oldest_time = *(framestore.last_used + i);
+			}
+		}
+
+	if( oldest == framestore.n_frames )
+		return( 0L );
+
+	len = *(framestore.frame_len + oldest);
+	drop_frame( oldest );
+	return( len );
+}
+
+/*******************************************************************************
+ * Returns the number of bytes written to 'out'.
+ */
+	static size_t
+encode_frame( ncv_pixel *pixels, size_t width, size_t height, unsigned char *out )
+{
+	size_t	j, n;
+	ncv_pixel *row;
+
+	n = 0L;
+	for( j=0; j<height; j++ ) {
+		row = pixels + j*width;
+		if( (j > 0) && (memcmp( row, row - width, width ) == 0))
+			*(out + n++) = ROW_REPEAT;
+		else
+			{
+			*(out + n++) = ROW_PACKED;
+			n += encode_row( row, width, out + n );
+			}
+		}
+
+	return( n );
+}
+
+/*******************************************************************************/
+	static size_t
+encode_row( ncv_pixel *row, size_t width, unsigned char *out )
+{
+	size_t	i, n, run, lit_start;
+
+	n = 0L;
+	i = 0L;
+	while( i < width ) {
+		run = 1;
+		while( (i+run < width) && (run < MAX_RUN) && (*(row+i+run) == *(row+i)) )
+			run++;
+
+		if( run >= MIN_RUN ) {
+			*(out + n++) = (unsigned char)(run + 125);
+			*(out + n++) = *(row+i);
+			i += run;
+			}
+		else
+			{
+			/* Collect literals until the next worthwhile run starts */
+			lit_start = i;
+			while( (i < width) && (i-lit_start < MAX_LITERAL) ) {
+				if( (i+2 < width) && (*(row+i) == *(row+i+1)) && (*(row+i) == *(row+i+2)) )
+					break;
+				i++;
+				}
+			*(out + n++) = (unsigned char)(i - lit_start - 1);
+			memcpy( out + n, row + lit_start, i - lit_start );
+			n += i - lit_start;
+			}
+		}
+
+	return( n );
+}
+
+/*******************************************************************************/
+	static void
+decode_frame( unsigned char *in, size_t width, size_t height, ncv_pixel *pixels )
+{
+	size_t	j, i, count;
+	unsigned char c;
+	ncv_pixel *row;
+
+	for( j=0; j<height; j++ ) {
+		row = pixels + j*width;
+		if( *in++ == ROW_REPEAT ) {
+			memcpy( row, row - width, width );
+			continue;
+			}
+		i = 0L;
+		while( i < width ) {
+			c = *in++;
+			if( c < 128 ) {
+				count = c + 1;
+				memcpy( row + i, in, count );
+				in += count;
+				}
+			else
+				{
+				count = c - 125;
+				memset( row + i, *in++, count );
+				}
+			i += count;
+			}
+		}
+}
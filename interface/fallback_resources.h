@@ -70,7 +70,8 @@ static String fallback_resources[] = {
 !
 ! backup actions
 Ncview*cmap.translations:   #augment <Btn3Down>,<Btn3Up>: cmap_mod3()
-Ncview*Range.translations:  #augment <Btn3Down>,<Btn3Up>: range_mod3()
+Ncview*Range.translations:  #override <Btn3Down>,<Btn3Up>: range_mod3()\n\
+				Ctrl<Btn1Down>,<Btn1Up>: range_mod2()
 !
 ! accelerated actions
 Ncview*reverse.translations:     #override Ctrl<Btn1Down>,<Btn1Up>: reverse_mod2()
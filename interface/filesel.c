@@ -344,15 +344,18 @@ fs_list_dir( Stringlist **files, Stringlist **dirs )
 		    (strcmp( dir_entry->d_name, "..") != 0)) {
 			if( fs_is_a_directory( dir_entry->d_name )) {
 				sprintf( tchar, "%s/", dir_entry->d_name );
-				add_to_stringlist_ordered( dirs, tchar, NULL );
+				prepend_to_stringlist( dirs, tchar, NULL );
 				}
 			else 
-				add_to_stringlist_ordered( files, dir_entry->d_name, NULL );
+				prepend_to_stringlist( files, dir_entry->d_name, NULL );
 			}
 		}
 
-	add_to_stringlist_ordered( dirs, "../", NULL );
-	add_to_stringlist_ordered( dirs, "./", NULL );
+	prepend_to_stringlist( dirs, "../", NULL );
+	prepend_to_stringlist( dirs, "./", NULL );
+
+	sort_stringlist( dirs );
+	sort_stringlist( files );
 }
 
 /*********************************************************************/
@@ -160,6 +160,67 @@ in_draw_2d_field( ncv_pixel *data, size_t width, size_t height,
 	x_draw_2d_field( data, width, height, timestep );
 }
 
+/****************************************************************************
+ * Put up just the w by h part of the 2-D byte array that starts at (x,y).
+ * The array is still the full width by height; only the indicated part of
+ * it needs to be filled in.
+ */
+	void
+in_draw_2d_region( ncv_pixel *data, size_t width, size_t height,
+	size_t x, size_t y, size_t w, size_t h, size_t timestep )
+{
+	x_draw_2d_region( data, width, height, x, y, w, h, timestep );
+}
+
+/****************************************************************************
+ * Returns the part of a width by height image that can currently be seen
+ * in the (possibly scrolled) image window.
+ */
+	void
+in_get_visible_region( size_t width, size_t height, size_t *x, size_t *y, 
+	size_t *w, size_t *h )
+{
+	x_get_visible_region( width, height, x, y, w, h );
+}
+
+/****************************************************************************
+ * The image in the window is about to be replaced, so whatever copy of it
+ * is being kept to answer expose events is no longer any good.
+ */
+	void
+in_invalidate_2d_backing( void )
+{
+	x_invalidate_2d_backing();
+}
+
+/****************************************************************************
+ * If the indicated frame is being kept on the display server, show it and
+ * return TRUE; otherwise return FALSE.
+ */
+	int
+in_draw_frame_pixmap( size_t frameno, size_t width, size_t height )
+{
+	return( x_draw_frame_pixmap( frameno, width, height ));
+}
+
+/****************************************************************************
+ * Keep the image just drawn on the display server as the indicated frame.
+ */
+	void
+in_save_frame_pixmap( size_t frameno, size_t width, size_t height )
+{
+	x_save_frame_pixmap( frameno, width, height );
+}
+
+/****************************************************************************
+ * Throw out any frames being kept on the display server.
+ */
+	void
+in_clear_frame_pixmaps( void )
+{
+	x_clear_frame_pixmaps();
+}
+
 /****************************************************************************
  * Create a colormap and fill it with the passed values.  Note that the
  * 256 color values are always filled out, although the actual number
@@ -359,6 +420,92 @@ in_timer_set( XtTimerCallbackProc procedure, XtPointer arg )
 	x_timer_set( procedure, arg );
 }
 
+/*****************************************************************************
+ * Have the passed procedure called when there is nothing else to do.  It
+ * keeps being called until it returns True.
+ */
+	void
+in_work_proc_set( XtWorkProc procedure, XtPointer arg )
+{
+	x_work_proc_set( procedure, arg );
+}
+
+/*****************************************************************************
+ * Have the passed procedure called whenever there is something to read
+ * on file descriptor 'fd'.
+ */
+	void
+in_add_input( int fd, XtInputCallbackProc procedure, XtPointer arg )
+{
+	x_add_input( fd, procedure, arg );
+}
+
+/*****************************************************************************
+ * Wait for, and handle, the next event, timer, or input.
+ */
+	void
+in_process_event( void )
+{
+	x_process_event();
+}
+
+/*****************************************************************************
+ * Show how a long job is coming along, in a small window with a Cancel
+ * button.  If it is already up, just change the message.  If 'modal' is
+ * TRUE, the other windows don't take input until it is taken down.
+ */
+	void
+in_progress_show( char *message, int modal )
+{
+	x_progress_show( message, modal );
+}
+
+/*****************************************************************************/
+	void
+in_progress_hide( void )
+{
+	x_progress_hide();
+}
+
+/*****************************************************************************
+ * How many frames the next step of the animation should move by, so that it
+ * keeps up with the requested frame rate.
+ */
+	int
+in_timer_frame_advance( void )
+{
+	return( x_timer_frame_advance() );
+}
+
+/*****************************************************************************
+ * The frame rate the animation is actually getting, or 0 if it's stopped.
+ */
+	double
+in_timer_achieved_fps( void )
+{
+	return( x_timer_achieved_fps() );
+}
+
+/*****************************************************************************
+ * The frame being drawn is still being read.  Until in_timer_release is
+ * called, a timer that is set waits instead of starting, so that the
+ * animation doesn't move on before the frame has been shown.
+ */
+	void
+in_timer_hold( void )
+{
+	x_timer_hold();
+}
+
+/*****************************************************************************
+ * The frame is in; start any timer that was waiting for it.
+ */
+	void
+in_timer_release( void )
+{
+	x_timer_release();
+}
+
 /*****************************************************************************
  * Set the sensitivity to the passed button_id to 'True'.  (I.e., 
  * it is currently "greyed out"; undo that.)
@@ -446,6 +593,15 @@ in_flush()
 	x_flush();
 }
 
+/***************************************************************************
+ * Wait until the display has finished everything sent to it
+ */
+	void
+in_sync()
+{
+	x_sync();
+}
+
 /***************************************************************************
  * This is CALLED BY the displying routines, and contains the reported
  * X and Y positions of the cursor in the color-contour window.
@@ -36,6 +36,12 @@ x_flush()
 	XFlush( XtDisplay( topLevel ));
 }
 
+	void
+x_sync()
+{
+	XSync( XtDisplay( topLevel ), False );
+}
+
 	unsigned char
 interp( int i, int range_i, unsigned char *mat, int n_entries )
 {
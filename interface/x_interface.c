@@ -35,10 +35,6 @@
 #include <X11/CoreP.h>
 #include <X11/CoreP.h>
 
-#ifdef INC_PPM
-#include "ppm.h"
-#endif
-
 #define DEFAULT_BUTTON_WIDTH	55
 #define DEFAULT_LABEL_WIDTH	400
 #define DEFAULT_DIMLABEL_WIDTH	95
@@ -151,6 +147,22 @@ static AppData		app_data;
 static Server_Info	server;
 static XtIntervalId	timer;
 
+/* Animation pacing.  frame_started is when the timer that began the current
+ * frame went off; frame_cost is how long (in ms) the last frame took to 
+ * draw, and achieved_fps a running average of the actual frame rate.
+ */
+static XtTimerCallbackProc timer_procedure;
+static XtPointer	timer_client_arg;
+static struct timeval	frame_started, last_frame_started;
+static int		frame_timing_valid = FALSE;
+static double		frame_cost = 0.0, achieved_fps = 0.0;
+static int		in_timer_callback = FALSE;
+
+/* While timer_held, a timer that is set waits (timer_waiting) until the
+ * frame being read in comes up; see x_timer_hold.
+ */
+static int		timer_held = FALSE, timer_waiting = FALSE;
+
 static int		timer_enabled      = FALSE,
 			ccontour_popped_up = FALSE,
 			valid_display;
@@ -169,10 +181,44 @@ Pixmap 			open_circle_pixmap,
 
 static XEvent	event;
 
+/* The last image drawn in the ccontour window is also kept in a pixmap on
+ * the server, so that expose events can be answered with XCopyArea instead
+ * of drawing the image again.  When only part of a large image has been 
+ * drawn, pixmap_block_valid says which PIXMAP_BLOCK x PIXMAP_BLOCK blocks
+ * of the pixmap are good.  Images bigger than PIXMAP_MAX_PIXELS don't get
+ * a pixmap, and are redrawn the old way.
+ */
+#define PIXMAP_BLOCK		64
+#define PIXMAP_MAX_PIXELS	(4096L*4096L)
+
+static Pixmap		ccontour_pixmap = None;
+static size_t		pixmap_width = 0L, pixmap_height = 0L;
+static size_t		pixmap_nbx = 0L, pixmap_nby = 0L;
+static unsigned char	*pixmap_block_valid = NULL;
+
+/* Bounding box of the expose events seen so far in the current burst */
+static int		expose_pending = FALSE;
+static long		expose_x0, expose_y0, expose_x1, expose_y1;
+
+/* With the -pixmap_mem option, each complete frame that is drawn is also
+ * copied into its own pixmap on the server, indexed by frame number, so
+ * that showing it again is just an XCopyArea.  These are held to a budget
+ * of server memory, throwing out the least recently shown first.
+ */
+static Pixmap		*frame_pixmap = NULL;
+static unsigned long	*frame_pixmap_used = NULL;
+static size_t		n_frame_pixmaps = 0L, frame_pixmap_width = 0L, frame_pixmap_height = 0L;
+static size_t		frame_pixmap_bytes = 0L;
+static unsigned long	frame_pixmap_clock = 0L;
+
 static Widget
 	error_popup_widget = NULL,
 		error_popupcanvas_widget,
 			error_popupdialog_widget,
+	progress_popup_widget = NULL,
+		progress_popupcanvas_widget,
+			progress_label_widget,
+			progress_cancel_widget,
 	dimsel_popup_widget,
 		dimsel_popupcanvas_widget,
 			dimsel_ok_button_widget,
@@ -388,6 +434,7 @@ static XtResource resources[] = {
 };
 
 static int	error_popup_done    = FALSE, error_popup_result    = 0;
+static int	progress_modal      = FALSE;
 static int	dimsel_popup_done   = FALSE, dimsel_popup_result   = 0;
 static Cursor	busy_cursor;
 
@@ -424,6 +471,7 @@ void 	blowup_type_mod1(Widget w, XtPointer client_data, XtPointer call_data );
 void 	varsel_menu_select(Widget w, XtPointer client_data, XtPointer call_data );
 void 	range_mod1	(Widget w, XtPointer client_data, XtPointer call_data );
 void 	options_mod1	(Widget w, XtPointer client_data, XtPointer call_data);
+void 	range_mod2	(Widget w, XButtonEvent *e, String *p, Cardinal *n );
 void 	range_mod3	(Widget w, XButtonEvent *e, String *p, Cardinal *n );
 void 	dimset_mod1	(Widget w, XtPointer client_data, XtPointer call_data );
 void 	quit_mod1	(Widget w, XtPointer client_data, XtPointer call_data );
@@ -470,17 +518,23 @@ void 	testf(Widget w, XButtonEvent *e, String *p, Cardinal *n );
 
 static void 	add_callbacks( void );
 static void 	make_tc_data( unsigned char *data, long width, long height, 
-		unsigned char *tc_data );
+		long x0, long y0, long w, long h, unsigned char *tc_data );
 static void 	make_tc_data_24( unsigned char *data, long width, long height, 
-		unsigned char *tc_data );
+		long x0, long y0, long w, long h, unsigned char *tc_data );
 static void 	make_tc_data_16( unsigned char *data, long width, long height, 
-		unsigned char *tc_data );
+		long x0, long y0, long w, long h, unsigned char *tc_data );
 static void 	make_tc_data_32( unsigned char *data, long width, long height, 
-		unsigned char *tc_data );
-#ifdef INC_PPM
-static void 	dump_to_ppm( unsigned char *data, size_t width, size_t height,
-		size_t timestep );
-#endif
+		long x0, long y0, long w, long h, unsigned char *tc_data );
+static void 	dump_frame( unsigned char *data, size_t width, size_t height, size_t timestep );
+static void	pixmap_setup( size_t width, size_t height );
+static void	pixmap_mark_valid( size_t x, size_t y, size_t w, size_t h );
+static int	pixmap_covers( long x, long y, long w, long h );
+static size_t	frame_pixmap_size( void );
+static void	timer_fired( XtPointer client_arg, XtIntervalId *id );
+static double	frame_period_ms( void );
+static double	ms_between( struct timeval *t0, struct timeval *t1 );
+static void	frame_pixmap_drop( size_t frameno );
+static void	progress_cancel_callback( Widget w, XtPointer client_data, XtPointer call_data );
 
 /*************************************************************************************************/
 void x_parse_args( int *p_argc, char **argv )
@@ -657,6 +711,7 @@ void x_initialize()
 		{"diminfo_cur_mod2",	(XtActionProc)diminfo_cur_mod2  },
 		{"diminfo_cur_mod3",	(XtActionProc)diminfo_cur_mod3  },
 		{"diminfo_cur_mod4",	(XtActionProc)diminfo_cur_mod4  },
+		{"range_mod2",		(XtActionProc)range_mod2	},
 		{"range_mod3",		(XtActionProc)range_mod3	},
 		{"blowup_mod2",		(XtActionProc)blowup_mod2	},
 		{"blowup_mod3",		(XtActionProc)blowup_mod3	},
@@ -1136,6 +1191,9 @@ void x_init_widgets_optionbox( Widget parent )
 	XtAugmentTranslations( range_widget,
 		XtParseTranslationTable( 
 			"<Btn3Down>,<Btn3Up>: range_mod3()" ));
+	XtOverrideTranslations( range_widget,
+		XtParseTranslationTable( 
+			"#override Ctrl<Btn1Down>,<Btn1Up>: range_mod2()" ));
 
 	blowup_type_widget = XtVaCreateManagedWidget(
 		"blowup_type",
@@ -1155,43 +1213,13 @@ void x_init_widgets_optionbox( Widget parent )
 }
 
 /*************************************************************************************************
- * If place2insert == 0, then new value will go at head of array vlist; if
- * place2insert == 1, new value will go into second place; etc.
+ * qsort comparison for lists of indices into the array of variable names 'sort_names'
  */
-void insert_into_array( int *vlist, int nlist, int val2insert, int place2insert )
-{
-	int i, n_move_down;
+static char **sort_names;
 
-	n_move_down = nlist - place2insert;
-
-	for( i=0; i<n_move_down; i++ ) 
-		vlist[nlist-i] = vlist[nlist-i-1];
-
-	vlist[place2insert] = val2insert;
-}
-
-/*************************************************************************************************/
-/* 'nlist' is the length of vlist, i.e., the number of variables already in the list; we are 
- * adding the name in array 'names' that has index idx: names[idx]
- */
-void insert_alpha_sorted( NCVar *v, int *vlist, int nlist, int idx, char **names )
+static int var_name_cmp( const void *a, const void *b )
 {
-	int i;
-
-	if( nlist == 0 ) {
-		vlist[nlist] = idx;
-		return;
-		}
-
-	for( i=0; i<nlist; i++ ) {
-		if( strcmp( names[idx], names[ vlist[i] ] ) < 0 ) {
-			insert_into_array( vlist, nlist, idx, i );
-			return;
-			}
-		}
-
-	/* Does not come BEFORE anything in array, so append at end */
-	vlist[nlist] = idx;
+	return( strcmp( sort_names[ *(int *)a ], sort_names[ *(int *)b ] ));
 }
 
 /*************************************************************************************************/
@@ -1229,28 +1257,23 @@ void x_sort_vars_by_ndims( NCVar *v, int **vl_1d, int *n_1d, int **vl_2d, int *n
 		switch( cursor->effective_dimensionality ) {
 			
 			case 1:
-				insert_alpha_sorted( v, *vl_1d, *n_1d, i, names );
-				(*n_1d)++;
+				(*vl_1d)[(*n_1d)++] = i;
 				break;
 
 			case 2:
-				insert_alpha_sorted( v, *vl_2d, *n_2d, i, names );
-				(*n_2d)++;
+				(*vl_2d)[(*n_2d)++] = i;
 				break;
 			
 			case 3:
-				insert_alpha_sorted( v, *vl_3d, *n_3d, i, names );
-				(*n_3d)++;
+				(*vl_3d)[(*n_3d)++] = i;
 				break;
 			
 			case 4:
-				insert_alpha_sorted( v, *vl_4d, *n_4d, i, names );
-				(*n_4d)++;
+				(*vl_4d)[(*n_4d)++] = i;
 				break;
 
 			default:
-				insert_alpha_sorted( v, *vl_other, *n_other, i, names );
-				(*n_other)++;
+				(*vl_other)[(*n_other)++] = i;
 				break;
 			}
 
@@ -1258,6 +1281,14 @@ void x_sort_vars_by_ndims( NCVar *v, int **vl_1d, int *n_1d, int **vl_2d, int *n
 		}
 /* printf( "# vars: 1d=%d 2d=%d 3d=%d 4d=%d 5+d=%d\n", *n_1d, *n_2d, *n_3d, *n_4d, *n_other ); */
 
+	/* Alpha sort each list, once they are all filled in */
+	sort_names = names;
+	qsort( *vl_1d,    *n_1d,    sizeof(int), var_name_cmp );
+	qsort( *vl_2d,    *n_2d,    sizeof(int), var_name_cmp );
+	qsort( *vl_3d,    *n_3d,    sizeof(int), var_name_cmp );
+	qsort( *vl_4d,    *n_4d,    sizeof(int), var_name_cmp );
+	qsort( *vl_other, *n_other, sizeof(int), var_name_cmp );
+
 	free( names );
 }
 
@@ -1916,6 +1947,8 @@ char *x_change_colormap( int delta, int do_widgets_flag )
 		XStoreColors( XtDisplay(topLevel), current_colormap, 
 			current_colormap_list->color_list,
 			options.n_colors+1 );
+	else
+		x_clear_frame_pixmaps();	/* they hold the old colors */
 	pixel_transform = current_colormap_list->pixel_transform;
 
 	return( current_colormap_list->name );
@@ -1923,97 +1956,395 @@ char *x_change_colormap( int delta, int do_widgets_flag )
 
 /*************************************************************************************************/
 void x_draw_2d_field( unsigned char *data, size_t width, size_t height, size_t timestep )
+{
+	if( options.dump_frames )
+		dump_frame( data, width, height, timestep );
+
+	x_draw_2d_region( data, width, height, 0L, 0L, width, height, timestep );
+}
+
+/*************************************************************************************************/
+/* Puts up the w x h part of the width x height image that starts at (x,y).
+ * Only that part of 'data' is looked at or converted.
+ */
+void x_draw_2d_region( unsigned char *data, size_t width, size_t height, 
+		size_t x, size_t y, size_t w, size_t h, size_t timestep )
 {
 	Display	*display;
 	Screen	*screen;
-	static XImage	*ximage;
 	XGCValues values;
-	GC	gc;
 	static	size_t last_width=0L, last_height=0L;
 	static 	unsigned char *tc_data=NULL;
+	static	XImage	*ximage = NULL;
+	static	GC	gc = NULL;
+	double	t0;
 
-#ifdef INC_PPM
-	if( options.dump_frames )
-		dump_to_ppm( data, width, height, timestep );
-#endif
+	if( (w == 0) || (h == 0) || (!valid_display) )
+		return;
 
 	display = XtDisplay( ccontour_widget );
 	screen  = XtScreen ( ccontour_widget );
 
+	/* The XImage, the TrueColor array, and the GC are kept from one
+	 * frame to the next, so that drawing a frame the same size as the
+	 * last one allocates nothing.
+	 */
+	if( (ximage != NULL) && ((width!=last_width) || (height!=last_height)) ) {
+		ximage->data = NULL;	/* the image data is ours, not Xlib's */
+		XDestroyImage( ximage );
+		ximage = NULL;
+		}
+
 	if( options.display_type == TrueColor ) {
 		/* If the TrueColor data array does not yet exist, 
 		 * or is the wrong size, then allocate it.
 		 */
-		if( tc_data == NULL ) {
-			tc_data=(unsigned char *)malloc( server.bitmap_unit*width*height );
-			last_width  = width;
-			last_height = height;
-			}
-		else if( (width!=last_width) || (height!=last_height)) {
-			free( tc_data );
-			last_width  = width;
-			last_height = height;
+		if( (tc_data == NULL) || (ximage == NULL) ) {
+			if( tc_data != NULL )
+				free( tc_data );
 			tc_data=(unsigned char *)malloc( server.bitmap_unit*width*height );
+			if( tc_data == NULL ) {
+				fprintf( stderr, "ncview: x_draw_2d_region: failed on malloc of TrueColor image\n" );
+				exit( -1 );
+				}
 			}
 		/* Convert data to TrueColor representation, with
 		 * the proper number of bytes per pixel
 		 */
-		make_tc_data( data, width, height, tc_data );
+		TIMING_BEGIN( t0 );
+		make_tc_data( data, width, height, x, y, w, h, tc_data );
+		TIMING_END( TIMING_TRUECOLOR, t0 );
 
-		ximage  = XCreateImage(
-			display,
-			XDefaultVisualOfScreen( screen ),
-			XDefaultDepthOfScreen ( screen ),
-			ZPixmap,
-			0,
-			(char *)tc_data, 
-			(unsigned int)width, (unsigned int)height,
-			32, 0 );
+		if( ximage == NULL )
+			ximage  = XCreateImage(
+				display,
+				XDefaultVisualOfScreen( screen ),
+				XDefaultDepthOfScreen ( screen ),
+				ZPixmap,
+				0,
+				(char *)tc_data, 
+				(unsigned int)width, (unsigned int)height,
+				32, 0 );
 		}
 	else /* display_type == PseudoColor */
 		{
-		ximage  = XCreateImage(
+		if( ximage == NULL )
+			ximage  = XCreateImage(
+				display,
+				XDefaultVisualOfScreen( screen ),
+				XDefaultDepthOfScreen ( screen ),
+				ZPixmap,
+				0,
+				(char *)data,
+				(unsigned int)width, (unsigned int)height,
+				8, 0 );
+		/* The pixels can come from a different buffer each time */
+		ximage->data = (char *)data;
+		}
+	last_width  = width;
+	last_height = height;
+
+	if( gc == NULL )
+		gc = XtGetGC( ccontour_widget, (XtGCMask)0, &values );
+
+	/* This is only the time to hand the image to Xlib; the server
+	 * does its part later, on its own time.
+	 */
+	TIMING_BEGIN( t0 );
+	pixmap_setup( width, height );
+	if( ccontour_pixmap != None ) {
+		XPutImage( display, ccontour_pixmap, gc, ximage,
+			(int)x, (int)y, (int)x, (int)y,
+			(unsigned int)w, (unsigned int)h );
+		pixmap_mark_valid( x, y, w, h );
+		XCopyArea( display, ccontour_pixmap, XtWindow( ccontour_widget ), gc,
+			(int)x, (int)y, (unsigned int)w, (unsigned int)h, (int)x, (int)y );
+		}
+	else
+		XPutImage(
 			display,
-			XDefaultVisualOfScreen( screen ),
-			XDefaultDepthOfScreen ( screen ),
-			ZPixmap,
-			0,
-			(char *)data,
-			(unsigned int)width, (unsigned int)height,
-			8, 0 );
+			XtWindow( ccontour_widget ),
+			gc,
+			ximage,
+			(int)x, (int)y, (int)x, (int)y,
+			(unsigned int)w, (unsigned int)h );
+	TIMING_END( TIMING_UPLOAD, t0 );
+}
+
+/*************************************************************************************************/
+/* Forget what is in the backing pixmap; called when a new image is about 
+ * to be drawn a piece at a time.
+ */
+void x_invalidate_2d_backing( void )
+{
+	size_t	i;
+
+	if( pixmap_block_valid == NULL )
+		return;
+	for( i=0; i<pixmap_nbx*pixmap_nby; i++ )
+		*(pixmap_block_valid+i) = FALSE;
+}
+
+/*************************************************************************************************/
+/* Make sure the backing pixmap is the size of the image.  If it can't be
+ * had, ccontour_pixmap is left as None.
+ */
+static void pixmap_setup( size_t width, size_t height )
+{
+	Display	*display;
+
+	if( (width == pixmap_width) && (height == pixmap_height) )
+		return;
+
+	display = XtDisplay( ccontour_widget );
+	if( ccontour_pixmap != None ) {
+		XFreePixmap( display, ccontour_pixmap );
+		ccontour_pixmap = None;
+		}
+	if( pixmap_block_valid != NULL ) {
+		free( pixmap_block_valid );
+		pixmap_block_valid = NULL;
 		}
+	pixmap_width  = width;
+	pixmap_height = height;
 
-	gc = XtGetGC( ccontour_widget, (XtGCMask)0, &values );
+	if( width*height > PIXMAP_MAX_PIXELS )
+		return;
 
-	if( !valid_display )
+	pixmap_nbx = (width  + PIXMAP_BLOCK - 1)/PIXMAP_BLOCK;
+	pixmap_nby = (height + PIXMAP_BLOCK - 1)/PIXMAP_BLOCK;
+	pixmap_block_valid = (unsigned char *)malloc( pixmap_nbx*pixmap_nby );
+	if( pixmap_block_valid == NULL )
 		return;
 
-	XPutImage(
-		display,
-		XtWindow( ccontour_widget ),
-		gc,
-		ximage,
-		0, 0, 0, 0,
-		(unsigned int)width, (unsigned int)height );
+	ccontour_pixmap = XCreatePixmap( display, XtWindow( ccontour_widget ),
+		(unsigned int)width, (unsigned int)height,
+		XDefaultDepthOfScreen( XtScreen( ccontour_widget )));
+	x_invalidate_2d_backing();
+}
+
+/*************************************************************************************************/
+/* Note that the part of the pixmap at (x,y) of size w x h has been drawn.  Only
+ * blocks that are entirely drawn become valid.
+ */
+static void pixmap_mark_valid( size_t x, size_t y, size_t w, size_t h )
+{
+	size_t	bx, by, bx0, bx1, by0, by1;
+
+	if( pixmap_block_valid == NULL )
+		return;
+
+	bx0 = (x + PIXMAP_BLOCK - 1)/PIXMAP_BLOCK;
+	by0 = (y + PIXMAP_BLOCK - 1)/PIXMAP_BLOCK;
+	bx1 = (x+w == pixmap_width)  ? pixmap_nbx : (x+w)/PIXMAP_BLOCK;
+	by1 = (y+h == pixmap_height) ? pixmap_nby : (y+h)/PIXMAP_BLOCK;
+
+	for( by=by0; by<by1; by++ )
+	for( bx=bx0; bx<bx1; bx++ )
+		*(pixmap_block_valid + bx + by*pixmap_nbx) = TRUE;
+}
+
+/*************************************************************************************************/
+/* Returns TRUE if the backing pixmap holds good values for all of the
+ * indicated rectangle.
+ */
+static int pixmap_covers( long x, long y, long w, long h )
+{
+	long	bx, by;
+
+	if( (ccontour_pixmap == None) || (pixmap_block_valid == NULL) )
+		return( FALSE );
+	if( (x < 0) || (y < 0) || (x+w > pixmap_width) || (y+h > pixmap_height) )
+		return( FALSE );
+
+	for( by=y/PIXMAP_BLOCK; by<=(y+h-1)/PIXMAP_BLOCK; by++ )
+	for( bx=x/PIXMAP_BLOCK; bx<=(x+w-1)/PIXMAP_BLOCK; bx++ )
+		if( ! *(pixmap_block_valid + bx + by*pixmap_nbx) )
+			return( FALSE );
+	return( TRUE );
+}
+
+/*************************************************************************************************/
+/* If frame 'frameno' of the given size is held in a pixmap, copy it to the
+ * window and return TRUE.  Otherwise return FALSE.
+ */
+int x_draw_frame_pixmap( size_t frameno, size_t width, size_t height )
+{
+	Display	*display;
+	GC	gc;
+
+	if( (! valid_display) || (frameno >= n_frame_pixmaps) || 
+	    (width != frame_pixmap_width) || (height != frame_pixmap_height) )
+		return( FALSE );
+	if( *(frame_pixmap+frameno) == None )
+		return( FALSE );
+
+	display = XtDisplay( ccontour_widget );
+	gc      = DefaultGCOfScreen( XtScreen( ccontour_widget ));
+
+	/* Keep the backing pixmap the same as the window */
+	pixmap_setup( width, height );
+	if( ccontour_pixmap != None ) {
+		XCopyArea( display, *(frame_pixmap+frameno), ccontour_pixmap, gc,
+			0, 0, (unsigned int)width, (unsigned int)height, 0, 0 );
+		pixmap_mark_valid( 0L, 0L, width, height );
+		}
+	XCopyArea( display, *(frame_pixmap+frameno), XtWindow( ccontour_widget ), gc,
+		0, 0, (unsigned int)width, (unsigned int)height, 0, 0 );
+
+	*(frame_pixmap_used+frameno) = ++frame_pixmap_clock;
+	return( TRUE );
+}
+
+/*************************************************************************************************/
+/* Keep the image just drawn as frame 'frameno'.  This is a copy on the 
+ * server from the backing pixmap, so nothing is sent over the connection.
+ * Nothing is done unless the whole image has been drawn.
+ */
+void x_save_frame_pixmap( size_t frameno, size_t width, size_t height )
+{
+	Display		*display;
+	Pixmap		*new_pixmap;
+	unsigned long	*new_used, oldest_time;
+	size_t		i, budget, size, oldest;
+
+	budget = (size_t)options.pixmap_mem_mb * 1048576L;
+	if( (budget == 0L) || (! valid_display) || options.dump_frames )
+		return;
+	if( (width != pixmap_width) || (height != pixmap_height) || (! pixmap_covers( 0L, 0L, width, height )))
+		return;
+
+	if( (width != frame_pixmap_width) || (height != frame_pixmap_height) ) {
+		x_clear_frame_pixmaps();
+		frame_pixmap_width  = width;
+		frame_pixmap_height = height;
+		}
+
+	if( frameno >= n_frame_pixmaps ) {
+		new_pixmap = (Pixmap *)realloc( frame_pixmap, (frameno+1)*sizeof(Pixmap) );
+		if( new_pixmap == NULL )
+			return;
+		frame_pixmap = new_pixmap;
+		new_used = (unsigned long *)realloc( frame_pixmap_used, (frameno+1)*sizeof(unsigned long) );
+		if( new_used == NULL )
+			return;
+		frame_pixmap_used = new_used;
+		for( i=n_frame_pixmaps; i<=frameno; i++ ) {
+			*(frame_pixmap+i)      = None;
+			*(frame_pixmap_used+i) = 0L;
+			}
+		n_frame_pixmaps = frameno+1;
+		}
+
+	frame_pixmap_drop( frameno );
+
+	size = frame_pixmap_size();
+	if( size > budget )
+		return;
+	while( frame_pixmap_bytes + size > budget ) {
+		oldest      = n_frame_pixmaps;
+		oldest_time = 0L;
+		for( i=0; i<n_frame_pixmaps; i++ ) {
+			if( *(frame_pixmap+i) == None )
+				continue;
+			if( (oldest == n_frame_pixmaps) || (*(frame_pixmap_used+i) < oldest_time) ) {
+				oldest      = i;
+				oldest_time = *(frame_pixmap_used+i);
+				}
+			}
+		if( oldest == n_frame_pixmaps )
+			break;
+		frame_pixmap_drop( oldest );
+		}
+
+	display = XtDisplay( ccontour_widget );
+	*(frame_pixmap+frameno) = XCreatePixmap( display, XtWindow( ccontour_widget ),
+		(unsigned int)width, (unsigned int)height,
+		XDefaultDepthOfScreen( XtScreen( ccontour_widget )));
+	XCopyArea( display, ccontour_pixmap, *(frame_pixmap+frameno), 
+		DefaultGCOfScreen( XtScreen( ccontour_widget )),
+		0, 0, (unsigned int)width, (unsigned int)height, 0, 0 );
+	*(frame_pixmap_used+frameno) = ++frame_pixmap_clock;
+	frame_pixmap_bytes += size;
+}
+
+/*************************************************************************************************/
+/* Throw out all the frame pixmaps */
+void x_clear_frame_pixmaps( void )
+{
+	size_t	i;
+
+	for( i=0; i<n_frame_pixmaps; i++ )
+		frame_pixmap_drop( i );
+}
+
+/*************************************************************************************************/
+static void frame_pixmap_drop( size_t frameno )
+{
+	if( *(frame_pixmap+frameno) == None )
+		return;
+	XFreePixmap( XtDisplay( ccontour_widget ), *(frame_pixmap+frameno) );
+	*(frame_pixmap+frameno) = None;
+	frame_pixmap_bytes -= frame_pixmap_size();
+}
+
+/*************************************************************************************************/
+/* Approximate server memory taken by one frame pixmap */
+static size_t frame_pixmap_size( void )
+{
+	return( frame_pixmap_width * frame_pixmap_height * ((server.bits_per_pixel+7)/8) );
+}
+
+/*************************************************************************************************/
+/* Returns the part of a width x height image in the ccontour widget that 
+ * is showing through the viewport.
+ */
+void x_get_visible_region( size_t width, size_t height, size_t *x, size_t *y, size_t *w, size_t *h )
+{
+	Position	cur_x, cur_y;
+	Dimension	vp_width, vp_height;
+
+	XtVaGetValues( ccontour_widget, 
+		XtNx, &cur_x, 
+		XtNy, &cur_y,
+		NULL );
+	XtVaGetValues( ccontour_viewport_widget, 
+		XtNwidth,  &vp_width, 
+		XtNheight, &vp_height,
+		NULL );
+
+	/* The child moves up and to the left as the viewport scrolls */
+	cur_x = -cur_x;
+	cur_y = -cur_y;
+	if( cur_x < 0 )
+		cur_x = 0;
+	if( cur_y < 0 )
+		cur_y = 0;
+
+	*x = ((size_t)cur_x < width)  ? (size_t)cur_x : width;
+	*y = ((size_t)cur_y < height) ? (size_t)cur_y : height;
+	*w = (*x + vp_width  < width)  ? vp_width  : width  - *x;
+	*h = (*y + vp_height < height) ? vp_height : height - *y;
 }
 
 /*************************************************************************************************/
 /* Converts the byte-scaled data to truecolor representation,
- * using the current color map.  
+ * using the current color map.  Only the w x h part starting at (x0,y0)
+ * is converted; tc_data keeps the layout of the full image.
  */
 static void make_tc_data( unsigned char *data, long width, long height, 
-	unsigned char *tc_data )
+	long x0, long y0, long w, long h, unsigned char *tc_data )
 {
 	switch (server.bytes_per_pixel) {
-		case 4: make_tc_data_32( data, width, height, tc_data );
+		case 4: make_tc_data_32( data, width, height, x0, y0, w, h, tc_data );
 			break;
 
 		case 3:
-			make_tc_data_24( data, width, height, tc_data );
+			make_tc_data_24( data, width, height, x0, y0, w, h, tc_data );
 			break;
 
 		case 2:
-			make_tc_data_16( data, width, height, tc_data );
+			make_tc_data_16( data, width, height, x0, y0, w, h, tc_data );
 			break;
 
 		default:
@@ -2027,13 +2358,12 @@ static void make_tc_data( unsigned char *data, long width, long height,
 
 /*************************************************************************************************/
 static void make_tc_data_16( unsigned char *data, long width, long height, 
-		unsigned char *tc_data )
+		long x0, long y0, long w, long h, unsigned char *tc_data )
 {
 	int	i, j, pix;
 	size_t	pad_offset, po_val;
 
 	/* pad to server.bitmap_pad bits if required */
-	pad_offset = 0L;
 	po_val     = 0L;
 	if( (width%2 != 0) && (server.bits_per_pixel != server.bitmap_pad) ) 
 		po_val = 2L;
@@ -2041,8 +2371,9 @@ static void make_tc_data_16( unsigned char *data, long width, long height,
 	/****************************************
 	 *    Least significant bit first
 	 ****************************************/
-	for( j=0; j<height; j++ ) {
-		for( i=0; i<width; i++ ) {
+	for( j=y0; j<y0+h; j++ ) {
+		pad_offset = j*po_val;
+		for( i=x0; i<x0+w; i++ ) {
 
 			pix = *(data+i+j*width);
 
@@ -2059,13 +2390,12 @@ static void make_tc_data_16( unsigned char *data, long width, long height,
 			*(tc_data+i*2+1+j*(width*2)+pad_offset) +=
 				(unsigned char)((current_colormap_list->color_list+pix)->red>>server.shift_red & server.mask_red );
 			}
-		pad_offset += po_val;
 		}
 }
 
 /*************************************************************************************************/
 static void make_tc_data_24( unsigned char *data, long width, long height, 
-		unsigned char *tc_data )
+		long x0, long y0, long w, long h, unsigned char *tc_data )
 {
 	int	i, j, pix, o_r, o_g, o_b;
 	long	pad_offset, po_val;
@@ -2083,13 +2413,13 @@ static void make_tc_data_24( unsigned char *data, long width, long height,
 		}
 
 	/* pad to server.bitmap_pad bits if required */
-	pad_offset = 0L;
 	po_val     = 0L;
 	if( (((width*3)%4) != 0) && (server.bits_per_pixel != server.bitmap_pad) ) 
 		po_val = (server.bitmap_pad/8) - (width*3)%4;
 
-	for( j=0; j<height; j++ ) {
-		for( i=0; i<width; i++ ) {
+	for( j=y0; j<y0+h; j++ ) {
+		pad_offset = j*po_val;
+		for( i=x0; i<x0+w; i++ ) {
 
 			pix = *(data+i+j*width);
 			*(tc_data+i*3+o_b+j*(width*3)+pad_offset) = 
@@ -2099,13 +2429,12 @@ static void make_tc_data_24( unsigned char *data, long width, long height,
 			*(tc_data+i*3+o_r+j*(width*3)+pad_offset) = 
 				(char)((current_colormap_list->color_list+pix)->red>>8);
 			}
-		pad_offset += po_val;
 		}
 }
 
 /*************************************************************************************************/
 static void make_tc_data_32( unsigned char *data, long width, long height, 
-		unsigned char *tc_data )
+		long x0, long y0, long w, long h, unsigned char *tc_data )
 {
 	int	i, j, pix, o_r, o_g, o_b;
 
@@ -2126,16 +2455,8 @@ static void make_tc_data_32( unsigned char *data, long width, long height,
 		o_b++;
 		}
 
-	for( i=0; i<width; i++ )
-	for( j=0; j<height; j++ ) {
-
-/*
-*(tc_data+i*4+0 +j*(width*4)) = 0;
-*(tc_data+i*4+1 +j*(width*4)) = 0;
-*(tc_data+i*4+2 +j*(width*4)) = 128;
-*(tc_data+i*4+3 +j*(width*4)) = 0;
-printf( "%d ", pix);
-*/
+	for( j=y0; j<y0+h; j++ )
+	for( i=x0; i<x0+w; i++ ) {
 		pix = *(data+i+j*width);
 		*(tc_data+i*4+o_b+j*(width*4)) = 
 			(char)((current_colormap_list->color_list+pix)->blue>>8);
@@ -2145,6 +2466,52 @@ printf( "%d ", pix);
 			(char)((current_colormap_list->color_list+pix)->red>>8);
 		}
 }
+
+/*************************************************************************************************/
+/* For the benchmark program (bench.c), which has no display: pretends to
+ * be a TrueColor server with the given number of bits per pixel and a
+ * grey colormap, and converts the whole width x height image.  Must
+ * never be called when there is a real display.
+ */
+void x_bench_tc_data( int bits_per_pixel, unsigned char *data, long width, long height, 
+		unsigned char *tc_data )
+{
+	static	Cmaplist	bench_cmap;
+	static	XColor		bench_colors[256];
+	int	i;
+
+	if( current_colormap_list == NULL ) {
+		for( i=0; i<256; i++ ) {
+			bench_colors[i].pixel = (unsigned long)i;
+			bench_colors[i].red   = 
+			bench_colors[i].green = 
+			bench_colors[i].blue  = (unsigned short)(i*257);
+			}
+		bench_cmap.color_list = bench_colors;
+		bench_cmap.next       = NULL;
+		bench_cmap.prev       = NULL;
+		bench_cmap.name       = "bench";
+		current_colormap_list = &bench_cmap;
+		}
+
+	server.byte_order      = LSBFirst;
+	server.rgb_order       = ORDER_RGB;
+	server.bits_per_pixel  = bits_per_pixel;
+	server.bytes_per_pixel = bits_per_pixel/8;
+	server.bitmap_unit     = 32;
+	server.bitmap_pad      = 32;
+
+	server.shift_blue = 11;
+	server.shift_red  = 8;
+	server.shift_green_upper = 13;
+	server.shift_green_lower = 5;
+	server.mask_red = 0x00f8;
+	server.mask_green_upper = 0x0007;
+	server.mask_green_lower = 0x00e0;
+	server.mask_blue = 0x001f;
+
+	make_tc_data( data, width, height, 0L, 0L, width, height, tc_data );
+}
 	
 /*************************************************************************************************/
 void x_set_speed_proc( Widget scrollbar, XtPointer client_data, XtPointer position )
@@ -2359,6 +2726,12 @@ void blowup_type_mod1( Widget widget, XtPointer client_data, XtPointer call_data
 	in_button_pressed( BUTTON_BLOWUP_TYPE, MOD_1 );
 }
 
+/*************************************************************************************************/
+void range_mod2( Widget w, XButtonEvent *event, String *params, Cardinal *num_params )
+{
+	in_button_pressed( BUTTON_RANGE, MOD_2 );
+}
+
 /*************************************************************************************************/
 void range_mod3( Widget w, XButtonEvent *event, String *params, Cardinal *num_params )
 {
@@ -2699,20 +3072,146 @@ void x_process_user_input( void )
 }
 	
 /*************************************************************************************************/
+/* Schedule the next animation frame.  This is called just after a frame has
+ * been drawn, so the time it took to draw is taken off the frame period; the
+ * next frame starts one period after this one did, or at once if we are 
+ * already late.
+ */
 void x_timer_set( XtTimerCallbackProc procedure, XtPointer client_arg )
 {
+	struct timeval	now;
+	double		delay;
 	unsigned long	delay_millisec;
 
-	delay_millisec = (long)(350.0 * options.frame_delay) + 10L;
+	timer_procedure  = procedure;
+	timer_client_arg = client_arg;
+	if( timer_held ) {
+		timer_waiting = TRUE;
+		return;
+		}
+
+	delay = frame_period_ms();
+	if( frame_timing_valid ) {
+		gettimeofday( &now, NULL );
+		frame_cost = ms_between( &frame_started, &now );
+		delay -= frame_cost;
+		if( delay < 0.0 )
+			delay = 0.0;
+		}
+	delay_millisec = (unsigned long)(delay + 0.5);
 
 	timer = XtAppAddTimeOut( 
 		x_app_context,
 		delay_millisec,
-		procedure,
-		client_arg );
+		timer_fired,
+		NULL );
 	timer_enabled = TRUE;
 }
 
+/*************************************************************************************************/
+void x_work_proc_set( XtWorkProc procedure, XtPointer client_arg )
+{
+	XtAppAddWorkProc( x_app_context, procedure, client_arg );
+}
+
+/*************************************************************************************************/
+void x_add_input( int fd, XtInputCallbackProc procedure, XtPointer client_arg )
+{
+	XtAppAddInput( x_app_context, fd, (XtPointer)XtInputReadMask, procedure, client_arg );
+}
+
+/*************************************************************************************************/
+void x_process_event( void )
+{
+	XtAppProcessEvent( x_app_context, XtIMAll );
+}
+
+/*************************************************************************************************/
+/* The window that shows how a long job on the worker thread is coming along.
+ * Unlike x_dialog this doesn't wait for anything; it stays up, and the message
+ * is changed, until x_progress_hide.  Cancel stops the job.
+ */
+void x_progress_show( char *message, int modal )
+{
+	Position	width, height, root_x, root_y;
+
+	if( (progress_popup_widget != NULL) && (modal != progress_modal) )
+		x_progress_hide();
+
+	if( progress_popup_widget != NULL ) {
+		XtVaSetValues( progress_label_widget, XtNlabel, message, NULL );
+		return;
+		}
+
+	if( (options.display_type != TrueColor) && valid_display )
+		progress_popup_widget = XtVaCreatePopupShell(
+			"progress_popup",
+			transientShellWidgetClass,
+			topLevel,
+			XtNcolormap, current_colormap,
+			NULL );
+	else
+		progress_popup_widget = XtVaCreatePopupShell(
+			"progress_popup",
+			transientShellWidgetClass,
+			topLevel,
+			NULL );
+
+	progress_popupcanvas_widget = XtVaCreateManagedWidget(
+		"progress_popupcanvas",
+		formWidgetClass,
+		progress_popup_widget,
+		XtNborderWidth, 0,
+		NULL);
+
+	progress_label_widget = XtVaCreateManagedWidget(
+		"progress_label",
+		labelWidgetClass,
+		progress_popupcanvas_widget,
+		XtNlabel, message,
+		XtNborderWidth, 0,
+		XtNresizable, True,
+		NULL );
+
+	progress_cancel_widget = XtVaCreateManagedWidget(
+		"Cancel",
+		commandWidgetClass,
+		progress_popupcanvas_widget,
+		XtNfromVert, progress_label_widget,
+		NULL);
+	XtAddCallback( progress_cancel_widget, XtNcallback, progress_cancel_callback, NULL );
+
+	/* Same place as the dialogs go */
+	XtVaGetValues    ( commandcanvas_widget, XtNwidth,  &width, 
+					XtNheight, &height, NULL );
+	XtTranslateCoords( commandcanvas_widget, (Position)width,
+					(Position)height, &root_x, &root_y );
+	XtVaSetValues    ( progress_popup_widget, XtNx, root_x/2, XtNy, root_y/2, NULL );
+	XtPopup          ( progress_popup_widget, modal ? XtGrabExclusive : XtGrabNone );
+	progress_modal = modal;
+
+	if( options.display_type == PseudoColor )
+		XSetWindowColormap( XtDisplay(topLevel), XtWindow(progress_popup_widget), 
+				current_colormap );
+}
+
+/*************************************************************************************************/
+void x_progress_hide( void )
+{
+	if( progress_popup_widget == NULL )
+		return;
+
+	XtPopdown( progress_popup_widget );
+	XtDestroyWidget( progress_popup_widget );
+	progress_popup_widget = NULL;
+}
+
+/*************************************************************************************************/
+static void progress_cancel_callback( Widget w, XtPointer client_data, XtPointer call_data )
+{
+	worker_cancel_all();
+}
+
 /*************************************************************************************************/
 void x_timer_clear( void )
 {
@@ -2720,6 +3219,118 @@ void x_timer_clear( void )
 		XtRemoveTimeOut( timer );
 		timer_enabled = FALSE;
 		}
+	timer_waiting = FALSE;
+
+	/* The animation routines clear the timer before setting the next one,
+	 * which doesn't mean the animation has stopped.
+	 */
+	if( ! in_timer_callback ) {
+		frame_timing_valid = FALSE;
+		achieved_fps       = 0.0;
+		}
+}
+
+/*************************************************************************************************/
+/* The animation timer went off; note when, keep track of the achieved frame
+ * rate, and draw the next frame.
+ */
+static void timer_fired( XtPointer client_arg, XtIntervalId *id )
+{
+	double	interval;
+
+	timer_enabled = FALSE;
+
+	last_frame_started = frame_started;
+	gettimeofday( &frame_started, NULL );
+	if( frame_timing_valid ) {
+		interval = ms_between( &last_frame_started, &frame_started );
+		if( interval > 0.0 ) {
+			if( achieved_fps == 0.0 )
+				achieved_fps = 1000.0/interval;
+			else
+				achieved_fps = 0.8*achieved_fps + 0.2*(1000.0/interval);
+			}
+		}
+	frame_timing_valid = TRUE;
+
+	in_timer_callback = TRUE;
+	(*timer_procedure)( timer_client_arg, id );
+	in_timer_callback = FALSE;
+
+	/* If no next frame was scheduled, the animation has stopped */
+	if( (! timer_enabled) && (! timer_waiting) ) {
+		frame_timing_valid = FALSE;
+		achieved_fps       = 0.0;
+		}
+}
+
+/*************************************************************************************************/
+/* How many frames the next animation step should move by: 1, unless frame
+ * dropping is on and the last frame took longer than a frame period, in 
+ * which case it is enough to catch up with the clock.
+ */
+int x_timer_frame_advance( void )
+{
+	double	period, n;
+
+	if( (! options.drop_frames) || (! frame_timing_valid) )
+		return( 1 );
+
+	/* With no delay between frames (-bench_play) there is no clock to catch up with */
+	period = frame_period_ms();
+	if( period <= 0.0 )
+		return( 1 );
+
+	/* Capped so that it stays an int after change_view applies the skip */
+	n = frame_cost / period;
+	if( n < 1.0 )
+		return( 1 );
+	if( n > 1000000.0 )
+		return( 1000000 );
+	return( (int)n );
+}
+
+/*************************************************************************************************/
+/* Returns the frame rate being achieved by the animation, or 0 if it is not running */
+double x_timer_achieved_fps( void )
+{
+	return( achieved_fps );
+}
+
+/*************************************************************************************************/
+void x_timer_hold( void )
+{
+	timer_held = TRUE;
+}
+
+/*************************************************************************************************/
+/* The frame is up, so start the timer for the next one if it was set meanwhile.
+ * The time spent reading counts as part of drawing the frame.
+ */
+void x_timer_release( void )
+{
+	timer_held = FALSE;
+	if( timer_waiting ) {
+		timer_waiting = FALSE;
+		x_timer_set( timer_procedure, timer_client_arg );
+		}
+}
+
+/*************************************************************************************************/
+static double frame_period_ms( void )
+{
+	if( options.bench_play > 0 )
+		return( 0.0 );
+	if( options.target_fps > 0.0 )
+		return( 1000.0/options.target_fps );
+	return( 350.0 * options.frame_delay + 10.0 );
+}
+
+/*************************************************************************************************/
+static double ms_between( struct timeval *t0, struct timeval *t1 )
+{
+	return( (double)(t1->tv_sec  - t0->tv_sec )*1000.0 + 
+		(double)(t1->tv_usec - t0->tv_usec)/1000.0 );
 }
 
 /*************************************************************************************************/
@@ -3662,8 +4273,49 @@ void expose_ccontour( Widget w, XtPointer client_data, XExposeEvent *event, Bool
 		return;
 		}
 
-	if( (event->count == 0) && (event->width > 1) && (event->height > 1))
-		view_draw( TRUE );
+	/* Gather up the whole burst of expose events into one rectangle, 
+	 * including any more that are already waiting in the queue
+	 */
+	do {
+		if( (event->width > 1) && (event->height > 1)) {
+			if( ! expose_pending ) {
+				expose_x0 = event->x;
+				expose_y0 = event->y;
+				expose_x1 = event->x + event->width;
+				expose_y1 = event->y + event->height;
+				expose_pending = TRUE;
+				}
+			else
+				{
+				if( event->x < expose_x0 )
+					expose_x0 = event->x;
+				if( event->y < expose_y0 )
+					expose_y0 = event->y;
+				if( event->x + event->width > expose_x1 )
+					expose_x1 = event->x + event->width;
+				if( event->y + event->height > expose_y1 )
+					expose_y1 = event->y + event->height;
+				}
+			}
+		if( event->count != 0 )
+			return;
+		}
+	while( XCheckTypedWindowEvent( XtDisplay(w), XtWindow(w), Expose, (XEvent *)event ));
+
+	if( ! expose_pending )
+		return;
+	expose_pending = FALSE;
+
+	if( pixmap_covers( expose_x0, expose_y0, expose_x1-expose_x0, expose_y1-expose_y0 )) {
+		XCopyArea( XtDisplay(w), ccontour_pixmap, XtWindow(w), 
+			DefaultGCOfScreen( XtScreen(w) ),
+			(int)expose_x0, (int)expose_y0, 
+			(unsigned int)(expose_x1-expose_x0), (unsigned int)(expose_y1-expose_y0),
+			(int)expose_x0, (int)expose_y0 );
+		return;
+		}
+
+	view_expose();
 }
 
 /*************************************************************************************************/
@@ -3775,7 +4427,7 @@ void x_draw_colorbar()
 		/* Convert data to TrueColor representation, with
 		 * the proper number of bytes per pixel
 		 */
-		make_tc_data( data, width, height, tc_data );
+		make_tc_data( data, width, height, 0L, 0L, width, height, tc_data );
 
 		ximage  = XCreateImage(
 			display,
@@ -3852,39 +4504,26 @@ void x_set_colormap_form_width( int width )
 	XtVaSetValues( colorbar_form_widget, XtNwidth, width, NULL );
 }
 
-#ifdef INC_PPM
 /*************************************************************************************************/
-void dump_to_ppm( unsigned char *data, size_t width, size_t height, size_t frameno )
+/* Hand the frame to the frame writer, along with the colors of the current colormap.
+ * The palette is indexed by pixel value, which on a PseudoColor display is the
+ * colorcell rather than the colormap entry.
+ */
+static void dump_frame( unsigned char *data, size_t width, size_t height, size_t frameno )
 {
-	pixel   **temp_array, ppm_pixel;
-	pixval	r, g, b, max;
-	int	i, j, pix;
-	char	filename[2048];
-	FILE	*out_file;
-
-	sprintf( filename, "frame.%05ld.ppm", frameno );
-	frameno++;
+	unsigned char	palette[256][3];
+	int		i;
+	XColor		*color;
 
-	if( (out_file = fopen( filename, "w" )) == NULL ) {
-		fprintf( stderr, "ncview: can't open file %s for writing\n", filename );
-		return;
+	memset( palette, 0, sizeof(palette) );
+	for( i=0; i<options.n_colors+N_EXTRA_COLORS; i++ ) {
+		color = current_colormap_list->color_list+i;
+		if( color->pixel > 255 )
+			continue;
+		palette[color->pixel][0] = (unsigned char)(color->red   >> 8);
+		palette[color->pixel][1] = (unsigned char)(color->green >> 8);
+		palette[color->pixel][2] = (unsigned char)(color->blue  >> 8);
 		}
 
-	temp_array = ppm_allocarray(width, height );
-	for( j=0; j<height; j++ )
-	for( i=0; i<width;  i++ ) {
-		pix = *(data+i+j*width);
-		r = (pixval)((current_colormap_list->color_list+pix)->red >> 8);
-		g = (pixval)((current_colormap_list->color_list+pix)->green >> 8);
-		b = (pixval)((current_colormap_list->color_list+pix)->blue >> 8);
-		PPM_ASSIGN( ppm_pixel, r, g, b );
-		*(temp_array[j]+i) = ppm_pixel;
-		}	
-
-	max = PPM_MAXMAXVAL;
-	ppm_writeppm( out_file, temp_array, width, height, max, FALSE );
-
-	fclose(out_file);
-	ppm_freearray( temp_array, height );
+	frameexport_put( data, width, height, frameno, palette );
 }
-#endif
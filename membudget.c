@@ -0,0 +1,313 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2008 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrean
+ * San Diego, CA   92122
+ * pierce@cirrus.ucsd.edu
+ */
+
+/*******************************************************************************
+ * 	membudget.c
+ *
+ *	Keeps count of the memory held by the big allocations (the view's
+ *	data and pixels, the render buffers, dim values, overlays, the XY
+ *	plot, the frame store, and the slab cache), each under its own
+ *	subsystem, and holds their total under the -memlimit limit.
+ *
+ *	Subsystems that are caches register an eviction routine.  When
+ *	something needs room, the cache holding the most is asked to give
+ *	some up, then the next, and so on, until there is room or nothing
+ *	more can be evicted.  A cache that can't get room just doesn't
+ *	keep the entry.  Things that have to be allocated go through
+ *	membudget_malloc, which returns NULL (for the caller to tell the
+ *	user about) rather than going over the limit; the same thing
+ *	happens if malloc itself fails with all the caches emptied.
+ *
+ *	With no limit (the default), the counts are still kept, and a
+ *	failed malloc still empties the caches and tries again.
+ *
+ *	Eviction only happens when adding to a cache or allocating with
+ *	membudget_malloc, never from membudget_charge, so data handed out
+ *	by a cache stays good while a frame is being rendered.
+ *******************************************************************************/
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#include <pthread.h>
+
+extern Options options;
+
+static char *subsys_name[MEM_N_SUBSYSTEMS] = {
+	"view", "render", "dims", "overlay", "plot", "frames", "slabs" };
+
+static size_t	limit = 0L;
+static size_t	held[MEM_N_SUBSYSTEMS];
+static size_t	peak = 0L;
+static size_t	(*evict_proc[MEM_N_SUBSYSTEMS])( size_t want );
+static pthread_mutex_t	lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t	total_held( void );
+static int	make_room( size_t bytes );
+static void	evict_all( void );
+
+/*******************************************************************************
+ * Set the limit, in bytes, on the total held by all subsystems; 0 means no
+ * limit.
+ */
+	void
+membudget_init( size_t limit_bytes )
+{
+	limit = limit_bytes;
+}
+
+/*******************************************************************************
+ * Register the routine that the passed cache subsystem uses to throw out
+ * entries.  It is asked to free at least 'want' bytes, and returns how many
+ * it actually freed (0 if it is empty).  It must give them back with
+ * membudget_release.
+ */
+	void
+membudget_set_evict( int subsys, size_t (*evict)( size_t want ) )
+{
+	evict_proc[subsys] = evict;
+}
+
+/*******************************************************************************
+ * Used by the caches before adding 'bytes' worth of entry.  Makes room by
+ * evicting from the caches, and if the entry then fits, charges it to the
+ * subsystem and returns TRUE.  Otherwise returns FALSE, and the entry
+ * should not be kept.
+ */
+	int
+membudget_reserve( int subsys, size_t bytes )
+{
+	if( ! make_room( bytes ))
+		return( FALSE );
+	membudget_charge( subsys, bytes );
+	return( TRUE );
+}
+
+/*******************************************************************************
+ * Count 'bytes' against the subsystem, whether or not it fits.  This never
+ * evicts anything.
+ */
+	void
+membudget_charge( int subsys, size_t bytes )
+{
+	size_t	total;
+
+	pthread_mutex_lock( &lock );
+	held[subsys] += bytes;
+	total = total_held();
+	if( total > peak )
+		peak = total;
+	pthread_mutex_unlock( &lock );
+}
+
+/*******************************************************************************/
+	void
+membudget_release( int subsys, size_t bytes )
+{
+	pthread_mutex_lock( &lock );
+	if( bytes > held[subsys] ) {
+		fprintf( stderr, "ncview: membudget_release: releasing %ld bytes from %s, which only holds %ld\n",
+			(long)bytes, subsys_name[subsys], (long)held[subsys] );
+		bytes = held[subsys];
+		}
+	held[subsys] -= bytes;
+	pthread_mutex_unlock( &lock );
+}
+
+/*******************************************************************************
+ * Allocate something that has to be held, charged to the subsystem.  The
+ * caches are emptied as far as needed to make room for it.  Returns NULL if
+ * it would go over the limit or malloc fails; the caller should tell the
+ * user and carry on without it.  Free it with membudget_free.
+ */
+	void *
+membudget_malloc( int subsys, size_t bytes )
+{
+	void	*p;
+
+	if( ! make_room( bytes )) {
+		if( options.debug )
+			fprintf( stderr, "membudget: %ld bytes for %s would go over the limit\n",
+				(long)bytes, subsys_name[subsys] );
+		return( NULL );
+		}
+
+	p = malloc( bytes );
+	if( p == NULL ) {
+		/* Give up everything that can be given up and try once more */
+		evict_all();
+		p = malloc( bytes );
+		if( p == NULL ) {
+			fprintf( stderr, "ncview: failed on malloc of %.1f MB for %s\n",
+				(double)bytes/1048576.0, subsys_name[subsys] );
+			return( NULL );
+			}
+		}
+
+	membudget_charge( subsys, bytes );
+	return( p );
+}
+
+/*******************************************************************************
+ * Free something gotten from membudget_malloc; 'bytes' is the size that was
+ * asked for.
+ */
+	void
+membudget_free( int subsys, void *p, size_t bytes )
+{
+	if( p == NULL )
+		return;
+	free( p );
+	membudget_release( subsys, bytes );
+}
+
+/*******************************************************************************
+ * A short description of how much is in use, for the info panel.  's' must
+ * have room for at least 64 characters.
+ */
+	void
+membudget_usage_string( char *s )
+{
+	size_t	total;
+
+	pthread_mutex_lock( &lock );
+	total = total_held();
+	pthread_mutex_unlock( &lock );
+
+	if( limit > 0 )
+		sprintf( s, "mem %.0f of %.0f MB", (double)total/1048576.0, (double)limit/1048576.0 );
+	else
+		sprintf( s, "mem %.0f MB", (double)total/1048576.0 );
+}
+
+/*******************************************************************************
+ * How much each subsystem holds.  's' must have room for at least
+ * 40*MEM_N_SUBSYSTEMS characters.
+ */
+	void
+membudget_stats_string( char *s )
+{
+	int	i;
+
+	pthread_mutex_lock( &lock );
+	sprintf( s, "%.1f MB (peak %.1f MB):", (double)total_held()/1048576.0, (double)peak/1048576.0 );
+	for( i=0; i<MEM_N_SUBSYSTEMS; i++ )
+		sprintf( s+strlen(s), " %s %.1f", subsys_name[i], (double)held[i]/1048576.0 );
+	pthread_mutex_unlock( &lock );
+}
+
+/*******************************************************************************
+ * Turn a size like "4G", "512M", "800000K", or "1.5g" into bytes.  A plain
+ * number is taken to be in megabytes.  Returns 0 if it can't be read.
+ */
+	size_t
+membudget_parse_size( char *s )
+{
+	double	val;
+	char	*end;
+
+	val = strtod( s, &end );
+	if( (end == s) || (val <= 0.0) )
+		return( 0L );
+
+	switch( *end ) {
+		case 'k': case 'K': val *= 1024.0;		  end++; break;
+		case 'm': case 'M': val *= 1048576.0;		  end++; break;
+		case 'g': case 'G': val *= 1073741824.0;	  end++; break;
+		case 't': case 'T': val *= 1099511627776.0;	  end++; break;
+		case '\0':	    val *= 1048576.0;		  break;
+		default:	    return( 0L );
+		}
+	if( (*end == 'b') || (*end == 'B') )
+		end++;
+	if( *end != '\0' )
+		return( 0L );
+
+	return( (size_t)val );
+}
+
+/*******************************************************************************/
+	static size_t
+total_held( void )
+{
+	int	i;
+	size_t	total;
+
+	total = 0L;
+	for( i=0; i<MEM_N_SUBSYSTEMS; i++ )
+		total += held[i];
+	return( total );
+}
+
+/*******************************************************************************
+ * Evict from the caches, biggest first, until 'bytes' more would fit under
+ * the limit.  Returns FALSE if that can't be done.  The lock is not held
+ * while a cache is evicting, since it calls membudget_release.
+ */
+	static int
+make_room( size_t bytes )
+{
+	int	i, biggest, tried[MEM_N_SUBSYSTEMS];
+	size_t	total, freed;
+
+	if( limit == 0L )
+		return( TRUE );
+
+	for( i=0; i<MEM_N_SUBSYSTEMS; i++ )
+		tried[i] = FALSE;
+
+	for( ;; ) {
+		pthread_mutex_lock( &lock );
+		total = total_held();
+		if( total + bytes <= limit ) {
+			pthread_mutex_unlock( &lock );
+			return( TRUE );
+			}
+		biggest = -1;
+		for( i=0; i<MEM_N_SUBSYSTEMS; i++ )
+			if( (evict_proc[i] != NULL) && (! tried[i]) && (held[i] > 0) &&
+			    ((biggest == -1) || (held[i] > held[biggest])) )
+				biggest = i;
+		pthread_mutex_unlock( &lock );
+
+		if( biggest == -1 )
+			return( FALSE );
+
+		freed = (*evict_proc[biggest])( total + bytes - limit );
+		if( options.debug )
+			fprintf( stderr, "membudget: evicted %ld bytes from %s\n", (long)freed, subsys_name[biggest] );
+		tried[biggest] = TRUE;
+		}
+}
+
+/*******************************************************************************/
+	static void
+evict_all( void )
+{
+	int	i;
+
+	for( i=0; i<MEM_N_SUBSYSTEMS; i++ )
+		if( evict_proc[i] != NULL )
+			(*evict_proc[i])( (size_t)-1 );
+}
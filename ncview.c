@@ -47,6 +47,10 @@
 #define DEFAULT_BLOWUP_TYPE	BLOWUP_BILINEAR
 #define DEFAULT_SHRINK_METHOD	SHRINK_METHOD_MEAN
 #define DEFAULT_SAVEFRAMES	TRUE
+#define DEFAULT_FRAME_MEM_MB	256
+#define DEFAULT_DATA_MEM_MB	256
+#define DEFAULT_PIXMAP_MEM_MB	0
+#define DEFAULT_BATCH_PREFIX	"frame"
 #define DEFAULT_NO_AUTOFLIP	FALSE
 #define DEFAULT_LISTSEL_MAX	40
 #define DEFAULT_COLOR_BY_NDIMS	TRUE
@@ -64,17 +68,31 @@ int iUseVarLength;
 static void init_cmaps_from_data();
 static void init_cmap_from_data( char *colormap_name, int *data );
 static int get_cmaps_from_dir( char *dir_name );
+static void create_colormap( char *colormap_name, unsigned char r[256], unsigned char g[256], 
+				unsigned char b[256] );
+static int batch_requested( int argc, char **argv );
 
 /***********************************************************************************************/
 	int
 main( int argc, char **argv )
 {
 	Stringlist *input_files;
+	double	t0;
+
+#ifdef NCVIEW_BENCH
+	/* The benchmark program (bench.c) is this file compiled with NCVIEW_BENCH */
+	exit( bench_main( argc, argv ));
+#endif
 
 	initialize_misc             ();
-	in_parse_args               ( &argc, argv );
+	if( ! batch_requested( argc, argv ))	/* -batch must not need a display */
+		in_parse_args       ( &argc, argv );
 	input_files = parse_options ( argc,  argv );
+	if( options.timing )
+		timing_init( options.timing_trace );
 	determine_file_type         ( input_files );
+	membudget_init              ( options.mem_limit );
+	slabcache_init              ( (size_t)options.data_mem_mb * 1048576L );
 
 	options.window_title = input_files->string;
 	options.blowup       = 1;
@@ -87,7 +105,12 @@ main( int argc, char **argv )
 		exit( -1 );
 		}
 
+	if( options.batch_var != NULL )
+		exit( batch_render() );
+
+	TIMING_BEGIN( t0 );
 	initialize_display_interface(); 
+	TIMING_END( TIMING_WIDGETS, t0 );
 	print_init();
 	overlay_init();
 
@@ -97,6 +120,13 @@ main( int argc, char **argv )
 		in_indicate_active_var( variables->name );
 		}
 
+	/* Long jobs, and reading frames, go on the worker thread.  The
+	 * benchmark uses it too, so that it times what the user sees.
+	 */
+	worker_init();
+	if( options.bench_play > 0 )
+		bench_play_init();
+
 	process_user_input();
 
 	return(0);
@@ -170,15 +200,193 @@ parse_options( int argc, char *argv[] )
 				exit( 0 );
 				}
 
+			else if( strncmp( argv[i], "-pixmap_mem", 11 ) == 0 ) {
+				if( (i == (argc-1)) || (sscanf( argv[i+1], "%d", &(options.pixmap_mem_mb) ) != 1) ||
+				    (options.pixmap_mem_mb < 0)) {
+					fprintf( stderr, "Error, -pixmap_mem must be followed by a number of megabytes (0 to turn off)\n" );
+					exit( -1 );
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-progressive", 12 ) == 0 )
+				options.progressive = TRUE;
+
 			else if( strncmp( argv[i], "-pri", 4 ) == 0 )
 				options.private_colormap = TRUE;
 
+			else if( strncmp( argv[i], "-data_mem", 9 ) == 0 ) {
+				if( (i == (argc-1)) || (sscanf( argv[i+1], "%d", &(options.data_mem_mb) ) != 1) ||
+				    (options.data_mem_mb < 0)) {
+					fprintf( stderr, "Error, -data_mem must be followed by a number of megabytes (0 to turn off)\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
 			else if( strncmp( argv[i], "-deb", 4 ) == 0 )
 				options.debug = TRUE;
 
+			else if( strncmp( argv[i], "-batch_axes", 11 ) == 0 ) {
+				if( (i == (argc-1)) || ((comma_ptr = strchr( argv[i+1], ',' )) == NULL) ) {
+					fprintf( stderr, "Error, -batch_axes must be followed by the X and Y dimension names, as in: -batch_axes lon,lat\n" );
+					exit( -1 );
+					}
+				*comma_ptr = '\0';
+				options.batch_x_dim = argv[i+1];
+				options.batch_y_dim = comma_ptr+1;
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-batch_range", 12 ) == 0 ) {
+				if( (i == (argc-1)) || (sscanf( argv[i+1], "%f,%f", &(options.batch_min), 
+						&(options.batch_max) ) != 2) ) {
+					fprintf( stderr, "Error, -batch_range must be followed by the minimum and maximum, as in: -batch_range 270,310\n" );
+					exit( -1 );
+					}
+				options.batch_have_range = TRUE;
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-batch_cmap", 11 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -batch_cmap must be followed by a colormap name\n" );
+					exit( -1 );
+					}
+				options.batch_cmap = argv[++i];
+				}
+
+			else if( strncmp( argv[i], "-batch_mag", 10 ) == 0 ) {
+				if( (i == (argc-1)) || (sscanf( argv[i+1], "%d", &(options.batch_mag) ) != 1) ||
+				    (options.batch_mag == 0) ) {
+					fprintf( stderr, "Error, -batch_mag must be followed by a magnification (negative to shrink, as in -batch_mag -2)\n" );
+					exit( -1 );
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-batch_frames", 13 ) == 0 ) {
+				if( (i == (argc-1)) || (sscanf( argv[i+1], "%ld,%ld", &(options.batch_first), 
+						&(options.batch_last) ) != 2) || (options.batch_first < 1) ||
+				    (options.batch_last < options.batch_first) ) {
+					fprintf( stderr, "Error, -batch_frames must be followed by the first and last frames (counting from 1), as in: -batch_frames 1,100\n" );
+					exit( -1 );
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-batch_out", 10 ) == 0 ) {
+				if( (i == (argc-1)) || (strlen( argv[i+1] ) > 1024) ) {
+					fprintf( stderr, "Error, -batch_out must be followed by the prefix for the image file names\n" );
+					exit( -1 );
+					}
+				options.batch_prefix = argv[++i];
+				}
+
+			else if( strncmp( argv[i], "-batch_threads", 14 ) == 0 ) {
+				if( (i == (argc-1)) || (sscanf( argv[i+1], "%d", &(options.batch_threads) ) != 1) ||
+				    (options.batch_threads < 1) ) {
+					fprintf( stderr, "Error, -batch_threads must be followed by the number of threads to write images with\n" );
+					exit( -1 );
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-batch", 6 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -batch must be followed by the name of the variable to render\n" );
+					exit( -1 );
+					}
+				options.batch_var = argv[++i];
+				}
+
+			else if( strncmp( argv[i], "-autorange_smooth", 17 ) == 0 ) {
+				if( (i == (argc-1)) || (sscanf( argv[i+1], "%f", &(options.range_smooth) ) != 1) ||
+				    (options.range_smooth < 0.0) || (options.range_smooth >= 1.0)) {
+					fprintf( stderr, "Error, -autorange_smooth must be followed by a number from 0 up to (but not including) 1\n" );
+					exit( -1 );
+					}
+				options.range_mode = RANGE_MODE_FRAME;
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-autorange", 10 ) == 0 )
+				options.range_mode = RANGE_MODE_FRAME;
+
+			else if( strncmp( argv[i], "-bench_play", 11 ) == 0 ) {
+				if( (i == (argc-1)) || (sscanf( argv[i+1], "%ld", &(options.bench_play) ) != 1) ||
+				    (options.bench_play < 1) ) {
+					fprintf( stderr, "Error, -bench_play must be followed by the number of frames to play\n" );
+					exit( -1 );
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-bench_mag", 10 ) == 0 ) {
+				if( (i == (argc-1)) || (sscanf( argv[i+1], "%d", &(options.bench_mag) ) != 1) ||
+				    (options.bench_mag == 0) || (options.bench_mag == -1) ) {
+					fprintf( stderr, "Error, -bench_mag must be followed by a magnification (negative to shrink, as in -bench_mag -2)\n" );
+					exit( -1 );
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-no_saveframes", 14 ) == 0 )
+				options.save_frames = FALSE;
+
 			else if( strncmp( argv[i], "-beep", 5 ) == 0 )
 				options.beep_on_restart = TRUE;
 
+			else if( strncmp( argv[i], "-frame_mem", 10 ) == 0 ) {
+				if( (i == (argc-1)) || (sscanf( argv[i+1], "%d", &(options.frame_mem_mb) ) != 1) ||
+				    (options.frame_mem_mb < 0)) {
+					fprintf( stderr, "Error, -frame_mem must be followed by a number of megabytes (0 for no limit)\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-memlimit", 9 ) == 0 ) {
+				if( (i == (argc-1)) || ((options.mem_limit = membudget_parse_size( argv[i+1] )) == 0L)) {
+					fprintf( stderr, "Error, -memlimit must be followed by a size, such as 4G or 800M\n" );
+					exit(-1);
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-timing_trace", 13 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -timing_trace must be followed by the name of the file to write\n" );
+					exit( -1 );
+					}
+				options.timing       = TRUE;
+				options.timing_trace = argv[++i];
+				}
+
+			else if( strncmp( argv[i], "-timing", 7 ) == 0 )
+				options.timing = TRUE;
+
+			else if( strncmp( argv[i], "-frames_y4m", 11 ) == 0 ) {
+				if( i == (argc-1) ) {
+					fprintf( stderr, "Error, -frames_y4m must be followed by the name of the file to write\n" );
+					exit( -1 );
+					}
+				options.dump_frames = TRUE;
+				options.frames_y4m  = argv[++i];
+				}
+
+			else if( strncmp( argv[i], "-fps", 4 ) == 0 ) {
+				if( (i == (argc-1)) || (sscanf( argv[i+1], "%f", &(options.target_fps) ) != 1) ||
+				    (options.target_fps < 0.0)) {
+					fprintf( stderr, "Error, -fps must be followed by a number of frames per second\n" );
+					exit( -1 );
+					}
+				i++;
+				}
+
+			else if( strncmp( argv[i], "-dropframes", 11 ) == 0 )
+				options.drop_frames = TRUE;
+
 			else if( strncmp( argv[i], "-fra", 4 ) == 0 )
 				options.dump_frames = TRUE;
 
@@ -317,10 +525,34 @@ initialize_misc()
 	options.small  		 = FALSE;
 	options.blowup_type      = DEFAULT_BLOWUP_TYPE;
 	options.save_frames      = DEFAULT_SAVEFRAMES;
+	options.frame_mem_mb     = DEFAULT_FRAME_MEM_MB;
+	options.data_mem_mb      = DEFAULT_DATA_MEM_MB;
+	options.pixmap_mem_mb    = DEFAULT_PIXMAP_MEM_MB;
+	options.mem_limit        = 0L;
+	options.progressive      = FALSE;
+	options.target_fps       = 0.0;
+	options.drop_frames      = FALSE;
+	options.batch_var        = NULL;
+	options.batch_x_dim      = NULL;
+	options.batch_y_dim      = NULL;
+	options.batch_cmap       = NULL;
+	options.batch_prefix     = DEFAULT_BATCH_PREFIX;
+	options.batch_have_range = FALSE;
+	options.batch_mag        = 1;
+	options.batch_first      = 0L;
+	options.batch_last       = 0L;
+	options.batch_threads    = 0;
+	options.bench_play       = 0L;
+	options.bench_mag        = 0;
 	options.no_autoflip      = DEFAULT_NO_AUTOFLIP;
 	options.t_conv      	 = TRUE;
 	options.varsel_style	 = VARSEL_LIST;
 	options.dump_frames	 = FALSE;
+	options.frames_y4m	 = NULL;
+	options.range_mode	 = RANGE_MODE_GLOBAL;
+	options.range_smooth	 = 0.0;
+	options.timing		 = FALSE;
+	options.timing_trace	 = NULL;
 	options.listsel_max	 = DEFAULT_LISTSEL_MAX;
 	options.color_by_ndims	 = DEFAULT_COLOR_BY_NDIMS;
 	options.auto_overlay	 = DEFAULT_AUTO_OVERLAY;
@@ -328,12 +560,17 @@ initialize_misc()
 
 	options.overlay          = (OverlayOptions *)malloc( sizeof( OverlayOptions ));
 	options.overlay->doit    = FALSE;
-	options.overlay->overlay = NULL;
+	options.overlay->points  = NULL;
+	options.overlay->n_points= 0L;
 
 	options.maxsize_pct	 = 75;	/* maximum size of a window, in percent of screen, before switching to scrollbars */
 
-	framestore.frame = NULL;
-	framestore.valid = FALSE;
+	framestore.frame     = NULL;
+	framestore.frame_len = NULL;
+	framestore.last_used = NULL;
+	framestore.decode    = NULL;
+	framestore.encode    = NULL;
+	framestore.valid     = FALSE;
 }
 
 /***********************************************************************************************/
@@ -442,7 +679,7 @@ init_cmap_from_data( char *colormap_name, int *data )
                 printf("%d %f %f %f,\\\n",i,r[i]/255.,g[i]/255.,b[i]/255.);
 		}
 
-	in_create_colormap( colormap_name, r, g, b );
+	create_colormap( colormap_name, r, g, b );
 }
 
 /***********************************************************************************************/
@@ -519,7 +756,20 @@ init_cmap_from_file( char *dir_name, char *file_name )
 		b[i] = (unsigned char)b_entry;
 		}
 
-	in_create_colormap( colormap_name, r, g, b );
+	create_colormap( colormap_name, r, g, b );
+}
+
+/***********************************************************************************************/
+/* In -batch mode there is no display to make the colormaps on, so they
+ * are handed to the batch renderer instead.
+ */
+	static void
+create_colormap( char *colormap_name, unsigned char r[256], unsigned char g[256], unsigned char b[256] )
+{
+	if( options.batch_var != NULL )
+		batch_add_colormap( colormap_name, r, g, b );
+	else
+		in_create_colormap( colormap_name, r, g, b );
 }
 
 /***********************************************************************************************/
@@ -535,9 +785,7 @@ initialize_file_interface( Stringlist *input_files )
 		fi_initialize( input_files->string, nfiles );
 		input_files = input_files->next;
 		}
-	if( options.debug ) 
-		fprintf( stderr, "Calculating dim min & maxes...\n" );
-	calc_dim_minmaxes();
+	/* Dim info is only read when a variable is first selected; see load_var_dims() */
 
 	/* Get the effective dimensionality of all the vars.
 	 * Can't do this before we have read in all of the
@@ -582,6 +830,7 @@ process_user_input()
 	void
 quit_app()
 {
+	frameexport_close();
 	exit( 0 );
 }
 
@@ -609,7 +858,23 @@ create_default_colormap()
 		b[i] = 255-i;
 		}
 
-	in_create_colormap( "default", r, g, b );
+	create_colormap( "default", r, g, b );
+}
+
+/***********************************************************************************************/
+/* This has to be known before the options are parsed, since otherwise
+ * the display gets opened first.
+ */
+	static int
+batch_requested( int argc, char **argv )
+{
+	int	i;
+
+	for( i=1; i<argc; i++ )
+		if( strcmp( argv[i], "-batch" ) == 0 )
+			return( TRUE );
+
+	return( FALSE );
 }
 
 /***********************************************************************************************/
@@ -626,11 +891,42 @@ fprintf( stderr, "		by scanning every third time entry (\"-minmax fast\"),\n" );
 fprintf( stderr, "		every fifth time entry (\"-minmax med\"), every tenth\n" );
 fprintf( stderr, "		(\"-minmax slow\"), or all entries (\"-minmax all\").\n" );
 fprintf( stderr, "	-frames: Dump out PPM images (to make a movie, for instance)\n" );
+fprintf( stderr, "	-frames_y4m FILE: Dump the frames into one YUV4MPEG2 video stream instead\n" );
+fprintf( stderr, "	-batch VAR: Without using the display, write the frames of VAR to PPM files and exit.\n" );
+fprintf( stderr, "		These options go with it:\n" );
+fprintf( stderr, "		-batch_axes X,Y: dimensions to use as the X and Y axes\n" );
+fprintf( stderr, "		-batch_range MIN,MAX: data range for the colormap (default: from the data)\n" );
+fprintf( stderr, "		-batch_cmap NAME: colormap to use\n" );
+fprintf( stderr, "		-batch_mag N: magnification; negative to shrink\n" );
+fprintf( stderr, "		-batch_frames FIRST,LAST: frames to write, counting from 1 (default: all)\n" );
+fprintf( stderr, "		-batch_out PREFIX: files are named PREFIX.NNNNN.ppm (default \"%s\")\n",
+		DEFAULT_BATCH_PREFIX );
+fprintf( stderr, "		-batch_threads N: number of threads making the images (default: one per CPU)\n" );
+fprintf( stderr, "	-autorange: Stretch the colormap over each frame's own range, instead of the variable's\n" );
+fprintf( stderr, "		(ctrl-click the Range button to switch while running)\n" );
+fprintf( stderr, "	-autorange_smooth W: With -autorange, blend each frame's range with the one before,\n" );
+fprintf( stderr, "		keeping W of the old range (0 to 1), so that animations don't flicker\n" );
+fprintf( stderr, "	-timing: When exiting, print how long starting up and each stage of drawing took\n" );
+fprintf( stderr, "	-timing_trace FILE: Same as -timing, and also write the times to FILE as a Chrome trace\n" );
+fprintf( stderr, "	-fps N: Try to animate at N frames per second, instead of using the speed slider\n" );
+fprintf( stderr, "	-dropframes: Skip frames when animation can't keep up with the frame rate\n" );
+fprintf( stderr, "	-frame_mem MB: Max memory used to keep frames for fast redisplay (default %d, 0=no limit)\n",
+		DEFAULT_FRAME_MEM_MB );
+fprintf( stderr, "	-no_saveframes: Do not keep frames in memory for fast redisplay\n" );
+fprintf( stderr, "	-memlimit SIZE: Limit on the memory used for data, pictures, and the frame and data caches,\n" );
+fprintf( stderr, "		such as 4G or 800M (default: no limit)\n" );
+fprintf( stderr, "	-bench_play N: Play N frames of the first variable as fast as possible, print the frame rate, and exit\n" );
+fprintf( stderr, "	-bench_mag N: Magnification to use with -bench_play (negative to shrink)\n" );
 fprintf( stderr, "	-nc: 	Specify number of colors to use.\n" );
 fprintf( stderr, "	-no1d: 	Do NOT allow 1-D variables to be displayed.\n" );
 fprintf( stderr, "	-calendar: Specify time calendar to use, overriding value in file. Known: noleap standard gregorian 365_day 360_day.\n" );
 fprintf( stderr, "	-private: Use a private colormap.\n" );
+fprintf( stderr, "	-pixmap_mem MB: Max X server memory used to keep frames for fast replay (default %d=off)\n",
+		DEFAULT_PIXMAP_MEM_MB );
+fprintf( stderr, "	-progressive: Show very large frames at low resolution first, then at full resolution.\n" );
 fprintf( stderr, "	-debug: Print lots of debugging info.\n" );
+fprintf( stderr, "	-data_mem MB: Max memory used to keep data already read from the files (default %d, 0=off)\n",
+		DEFAULT_DATA_MEM_MB );
 fprintf( stderr, "	-beep: 	Ring the bell when the movie restarts at frame zero.\n" );
 fprintf( stderr, "	-extra: Put some extra information on the display window.\n" );
 fprintf( stderr, "	-mtitle: My title to use on the display window.\n" );
@@ -204,12 +204,58 @@
 #define SHRINK_METHOD_MEAN	0
 #define SHRINK_METHOD_MODE	1
 
+/*******************************************************************
+ * What range of data values the colormap is stretched over.
+ */
+#define RANGE_MODE_GLOBAL	0	/* the variable's user_min to user_max */
+#define RANGE_MODE_FRAME	1	/* each frame's own min to max */
+
+/*******************************************************************
+ * Stages timed by -timing; see timing.c.  The ones before 
+ * TIMING_FRAME happen while starting up, the rest once per frame.
+ * Wrap the work in TIMING_BEGIN(t0) ... TIMING_END(stage,t0), where
+ * t0 is a double; when -timing is off, all they do is test the option.
+ */
+#define TIMING_OPEN		0	/* opening a file */
+#define TIMING_VAR_SCAN		1	/* finding the variables in a file */
+#define TIMING_AUX_FILL		2	/* reading a variable's attributes */
+#define TIMING_DIM_LOAD		3	/* reading a variable's dims; see load_var_dims() */
+#define TIMING_MIN_MAX		4	/* finding a variable's range */
+#define TIMING_WIDGETS		5	/* making the windows */
+#define TIMING_FIRST_DRAW	6	/* from starting up to the first picture */
+#define TIMING_FRAME		7	/* drawing a frame, all stages */
+#define TIMING_READ		8	/* reading data from the file */
+#define TIMING_UNPACK		9	/* NaNs, scale_factor, add_offset */
+#define TIMING_RESAMPLE		10	/* expanding or contracting the data */
+#define TIMING_QUANTIZE		11	/* data to colormap indices */
+#define TIMING_TRUECOLOR	12	/* colormap indices to TrueColor pixels */
+#define TIMING_UPLOAD		13	/* sending the image to the X server */
+#define TIMING_N_STAGES		14
+
+#define TIMING_BEGIN(t0)	do { (t0) = options.timing ? timing_now() : 0.0; } while(0)
+#define TIMING_END(stage,t0)	do { if( options.timing ) timing_record( (stage), (t0) ); } while(0)
+
+/*******************************************************************
+ * Subsystems whose memory is counted against -memlimit; see 
+ * membudget.c.  MEM_FRAMES and MEM_SLABS are caches that give up
+ * entries when something else needs the room.
+ */
+#define MEM_VIEW		0	/* view->data and view->pixels */
+#define MEM_RENDER		1	/* buffers used while drawing a frame */
+#define MEM_DIMS		2	/* dim values */
+#define MEM_OVERLAY		3	/* overlay points */
+#define MEM_PLOT		4	/* XY plot values */
+#define MEM_FRAMES		5	/* the frame store */
+#define MEM_SLABS		6	/* the slab cache */
+#define MEM_N_SUBSYSTEMS	7
+
 /*********************************************************************
  * Possible states which the data inside the current buffer can be in
  */
 #define VDS_VALID	1
 #define VDS_INVALID	2
 #define VDS_EDITED	3
+#define VDS_COARSE	4	/* low resolution stand-in, still to be read in full */
 
 /*******************************************************************
  * Where postscript output can go.
@@ -231,6 +277,16 @@
 #define TSTD_EPIC_0		2	/* Ex: units="True Julian Day" w/att epic_code=624 */
 #define TSTD_MONTHS		3	/* Ex: units="months", Jan 1 AD = month 1 */
 
+/*******************************************************************
+ * How the record dim values in one file are put into the units of 
+ * the first file, when the files in a virtual concatenation have 
+ * different time units.
+ */
+#define RECDIM_CONV_UNKNOWN	0	/* not worked out yet */
+#define RECDIM_CONV_NONE	1	/* no conversion needed, or possible */
+#define RECDIM_CONV_AFFINE	2	/* value*recdim_scale + recdim_offset */
+#define RECDIM_CONV_CALENDAR	3	/* to a date and back again */
+
 /*******************************************************************
  * Kinds of time-like granularity.
  */
@@ -292,6 +348,9 @@ typedef struct {
 	char	*recdim_units;
 #ifdef INC_UDUNITS
 	utUnit	*udunits;	/* only non-null if utScan worked on these units */
+	int	recdim_conv;	/* RECDIM_CONV_xxx; how to get the first file's recdim units */
+	double	recdim_scale,	/* for RECDIM_CONV_AFFINE only */
+		recdim_offset;
 #endif
 } FDBlist;	
 
@@ -315,12 +374,19 @@ typedef struct {
 } NetCDFOptions;
 	
 /*****************************************************************************/
+/* A time value broken down into a calendar date */
+typedef struct {
+	int	year, month, day, hour, minute;
+	float	second;
+} CalDate;
+
 /* The dimension structure.  This is more for convienence and efficiency
  * than because dimensions are so fundamental; actually, it's the variables
  * which are more important.
  */
 typedef struct {
 	char	*name, *long_name, *units;
+	int	have_info;	/* 0 until long_name, units, calendar, and time info have been read */
 	int	units_change;	/* if 1, then a virtully concatenated timelike dimension has different units in different input files */
 	float	min, max, *values;
 	int	have_calc_minmax;  /* 0 initially, 1 after min & max have been calculated */
@@ -332,6 +398,9 @@ typedef struct {
 	int	tgran; 		/* time granularity; i.e., frequency of entries (daily, hourly, etc). Must be one of the TGRAN_* defined above */
 	int	global_id;	/* Used internally, goes from 1..total number of dims we know about */
 	int	is_lat, is_lon; /* Just a guess if these are lat/lon. Used to put on coastlines automatically */
+	size_t	n_dates;	/* For TSTD_UDUNITS dims, the number of entries in ...*/
+	double	*date_values;	/* ...the dim values, in increasing order, and ... */
+	CalDate	*dates;		/* ...those values as dates.  NULL if not made; see udu_cache_dates() */
 } NCDim;
 
 /*****************************************************************************/
@@ -342,6 +411,7 @@ typedef struct {
 typedef struct {
 	char	*name;
 	void	*next, *prev;			/* for global list of variables */
+	void	*hash_next;			/* next var in the same get_var() bucket */
 	float	fill_value;			/* Any data with this special
 						 * value will be IGNORED. It
 						 * is assumed to indicate 
@@ -374,8 +444,37 @@ typedef struct {
 						 * in more than one input file, false
 						 * otherwise.
 						 */
+	int	n_files;			/* Number of files in the FDB list, */
+	unsigned long file_signature;		/* and a hash of their ids in order.
+						 * Vars in the same set of files have
+						 * the same signature.
+						 */
 } NCVar;
 
+/*****************************************************************************/
+/* Scratch space used while turning a view's data into pixels, kept from one
+ * frame to the next so that drawing doesn't allocate.  Threads that draw at
+ * the same time each need their own; see render_scratch_new().
+ */
+typedef struct {
+	float	*scaled_data;		/* resampled data, in data_to_pixels_region */
+	size_t	scaled_data_size;
+	float	*weight;		/* bilinear weights, for weight_blowup */
+	int	weight_blowup;
+	float	*row_buf;		/* bilinear rows and their fill masks, */
+	char	*mask_buf;		/* span_w wide */
+	size_t	span_w;
+	double	*sum;			/* block mean accumulators, sum_w wide */
+	char	*has_fill;
+	size_t	sum_w;
+	float	*tmpv;			/* block being handed to util_mode */
+	long	tmpv_n;
+	long	*count_vals, *unique_vals,	/* util_mode's tables, for up */
+		*slot_index, *slot_stamp,	/* to mode_n values */
+		stamp;
+	size_t	mode_n, hash_size;
+} RenderScratch;
+
 /*****************************************************************************/
 /* Our current view--the view is the 2D field which is being color-contoured.
  */
@@ -392,24 +491,57 @@ typedef struct {
 	int	plot_XY_axis,	/* Which axis to plot along in XY plots */
 		plot_XY_nlines;	/* # of XY lines for this variable on current plot */
 	size_t	plot_XY_position[MAX_LINES_PER_PLOT][10];
+
+	/* Used when options.range_mode is RANGE_MODE_FRAME; see set_frame_range() */
+	int	have_frame_range,	/* are frame_min/max set? */
+		frame_range_current,	/* ...and for what is in 'data' now? */
+		have_prev_range;	/* are prev_min/max set? */
+	size_t	range_frameno;		/* frame that frame_min/max are for */
+	float	frame_min, frame_max,	/* range the data is drawn with */
+		prev_min, prev_max;	/* range of the frame drawn before it */
+	size_t	n_frame_ranges;		/* frames in frame_ranges */
+	float	*frame_ranges;		/* min,max each frame was drawn with; 
+					 * max < min if not drawn yet */
+	size_t	data_bytes, pixels_bytes;	/* sizes of data and pixels, as 
+						 * counted in the memory budget */
+	RenderScratch *scratch;		/* NULL to draw with the main thread's scratch */
 } View;
 
 /*****************************************************************************
  * Place to store the frames in, if we want in-core displaying.
  */
+/* Already-rendered frames, kept run-length encoded under a memory budget.
+ * See framestore.c.
+ */
 typedef struct {
-	int	valid;		/* Is anything in the frame store valid? */
-	ncv_pixel *frame;	/* Actual store of the frames */
-	int	*frame_valid;	/* Is this particular frame valid? */
+	int	valid;		/* Is the frame store usable? */
+	size_t	n_frames;	/* Number of frames along the scan axis */
+	size_t	width, height;	/* Size of each (scaled) frame */
+	unsigned char **frame;	/* Encoded frames; NULL if that frame is not held */
+	size_t	*frame_len;	/* Encoded length of each frame */
+	unsigned long *last_used; /* When each frame was last touched, for LRU eviction */
+	unsigned long clock;	/* Bumped on every access */
+	size_t	budget;		/* Max bytes of encoded frames to hold, 0 for no limit */
+	size_t	bytes_held;	/* Encoded bytes currently held */
+	size_t	raw_held;	/* What the held frames would take unencoded */
+	size_t	n_held;		/* Number of frames currently held */
+	ncv_pixel *decode;	/* One frame's worth of space to decode into */
+	unsigned char *encode;	/* Worst-case sized space to encode into */
+	int	range_mode;	/* options.range_mode the held frames were drawn in */
 } FrameStore;
 
 /*****************************************************************************/
 /* program options */
 
-/* Options for the overlay feature */
+/* Options for the overlay feature.  The overlay is kept as a sorted list of
+ * the data indices (i + j*nx) it covers, which is much smaller than a full
+ * field for typical coastline data; it is drawn onto the pixels after they
+ * are generated, so the data itself is never touched.
+ */
 typedef struct {
 	int	doit;
-	int	*overlay;
+	size_t	n_points;	/* Number of entries in 'points' */
+	size_t	*points;	/* Sorted data indices that are overlaid */
 } OverlayOptions;
 
 typedef struct {
@@ -452,11 +584,65 @@ typedef struct {
 	int	blowup_type;	/* can be BLOWUP_REPLICATE or BLOWUP_BILINEAR */
 
 	int	save_frames;	/* If true, try to save frames in core for faster display */
+	int	frame_mem_mb;	/* Memory budget for saved frames, in MB; 0 for no limit */
+	int	data_mem_mb;	/* Memory budget for cached data slabs, in MB; 0 turns off */
+	int	pixmap_mem_mb;	/* X server memory budget for frame pixmaps, in MB; 0 turns off */
+	size_t	mem_limit;	/* Limit on the memory counted by membudget.c, in bytes; 0 for none */
+	int	progressive;	/* If true, show big frames at low resolution first */
 	float	frame_delay;	/* Normalied to be between 0.0 and 1.0 */
+	float	target_fps;	/* If > 0, animation frame rate to aim for; else use frame_delay */
+	int	drop_frames;	/* If true, skip frames when animation falls behind */
+	char	*frames_y4m;	/* If not NULL, dumped frames go to this .y4m stream, not PPM files */
+	int	range_mode;	/* RANGE_MODE_GLOBAL or RANGE_MODE_FRAME */
+	float	range_smooth;	/* 0 to <1; how much of the last frame's range to keep in RANGE_MODE_FRAME */
+	int	timing;		/* If true, time the startup phases and frame stages; see timing.c */
+	char	*timing_trace;	/* If not NULL, write the timings to this Chrome trace file too */
+
+	/* -batch: render a variable to image files without a display, then exit */
+	char	*batch_var,	/* if not NULL, the variable to render */
+		*batch_x_dim,	/* NULL to pick the axes the usual way */
+		*batch_y_dim,
+		*batch_cmap,	/* NULL for the first colormap */
+		*batch_prefix;	/* images are written to batch_prefix.NNNNN.ppm */
+	int	batch_have_range;
+	float	batch_min, batch_max;
+	int	batch_mag;	/* magnification; negative to shrink, as with blowup */
+	long	batch_first,	/* frames to render, counting from 1; 0 for all */
+		batch_last;
+	int	batch_threads;	/* 0 for one per processor */
+
+	/* -bench_play: play a number of frames as fast as possible, report, and exit */
+	long	bench_play;	/* frames to play; 0 when not benchmarking */
+	int	bench_mag;	/* magnification to play at; 0 to pick it the usual way */
 
 	OverlayOptions *overlay;
 } Options;
 
+/* Something long to be done on the worker thread; see worker.c.  'work'
+ * runs on the worker thread, and must only touch the data files through
+ * the fi_ routines.  'done' is called back on the main thread, with
+ * use_result FALSE if the task was cancelled or was started before the
+ * last worker_cancel_all.  Each lane has its own thread, and runs its
+ * tasks in order.
+ */
+#define WORKER_LANE_LONG	0	/* long jobs, such as range scans */
+#define WORKER_LANE_VIEW	1	/* reading what is being looked at */
+#define WORKER_N_LANES		2
+
+typedef struct _worker_task {
+	char	*title;				/* shown in the progress window */
+	void	(*work)( struct _worker_task *task );
+	void	(*done)( struct _worker_task *task, int use_result );
+	void	*data;				/* for work and done to use */
+	int	lane;				/* WORKER_LANE_LONG unless set otherwise */
+	int	keep;				/* from worker_init_task, so not freed */
+	unsigned long	generation;
+	int	cancel;
+	float	progress;			/* 0 to 1 */
+	double	started;			/* from timing_now() */
+	struct _worker_task *next;
+} WorkerTask;
+
 /* Postscript printer output options */
 typedef struct {
 	float	page_width, page_height,		/* In inches */
@@ -36,8 +36,10 @@
 #include <limits.h>
 #include <math.h>
 #include <time.h>
+#include <sys/time.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <pthread.h>
 
 #include <X11/Intrinsic.h>
 #include <X11/IntrinsicP.h>
@@ -48,6 +48,8 @@ Stringlist *fi_list_vars ( int fileid );
 int	fi_n_dims	 ( int fileid, char *var_name );
 size_t	*fi_var_size	 ( int fileid, char *var_name );
 void 	fi_get_data      ( NCVar *var, size_t *start_pos, size_t *count, void *data );
+int 	fi_get_data_strided( NCVar *var, size_t *start_pos, size_t *count, ptrdiff_t *stride, 
+				void *data );
 void 	fi_close         ( int fileid );
 void	determine_file_type( Stringlist *input_files );
 Stringlist *fi_scannable_dims( int fileid, char *var_name );
@@ -66,6 +68,8 @@ size_t 	fi_n_dim_entries ( int fileid, char *dim_name );
 void 	fi_fill_aux_data ( int id, char *var_name, FDBlist *fdb );
 void 	fi_fill_value	 ( NCVar *var, float *fillval );
 int 	fi_recdim_id     ( int fileid );
+void	fi_lock		 ( void );
+void	fi_unlock	 ( void );
 
 /******************************************************************************
  * in file_netcdf.c, netcdf specific routines 
@@ -80,6 +84,9 @@ int	netcdf_fi_n_dims	( int fileid, char *var_name );
 size_t	*netcdf_fi_var_size	( int fileid, char *var_name );
 void 	netcdf_fi_get_data	( int fileid, char *var_name, size_t *start_pos, 
 						size_t *count, float *data, NetCDFOptions *aux_data );
+void 	netcdf_fi_get_data_strided( int fileid, char *var_name, size_t *start_pos, 
+						size_t *count, ptrdiff_t *stride, float *data, 
+						NetCDFOptions *aux_data );
 void	netcdf_fi_close		( int fileid );
 int 	netcdf_n_dims 		( int cdfid, char *varname );
 char	*netcdf_varindex_to_name( int cdfid, int index );
@@ -114,17 +121,28 @@ void 	new_fdblist        ( FDBlist **el );
 void 	new_netcdf         ( NetCDFOptions **n );
 void	dump_stringlist    ( Stringlist *s );
 int	data_to_pixels     ( View *v );
+int	data_to_pixels_region( View *v, size_t px0, size_t py0, size_t pw, size_t ph );
+RenderScratch *render_scratch_new( void );
+void	render_scratch_free( RenderScratch *s );
+size_t	data_valid_range   ( float *data, size_t n, float fill_value, float *min, float *max );
+void	set_frame_range    ( View *v );
+int	get_frame_range    ( View *v, size_t frameno, float *min, float *max );
+void	forget_frame_ranges( View *v );
 void	add_var_to_list    ( char *var_name, int file_id, char *filename, int nfiles );
 NCVar	*get_var	   ( char *var_name );
 void	add_to_varlist     ( NCVar **list, NCVar *new_var );
 void	init_min_max	   ( NCVar *var );
+void	init_min_max_background( NCVar *var );
+int	init_min_max_exhaustive( NCVar *var );
 void	clip_f		   ( float *val, float min, float max );
 void	clip_i		   ( int   *val, int   min, int   max );
 void 	fill_dim_structs   ( NCVar *v );
-void 	expand_data	   ( float *big_data, View *v );
+void 	expand_data	   ( float *big_data, View *v, size_t x0, size_t y0, size_t w, size_t h );
+void 	contract_data	   ( float *small_data, View *v, float fill_value, size_t x0, size_t y0, 
+				size_t w, size_t h );
 void 	check_ranges       ( NCVar *var );
 char 	*limit_string	   ( char *s );
-int 	*gen_overlay       ( View *v, char *overlay_fname );
+size_t 	*gen_overlay       ( View *v, char *overlay_fname, size_t *n_points );
 void 	fmt_time	   ( char *temp_string, double new_dimval, NCDim *dim, int include_granularity );
 int	n_vars_in_list	   ( NCVar *v );
 void 	set_blowup_type	   ( int new_type );
@@ -132,11 +150,12 @@ int 	n_strings_in_list  ( Stringlist *s );
 int 	strncmp_nocase     ( char *s1, char *s2, size_t n );
 int 	warn_if_file_exits ( char *fname );
 void 	virt_to_actual_place( NCVar *var, size_t *virt_pl, size_t *act_pl, FDBlist **file );
-void 	calc_dim_minmaxes   ( void );
+void 	load_var_dims       ( NCVar *v );
 void    add_vars_to_list    ( Stringlist *var_list, int id, char *filename, int nfiles );
 int     is_scannable        ( NCVar *v, int i );
 void 	sl_cat		    ( Stringlist **dest, Stringlist **src );
-Stringlist *add_to_stringlist_ordered( Stringlist **list, char *new_string, void *aux );
+Stringlist *prepend_to_stringlist( Stringlist **list, char *new_string, void *aux );
+void	sort_stringlist( Stringlist **list );
 
 /******************************************************************************
  * in interface.c 
@@ -154,6 +173,13 @@ void 	in_button_pressed	( int button_id, int modifier );
 void	in_process_user_input	( void );
 void	in_draw_2d_field 	( unsigned char *data, size_t width, size_t height,
 	size_t timestep );
+void	in_draw_2d_region 	( unsigned char *data, size_t width, size_t height,
+	size_t x, size_t y, size_t w, size_t h, size_t timestep );
+void	in_get_visible_region	( size_t width, size_t height, size_t *x, size_t *y, size_t *w, size_t *h );
+void	in_invalidate_2d_backing( void );
+int	in_draw_frame_pixmap	( size_t frameno, size_t width, size_t height );
+void	in_save_frame_pixmap	( size_t frameno, size_t width, size_t height );
+void	in_clear_frame_pixmaps	( void );
 void	in_create_colormap	( char *name, ncv_pixel r[256], ncv_pixel g[256], ncv_pixel b[256] );
 char	*in_install_next_colormap( int do_widgets_flag );
 int	in_set_2d_size   	( size_t width, size_t height );
@@ -171,6 +197,7 @@ void 	in_set_cursor_normal	( void );
 int 	in_set_scan_dims	( Stringlist *dim_list, char *x_axis, char *y_axis, Stringlist **new_dim_list );
 void	in_change_min		( char *label );
 void 	in_flush		( void );
+void 	in_sync			( void );
 void 	report_position		( int x, int y, unsigned int button_mask );
 int	in_popup_XY_graph	( size_t n, int dimindex, double *xvals, double *yvals, char *x_axis_title,
 				char *y_axis_title, char *title, char *legend, 
@@ -181,6 +208,15 @@ void	in_popdown_2d_window	( void );
 void 	in_timer_clear		( void );
 int	in_report_auto_overlay  ( void );
 void 	in_timer_set            ( XtTimerCallbackProc procedure, XtPointer arg );
+void 	in_work_proc_set        ( XtWorkProc procedure, XtPointer arg );
+void	in_add_input		( int fd, XtInputCallbackProc procedure, XtPointer arg );
+void	in_process_event	( void );
+void	in_progress_show	( char *message, int modal );
+void	in_progress_hide	( void );
+int	in_timer_frame_advance	( void );
+double	in_timer_achieved_fps	( void );
+void	in_timer_hold		( void );
+void	in_timer_release	( void );
 char    *in_install_prev_colormap( int do_widgets );
 void 	in_data_edit_dump	( void );
 
@@ -220,6 +256,13 @@ void 	x_set_label		( int id, char *string );
 void	x_set_speed_proc	( Widget scrollbar, XtPointer client_data, XtPointer position );
 void	x_draw_2d_field		( unsigned char *data, size_t width, size_t height,
 	size_t timestep );
+void	x_draw_2d_region	( unsigned char *data, size_t width, size_t height,
+	size_t x, size_t y, size_t w, size_t h, size_t timestep );
+void	x_get_visible_region	( size_t width, size_t height, size_t *x, size_t *y, size_t *w, size_t *h );
+void	x_invalidate_2d_backing	( void );
+int	x_draw_frame_pixmap	( size_t frameno, size_t width, size_t height );
+void	x_save_frame_pixmap	( size_t frameno, size_t width, size_t height );
+void	x_clear_frame_pixmaps	( void );
 void	x_set_2d_size 		( size_t width, size_t height );
 void    x_indicate_active_var   ( char *var_name );
 void    *x_create_default_colormap( void );
@@ -240,9 +283,12 @@ int	x_set_scan_dims     ( Stringlist *dim_list, char *x_axis, char *y_axis, Stri
 void 	x_set_cursor_busy	( void );
 void 	x_set_cursor_normal	( void );
 void 	x_flush			( void );
+void 	x_sync			( void );
 void    x_indicate_active_dim   ( int dimension, char *dim_name );
 void 	x_query_pointer_position( int *x, int *y );
 void	pix_to_rgb		( ncv_pixel pix, int *r, int *g, int *b );
+void	x_bench_tc_data		( int bits_per_pixel, unsigned char *data, long width, long height, 
+				unsigned char *tc_data );
 void	x_get_window_position   ( int *llx, int *lly, int *urx, int *ury );
 void 	x_set_var_sensitivity( char *varname, int sens );
 void	x_popup_2d_window	( void );
@@ -255,6 +301,15 @@ void 	x_draw_colorbar		( void );
 void 	x_create_colorbar       ( float user_min, float user_max, int transform );
 void    x_timer_clear           ( void );
 void    x_timer_set             ( XtTimerCallbackProc procedure, XtPointer client_arg );
+void    x_work_proc_set         ( XtWorkProc procedure, XtPointer client_arg );
+void	x_add_input		( int fd, XtInputCallbackProc procedure, XtPointer client_arg );
+void	x_process_event		( void );
+void	x_progress_show		( char *message, int modal );
+void	x_progress_hide		( void );
+int	x_timer_frame_advance	( void );
+double	x_timer_achieved_fps	( void );
+void	x_timer_hold		( void );
+void	x_timer_release		( void );
 void    x_indicate_active_var   ( char *var_name );
 int     x_dialog                ( char *message, char *ret_string, int want_cancel_button );
 
@@ -274,6 +329,8 @@ int 	set_scan_variable    ( NCVar *var );
 void 	set_scan_view        ( size_t scan_place );
 int 	change_view          ( int delta, int interpretation );
 int	view_draw            ( int allow_saveframes_useage );
+int	view_expose          ( void );
+int	view_draw_all_pixels ( void );
 void 	view_change_cur_dim  ( char *dim_name, int modifier );
 void	view_forward         ( void );
 void	view_backward        ( void );
@@ -298,10 +355,101 @@ void 	view_change_transform( int delta );
 void 	view_recompute_colorbar( void );
 void    view_set_range_frame ( void );
 void    view_set_range       ( void );
+void    view_toggle_range_mode( void );
+void    view_range_changed   ( NCVar *var );
 void    view_set_scan_dims   ( void );
 void 	view_data_edit       ( void );
 void 	view_information     ( void );
 
+/******************************************************************************
+ * in framestore.c
+ */
+int	framestore_init		( size_t n_frames, size_t width, size_t height, size_t budget );
+void	framestore_free		( void );
+void	framestore_invalidate_all( void );
+ncv_pixel *framestore_get	( size_t frameno, size_t width, size_t height );
+void	framestore_put		( size_t frameno, ncv_pixel *pixels, size_t width, size_t height );
+void	framestore_stats_string	( char *s );
+
+/******************************************************************************
+ * in slabcache.c
+ */
+void	slabcache_init		( size_t budget_bytes );
+int	slabcache_get		( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, float *data );
+void	slabcache_put		( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, float *data, size_t n );
+void	slabcache_clear		( void );
+float	*slabcache_get_reduced	( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, 
+				int factor, int method );
+float	*slabcache_alloc_reduced( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, 
+				int factor, int method, size_t n );
+void	slabcache_forget	( NCVar *var, size_t *place, int x_axis_id, int y_axis_id );
+void	slabcache_stats_string	( char *s );
+
+/******************************************************************************
+ * in frameexport.c
+ */
+void	frameexport_put		( ncv_pixel *pixels, size_t width, size_t height, size_t frameno,
+				unsigned char palette[256][3] );
+void	frameexport_close	( void );
+size_t	frameexport_ppm_size	( size_t width, size_t height );
+int	frameexport_write_ppm	( char *filename, ncv_pixel *pixels, size_t width, size_t height,
+				unsigned char palette[256][3], unsigned char *buf );
+
+/******************************************************************************
+ * in batch.c
+ */
+void	batch_add_colormap	( char *name, unsigned char r[256], unsigned char g[256], 
+				unsigned char b[256] );
+int	batch_render		( void );
+
+/******************************************************************************
+ * in timing.c
+ */
+void	timing_init		( char *trace_fname );
+double	timing_now		( void );
+void	timing_record		( int stage, double t0 );
+void	timing_first_draw	( void );
+
+/******************************************************************************
+ * in membudget.c
+ */
+void	membudget_init		( size_t limit_bytes );
+void	membudget_set_evict	( int subsys, size_t (*evict)( size_t want ) );
+int	membudget_reserve	( int subsys, size_t bytes );
+void	membudget_charge	( int subsys, size_t bytes );
+void	membudget_release	( int subsys, size_t bytes );
+void	*membudget_malloc	( int subsys, size_t bytes );
+void	membudget_free		( int subsys, void *p, size_t bytes );
+void	membudget_usage_string	( char *s );
+void	membudget_stats_string	( char *s );
+size_t	membudget_parse_size	( char *s );
+
+/******************************************************************************
+ * in worker.c
+ */
+void	worker_init		( void );
+int	worker_threaded		( void );
+int	worker_idle		( void );
+WorkerTask *worker_new_task	( char *title, void (*work)( WorkerTask *task ),
+				void (*done)( WorkerTask *task, int use_result ), void *data );
+void	worker_init_task	( WorkerTask *task, char *title, void (*work)( WorkerTask *task ),
+				void (*done)( WorkerTask *task, int use_result ), void *data );
+void	worker_run		( WorkerTask *task );
+int	worker_run_modal	( WorkerTask *task );
+void	worker_cancel_all	( void );
+int	worker_cancelled	( WorkerTask *task );
+void	worker_progress		( WorkerTask *task, float fraction );
+
+/******************************************************************************
+ * in benchplay.c
+ */
+void	bench_play_init		( void );
+
+/******************************************************************************
+ * in bench.c
+ */
+int	bench_main		( int argc, char **argv );
+
 /******************************************************************************
  * in overlay.c
  */
@@ -349,6 +497,7 @@ void 	udu_utinit( char *path );
 int 	udu_utistime( char *dimname, char *units );
 int 	udu_calc_tgran( int fileid, NCVar *v, int dimid );
 void 	udu_fmt_time( char *temp_string, double new_dimval, NCDim *dim, int include_granularity );
+int	udu_cache_dates( NCDim *d, double *vals, size_t n );
 
 /******************************************************************************
  * in epic_time.c
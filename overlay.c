@@ -48,7 +48,8 @@ extern Options  options;
 static int	my_current_overlay;
 
 static int 	gen_xform( float value, int n, float *dimvals );
-static int 	*gen_overlay_internal( View *v, float *data, long n );
+static size_t 	*gen_overlay_internal( View *v, float *data, long n, size_t *n_points );
+static size_t 	*overlay_mask_to_points( unsigned char *mask, size_t n, size_t *n_points );
 static void 	do_overlay_inner( View *v, float *data, long nvals, int suppress_screen_changes );
 
 /*====================================================================================
@@ -63,8 +64,12 @@ do_overlay( int n, char *custom_filename, int suppress_screen_changes )
 		}
 
 	/* Free space for previous overlay */
-	if( options.overlay->doit && (options.overlay->overlay != NULL ))
-		free( options.overlay->overlay );
+	if( options.overlay->doit && (options.overlay->points != NULL )) {
+		free( options.overlay->points );
+		membudget_release( MEM_OVERLAY, options.overlay->n_points*sizeof(size_t) );
+		options.overlay->points   = NULL;
+		options.overlay->n_points = 0L;
+		}
 
 	switch(n) {
 		
@@ -97,8 +102,10 @@ do_overlay( int n, char *custom_filename, int suppress_screen_changes )
 				in_error( "Specified custom overlay filename is not a valid filename!\n" );
 				return;
 				}
-			options.overlay->overlay = gen_overlay( view, custom_filename ); 
-			if( options.overlay->overlay != NULL ) {
+			options.overlay->points = gen_overlay( view, custom_filename, 
+							&(options.overlay->n_points) ); 
+			if( options.overlay->points != NULL ) {
+				membudget_charge( MEM_OVERLAY, options.overlay->n_points*sizeof(size_t) );
 				options.overlay->doit = TRUE;
 				if( ! suppress_screen_changes ) {
 					invalidate_all_saveframes();
@@ -120,8 +127,10 @@ do_overlay( int n, char *custom_filename, int suppress_screen_changes )
 	void
 do_overlay_inner( View *v, float *data, long nvals, int suppress_screen_changes )
 {
-	options.overlay->overlay = gen_overlay_internal( v, data, nvals );
-	if( options.overlay->overlay != NULL ) {
+	options.overlay->points = gen_overlay_internal( v, data, nvals, 
+							&(options.overlay->n_points) );
+	if( options.overlay->points != NULL ) {
+		membudget_charge( MEM_OVERLAY, options.overlay->n_points*sizeof(size_t) );
 		options.overlay->doit = TRUE;
 		if( ! suppress_screen_changes ) {
 			invalidate_all_saveframes();
@@ -137,9 +146,10 @@ do_overlay_inner( View *v, float *data, long nvals, int suppress_screen_changes
 	void
 overlay_init()
 {
-	my_current_overlay       = OVERLAY_NONE;
-	options.overlay->overlay = NULL;
-	options.overlay->doit    = FALSE;
+	my_current_overlay        = OVERLAY_NONE;
+	options.overlay->points   = NULL;
+	options.overlay->n_points = 0L;
+	options.overlay->doit     = FALSE;
 }
 
 /*======================================================================================
@@ -173,14 +183,46 @@ determine_overlay_base_dir( char *overlay_base_dir, int n )
 }
 
 /******************************************************************************
- * Generate an overlay from data in an overlay file.
+ * Turn a packed bitmask (one bit per data point) into a sorted list of the
+ * data indices that are set.  The mask is freed.  Returns NULL on failure.
+ */
+	static size_t *
+overlay_mask_to_points( unsigned char *mask, size_t n, size_t *n_points )
+{
+	size_t	i, np, *points;
+
+	np = 0L;
+	for( i=0; i<n; i++ )
+		if( *(mask + (i>>3)) & (1 << (i&7)) )
+			np++;
+
+	/* Always allocate at least one so an empty overlay isn't mistaken for failure */
+	points = (size_t *)malloc( (np > 0 ? np : 1)*sizeof(size_t) );
+	if( points == NULL ) {
+		free( mask );
+		in_error( "Malloc of overlay field failed\n" );
+		return( NULL );
+		}
+
+	np = 0L;
+	for( i=0; i<n; i++ )
+		if( *(mask + (i>>3)) & (1 << (i&7)) )
+			*(points + np++) = i;
+
+	free( mask );
+	*n_points = np;
+	return( points );
+}
+
+/******************************************************************************
+ * Generate an overlay from data built into ncview.
  */
-	int *
-gen_overlay_internal( View *v, float *data, long nvals )
+	static size_t *
+gen_overlay_internal( View *v, float *data, long nvals, size_t *n_points )
 {
 	NCDim	*dim_x, *dim_y;
-	size_t	x_size, y_size, ii;
-	int	*overlay;
+	size_t	x_size, y_size, ii, idx;
+	unsigned char *overlay;
 	float	x, y;
 	long	i, j;
 
@@ -190,43 +232,47 @@ gen_overlay_internal( View *v, float *data, long nvals )
 	x_size = *(v->variable->size + v->x_axis_id);
 	y_size = *(v->variable->size + v->y_axis_id);
 
-	overlay = (int *)malloc( x_size*y_size*sizeof(int) );
+	overlay = (unsigned char *)calloc( (x_size*y_size+7)/8, 1 );
 	if( overlay == NULL ) {
 		in_error( "Malloc of overlay field failed\n" );
 		return( NULL );
 		}
-	for( ii=0; ii<x_size*y_size; ii++ )
-		*(overlay+ii) = 0;
 
 	for( ii=0; ii<nvals; ii+=2 ) {
 		x = data[ii];
 		y = data[ii+1];
 
 		i = gen_xform( x, x_size, dim_x->values );
-		if( i == -2 ) 
+		if( i == -2 ) {
+			free( overlay );
 			return( NULL );
+			}
 		j = gen_xform( y, y_size, dim_y->values );
-		if( j == -2 ) 
+		if( j == -2 ) {
+			free( overlay );
 			return( NULL );
-		if( (i > 0) && (j > 0)) 
-			*(overlay + j*x_size + i) = 1;
+			}
+		if( (i > 0) && (j > 0)) {
+			idx = j*x_size + i;
+			*(overlay + (idx>>3)) |= (1 << (idx&7));
+			}
 		}
 
-	return( overlay );
+	return( overlay_mask_to_points( overlay, x_size*y_size, n_points ));
 }
 
 /******************************************************************************
  * Generate an overlay from data in an overlay file.
  */
-	int *
-gen_overlay( View *v, char *overlay_fname )
+	size_t *
+gen_overlay( View *v, char *overlay_fname, size_t *n_points )
 {
 	FILE	*f;
 	char	err_mess[1024], line[80], *id_string="NCVIEW-OVERLAY";
 	float	x, y, version;
 	long	i, j;
-	size_t	x_size, y_size;
-	int	*overlay;
+	size_t	x_size, y_size, idx;
+	unsigned char *overlay;
 	NCDim	*dim_x, *dim_y;
 
 	/* Open the overlay file */
@@ -265,13 +311,11 @@ gen_overlay( View *v, char *overlay_fname )
 	x_size = *(v->variable->size + v->x_axis_id);
 	y_size = *(v->variable->size + v->y_axis_id);
 
-	overlay = (int *)malloc( x_size*y_size*sizeof(int) );
+	overlay = (unsigned char *)calloc( (x_size*y_size+7)/8, 1 );
 	if( overlay == NULL ) {
 		in_error( "Malloc of overlay field failed\n" );
 		return( NULL );
 		}
-	for( i=0; i<x_size*y_size; i++ )
-		*(overlay+i) = 0;
 
 	/* Read in the overlay file -- skip lines with first char of #, 
 	 * they are comments.
@@ -280,16 +324,23 @@ gen_overlay( View *v, char *overlay_fname )
 		if( line[0] != '#' ) {
 			sscanf( line, "%f %f", &x, &y );
 			i = gen_xform( x, x_size, dim_x->values );
-			if( i == -2 ) 
+			if( i == -2 ) {
+				free( overlay );
 				return( NULL );
+				}
 			j = gen_xform( y, y_size, dim_y->values );
-			if( j == -2 ) 
+			if( j == -2 ) {
+				free( overlay );
 				return( NULL );
-			if( (i > 0) && (j > 0)) 
-				*(overlay + j*x_size + i) = 1;
+				}
+			if( (i > 0) && (j > 0)) {
+				idx = j*x_size + i;
+				*(overlay + (idx>>3)) |= (1 << (idx&7));
+				}
 			}
+	fclose( f );
 
-	return( overlay );
+	return( overlay_mask_to_points( overlay, x_size*y_size, n_points ));
 }
 
 /******************************************************************************
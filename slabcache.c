@@ -0,0 +1,408 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2008 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrean
+ * San Diego, CA   92122
+ * pierce@cirrus.ucsd.edu
+ */
+
+/*******************************************************************************
+ * 	slabcache.c
+ *
+ *	A cache of 2-D float slabs that have already been read from the
+ *	data files and converted.  A slab is identified by the variable,
+ *	the place in the variable's space it was read from, and which
+ *	dims are used as the X and Y axes.  Anything that needs to
+ *	re-render a frame it has already read (changing the range, the
+ *	transform, the magnification, the overlay, replaying the movie,
+ *	etc) gets the data from here instead of going back to the file.
+ *
+ *	The cache is held to a memory budget; the least recently used
+ *	slabs are discarded to make room for new ones.  Slabs are also
+ *	counted against the -memlimit limit (see membudget.c), which can
+ *	ask for the oldest to be thrown out when something else needs the
+ *	memory.  Entries are found
+ *	through a small hash table, and kept on a doubly linked list in
+ *	order of use so that the one to throw out is always at the tail.
+ *
+ *	Besides the slabs as read, the cache holds reduced versions of 
+ *	them (shrunk by some factor with a given shrink method), so that
+ *	going back to a shrink factor or frame that has been shown before
+ *	does not mean reducing the full resolution data again.  These are
+ *	kept under the same key plus the factor and method; the slab as 
+ *	read has a factor of 1.
+ *******************************************************************************/
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#define SLABCACHE_N_BUCKETS	1024
+
+typedef struct _slab {
+	NCVar	*var;
+	size_t	*place;			/* var->n_dims entries */
+	int	x_axis_id, y_axis_id;
+	int	factor, method;		/* reduction; factor 1 is the slab as read */
+	size_t	n;			/* number of floats in data */
+	float	*data;
+	unsigned long hash;
+	struct _slab *hash_next;	/* next in the same hash bucket */
+	struct _slab *newer, *older;	/* position on the LRU list */
+} Slab;
+
+static Slab	*bucket[SLABCACHE_N_BUCKETS];
+static Slab	*newest = NULL, *oldest = NULL;
+static size_t	budget     = 0L;
+static size_t	bytes_held = 0L;
+static size_t	n_held     = 0L;
+static long	n_hits     = 0L, n_misses = 0L;
+
+static unsigned long	slab_hash( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, 
+				int factor, int method );
+static Slab		*slab_find( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, 
+				int factor, int method, unsigned long h );
+static Slab		*slab_add( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, 
+				int factor, int method, size_t n );
+static void		slab_unlink_lru( Slab *s );
+static void		slab_link_newest( Slab *s );
+static void		slab_drop( Slab *s );
+static size_t		slabcache_evict( size_t want );
+
+/*******************************************************************************
+ * Set the memory budget, in bytes, for cached slabs.  0 turns the cache off.
+ */
+	void
+slabcache_init( size_t budget_bytes )
+{
+	int	i;
+
+	slabcache_clear();
+	for( i=0; i<SLABCACHE_N_BUCKETS; i++ )
+		bucket[i] = NULL;
+	budget = budget_bytes;
+	membudget_set_evict( MEM_SLABS, slabcache_evict );
+}
+
+/*******************************************************************************
+ * If the indicated slab is in the cache, copies it into 'data' and returns
+ * TRUE.  Otherwise returns FALSE.
+ */
+	int
+slabcache_get( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, float *data )
+{
+	Slab	*s;
+
+	if( budget == 0L )
+		return( FALSE );
+
+	s = slab_find( var, place, x_axis_id, y_axis_id, 1, 0,
+			slab_hash( var, place, x_axis_id, y_axis_id, 1, 0 ));
+	if( s == NULL ) {
+		n_misses++;
+		return( FALSE );
+		}
+
+	n_hits++;
+	memcpy( data, s->data, s->n*sizeof(float) );
+	slab_unlink_lru( s );
+	slab_link_newest( s );
+	return( TRUE );
+}
+
+/*******************************************************************************
+ * Returns the cached copy of the slab reduced by 'factor' using shrink 
+ * 'method', or NULL if there isn't one.  The returned data belongs to the
+ * cache, and is good until the next call that adds something to it.
+ */
+	float *
+slabcache_get_reduced( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, 
+		int factor, int method )
+{
+	Slab	*s;
+
+	if( budget == 0L )
+		return( NULL );
+
+	s = slab_find( var, place, x_axis_id, y_axis_id, factor, method,
+			slab_hash( var, place, x_axis_id, y_axis_id, factor, method ));
+	if( s == NULL ) {
+		n_misses++;
+		return( NULL );
+		}
+
+	n_hits++;
+	slab_unlink_lru( s );
+	slab_link_newest( s );
+	return( s->data );
+}
+
+/*******************************************************************************
+ * Makes a cache entry of 'n' floats for the slab reduced by 'factor' using
+ * shrink 'method', and returns it for the caller to fill in.  Returns NULL 
+ * if the cache is off or can't hold it.  The data is good until the next 
+ * call that adds something to the cache.
+ */
+	float *
+slabcache_alloc_reduced( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, 
+		int factor, int method, size_t n )
+{
+	Slab	*s;
+
+	s = slab_add( var, place, x_axis_id, y_axis_id, factor, method, n );
+	if( s == NULL )
+		return( NULL );
+	return( s->data );
+}
+
+/*******************************************************************************
+ * Throw out the indicated slab and all the reduced versions of it.  This is
+ * used when the data has been changed after it was read.
+ */
+	void
+slabcache_forget( NCVar *var, size_t *place, int x_axis_id, int y_axis_id )
+{
+	Slab	*s, *older;
+	int	i, same;
+
+	for( s=newest; s != NULL; s=older ) {
+		older = s->older;
+		if( (s->var != var) || (s->x_axis_id != x_axis_id) || (s->y_axis_id != y_axis_id) )
+			continue;
+		same = TRUE;
+		for( i=0; i<var->n_dims; i++ )
+			if( *(s->place+i) != *(place+i) ) {
+				same = FALSE;
+				break;
+				}
+		if( same )
+			slab_drop( s );
+		}
+}
+
+/*******************************************************************************
+ * Add a copy of the passed slab of 'n' floats to the cache, throwing out
+ * the least recently used slabs if that is needed to stay in budget.
+ */
+	void
+slabcache_put( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, float *data, size_t n )
+{
+	Slab	*s;
+
+	s = slab_add( var, place, x_axis_id, y_axis_id, 1, 0, n );
+	if( s != NULL )
+		memcpy( s->data, data, n*sizeof(float) );
+}
+
+/*******************************************************************************
+ * Throw out everything in the cache.
+ */
+	void
+slabcache_clear( void )
+{
+	while( oldest != NULL )
+		slab_drop( oldest );
+}
+
+/*******************************************************************************
+ * 's' must have room for at least 132 characters.
+ */
+	void
+slabcache_stats_string( char *s )
+{
+	sprintf( s, "%ld slabs, %.1f of %.1f MB, %ld hits, %ld misses",
+		(long)n_held,
+		(double)bytes_held/1048576.0,
+		(double)budget/1048576.0,
+		n_hits, n_misses );
+}
+
+/*******************************************************************************
+ * Make an entry with room for 'n' floats of data, replacing any entry with
+ * the same key.  Returns NULL if it can't be held.
+ */
+	static Slab *
+slab_add( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, int factor, int method, 
+		size_t n )
+{
+	Slab	*s;
+	size_t	size;
+	unsigned long h;
+	int	i;
+
+	size = n*sizeof(float);
+	if( (budget == 0L) || (size > budget) )
+		return( NULL );
+
+	h = slab_hash( var, place, x_axis_id, y_axis_id, factor, method );
+	if( (s = slab_find( var, place, x_axis_id, y_axis_id, factor, method, h )) != NULL )
+		slab_drop( s );
+
+	while( (oldest != NULL) && (bytes_held + size > budget) )
+		slab_drop( oldest );
+
+	if( ! membudget_reserve( MEM_SLABS, size ))
+		return( NULL );
+
+	s = (Slab *)malloc( sizeof(Slab) );
+	if( s == NULL ) {
+		membudget_release( MEM_SLABS, size );
+		return( NULL );
+		}
+	s->place = (size_t *)malloc( var->n_dims*sizeof(size_t) );
+	s->data  = (float *)malloc( size );
+	if( (s->place == NULL) || (s->data == NULL) ) {
+		if( s->place != NULL )
+			free( s->place );
+		if( s->data != NULL )
+			free( s->data );
+		free( s );
+		membudget_release( MEM_SLABS, size );
+		return( NULL );
+		}
+
+	s->var       = var;
+	s->x_axis_id = x_axis_id;
+	s->y_axis_id = y_axis_id;
+	s->factor    = factor;
+	s->method    = method;
+	s->n         = n;
+	s->hash      = h;
+	for( i=0; i<var->n_dims; i++ )
+		*(s->place+i) = *(place+i);
+
+	s->hash_next = bucket[h % SLABCACHE_N_BUCKETS];
+	bucket[h % SLABCACHE_N_BUCKETS] = s;
+	slab_link_newest( s );
+
+	bytes_held += size;
+	n_held++;
+
+	return( s );
+}
+
+/*******************************************************************************/
+	static unsigned long
+slab_hash( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, int factor, int method )
+{
+	unsigned long	h;
+	int		i;
+
+	h = (unsigned long)var;
+	h = h*31L + (unsigned long)x_axis_id;
+	h = h*31L + (unsigned long)y_axis_id;
+	h = h*31L + (unsigned long)factor;
+	h = h*31L + (unsigned long)method;
+	for( i=0; i<var->n_dims; i++ )
+		h = h*1000003L + (unsigned long)(*(place+i));
+
+	return( h );
+}
+
+/*******************************************************************************/
+	static Slab *
+slab_find( NCVar *var, size_t *place, int x_axis_id, int y_axis_id, int factor, int method,
+		unsigned long h )
+{
+	Slab	*s;
+	int	i, same;
+
+	for( s=bucket[h % SLABCACHE_N_BUCKETS]; s != NULL; s=s->hash_next ) {
+		if( (s->hash != h) || (s->var != var) ||
+		    (s->x_axis_id != x_axis_id) || (s->y_axis_id != y_axis_id) ||
+		    (s->factor != factor) || (s->method != method) )
+			continue;
+		same = TRUE;
+		for( i=0; i<var->n_dims; i++ )
+			if( *(s->place+i) != *(place+i) ) {
+				same = FALSE;
+				break;
+				}
+		if( same )
+			return( s );
+		}
+
+	return( NULL );
+}
+
+/*******************************************************************************/
+	static void
+slab_unlink_lru( Slab *s )
+{
+	if( s->newer != NULL )
+		s->newer->older = s->older;
+	else
+		newest = s->older;
+
+	if( s->older != NULL )
+		s->older->newer = s->newer;
+	else
+		oldest = s->newer;
+}
+
+/*******************************************************************************/
+	static void
+slab_link_newest( Slab *s )
+{
+	s->newer = NULL;
+	s->older = newest;
+	if( newest != NULL )
+		newest->newer = s;
+	newest = s;
+	if( oldest == NULL )
+		oldest = s;
+}
+
+/*******************************************************************************/
+	static void
+slab_drop( Slab *s )
+{
+	Slab	**pp;
+
+	pp = &(bucket[s->hash % SLABCACHE_N_BUCKETS]);
+	while( *pp != s )
+		pp = &((*pp)->hash_next);
+	*pp = s->hash_next;
+
+	slab_unlink_lru( s );
+
+	bytes_held -= s->n*sizeof(float);
+	n_held--;
+	membudget_release( MEM_SLABS, s->n*sizeof(float) );
+
+	free( s->place );
+	free( s->data );
+	free( s );
+}
+
+/*******************************************************************************
+ * Called by the memory budget to get back at least 'want' bytes.  Returns
+ * how many were freed.
+ */
+	static size_t
+slabcache_evict( size_t want )
+{
+	size_t	freed;
+
+	freed = 0L;
+	while( (freed < want) && (oldest != NULL) ) {
+		freed += oldest->n*sizeof(float);
+		slab_drop( oldest );
+		}
+	return( freed );
+}
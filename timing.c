@@ -0,0 +1,340 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2008 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrean
+ * San Diego, CA   92122
+ * pierce@cirrus.ucsd.edu
+ */
+
+/*******************************************************************************
+ * 	timing.c
+ *
+ *	Records how long the phases of starting up and the stages of
+ *	drawing each frame take, for the -timing option.  Code that wants
+ *	to be timed brackets the work with TIMING_BEGIN and TIMING_END
+ *	(see ncview.defines.h); when -timing is off, those only test
+ *	options.timing.  Each span is kept, and when ncview exits the
+ *	count, total, median, 95th percentile, and maximum of each stage
+ *	are printed.  With -timing_trace, the spans are also written out
+ *	as a Chrome trace (JSON) file, which can be loaded into
+ *	chrome://tracing or Perfetto to see them on a timeline.
+ *
+ *	When built with COUNT_ALLOCS (see the Makefile), heap allocations
+ *	(calls to malloc, calloc, and realloc, from ncview or the
+ *	libraries) are counted too, and the report says how many happen
+ *	between one frame and the next, which should be none once playback
+ *	has settled down.  Counting works by replacing malloc with one that
+ *	counts and then calls glibc's own, so it is only done with glibc,
+ *	and it is not built in by default since it gets in the way of
+ *	memory checkers such as AddressSanitizer.
+ *
+ *	Spans can be recorded from any thread.
+ *******************************************************************************/
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#include <pthread.h>
+
+#define TIMING_MAX_EVENTS	(1L<<20)	/* about 32 MB of spans */
+
+typedef struct {
+	double		start, dur;	/* seconds since timing_init */
+	int		stage;
+	unsigned long	thread;
+	long		allocs;		/* TIMING_FRAME: heap allocations since the frame before */
+} TimingEvent;
+
+extern Options options;
+
+static char *stage_name[TIMING_N_STAGES] = {
+	"open", "var scan", "aux fill", "dim load", "min/max", "widgets", "first draw",
+	"frame", "read", "unpack", "expand/contract", "quantize", "truecolor", "X upload" };
+
+static TimingEvent	*events   = NULL;
+static long		n_events  = 0L, max_events = 0L, n_dropped = 0L;
+static double		t_origin  = 0.0;
+static int		have_first_draw = FALSE;
+static char		*trace_file = NULL;
+static pthread_mutex_t	lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int		count_allocs = FALSE;
+static long		n_allocs = 0L, allocs_at_frame = 0L;
+
+static void	timing_report( void );
+static void	timing_report_allocs( double *dur );
+static void	timing_write_trace( char *fname );
+static int	double_cmp( const void *a, const void *b );
+
+/*******************************************************************************
+ * Start timing.  The report (and trace file, if trace_fname is not NULL)
+ * is made when the program exits.
+ */
+	void
+timing_init( char *trace_fname )
+{
+	t_origin   = timing_now();
+	trace_file = trace_fname;
+#if defined(COUNT_ALLOCS) && defined(__GLIBC__)
+	count_allocs = TRUE;
+#endif
+	atexit( timing_report );
+}
+
+/*******************************************************************************
+ * Seconds on a clock that only ever goes forward.
+ */
+	double
+timing_now( void )
+{
+	struct timespec	ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return( (double)ts.tv_sec + 1.0e-9*(double)ts.tv_nsec );
+}
+
+/*******************************************************************************
+ * Record a span of the passed stage that started at time t0 (from
+ * timing_now) and ends now.
+ */
+	void
+timing_record( int stage, double t0 )
+{
+	double		t1;
+	TimingEvent	*e;
+
+	t1 = timing_now();
+
+	pthread_mutex_lock( &lock );
+	if( n_events == max_events ) {
+		if( max_events == TIMING_MAX_EVENTS ) {
+			n_dropped++;
+			pthread_mutex_unlock( &lock );
+			return;
+			}
+		max_events = (max_events == 0L) ? 4096L : 2L*max_events;
+		events = (TimingEvent *)realloc( events, max_events*sizeof(TimingEvent) );
+		if( events == NULL ) {
+			fprintf( stderr, "ncview: timing_record: failed on malloc of %ld events\n", max_events );
+			exit( -1 );
+			}
+		}
+	e = events + n_events++;
+	e->start  = t0 - t_origin;
+	e->dur    = t1 - t0;
+	e->stage  = stage;
+	e->thread = (unsigned long)pthread_self();
+	e->allocs = 0L;
+	if( stage == TIMING_FRAME ) {
+		e->allocs       = n_allocs - allocs_at_frame;
+		allocs_at_frame = n_allocs;
+		}
+	pthread_mutex_unlock( &lock );
+}
+
+/*******************************************************************************
+ * Called at the end of every draw; the first one marks how long it took from
+ * starting up to having a picture on the screen.
+ */
+	void
+timing_first_draw( void )
+{
+	if( have_first_draw )
+		return;
+	have_first_draw = TRUE;
+	timing_record( TIMING_FIRST_DRAW, t_origin );
+}
+
+/*******************************************************************************/
+	static void
+timing_report( void )
+{
+	int	stage;
+	long	i, n;
+	double	*dur, total;
+
+	pthread_mutex_lock( &lock );
+
+	dur = (double *)malloc( (n_events+1)*sizeof(double) );
+	if( dur == NULL ) {
+		fprintf( stderr, "ncview: timing_report: failed on malloc\n" );
+		pthread_mutex_unlock( &lock );
+		return;
+		}
+
+	fprintf( stderr, "\nncview timing, in milliseconds:\n" );
+	fprintf( stderr, "%-16s %8s %12s %10s %10s %10s\n", "stage", "count", "total", "p50", "p95", "max" );
+	for( stage=0; stage<TIMING_N_STAGES; stage++ ) {
+		n     = 0L;
+		total = 0.0;
+		for( i=0; i<n_events; i++ )
+			if( (events+i)->stage == stage ) {
+				*(dur+n++) = (events+i)->dur;
+				total += (events+i)->dur;
+				}
+		if( n == 0 )
+			continue;
+		qsort( dur, n, sizeof(double), double_cmp );
+		fprintf( stderr, "%-16s %8ld %12.3f %10.3f %10.3f %10.3f\n", stage_name[stage], n,
+			1000.0*total,
+			1000.0*(*(dur + (n-1)/2)),
+			1000.0*(*(dur + (long)(0.95*(double)(n-1)))),
+			1000.0*(*(dur + n-1)) );
+		}
+	if( n_dropped > 0 )
+		fprintf( stderr, "(%ld spans were not recorded; only the first %ld are kept)\n",
+			n_dropped, (long)TIMING_MAX_EVENTS );
+	timing_report_allocs( dur );
+	free( dur );
+
+	if( trace_file != NULL )
+		timing_write_trace( trace_file );
+
+	pthread_mutex_unlock( &lock );
+}
+
+/*******************************************************************************
+ * The first frame's count includes starting up, so it is reported on its
+ * own.  'dur' has room for every event.
+ */
+	static void
+timing_report_allocs( double *dur )
+{
+	long	i, n, n_none, first;
+
+	if( ! count_allocs ) {
+		fprintf( stderr, "(heap allocations are only counted when built with COUNT_ALLOCS, with glibc)\n" );
+		return;
+		}
+
+	n      = 0L;
+	n_none = 0L;
+	first  = -1L;
+	for( i=0; i<n_events; i++ ) {
+		if( (events+i)->stage != TIMING_FRAME )
+			continue;
+		if( first == -1L ) {
+			first = (events+i)->allocs;
+			continue;
+			}
+		*(dur+n++) = (double)(events+i)->allocs;
+		if( (events+i)->allocs == 0L )
+			n_none++;
+		}
+	if( first == -1L )
+		return;
+
+	fprintf( stderr, "heap allocations: %ld up to the end of the first frame\n", first );
+	if( n == 0 )
+		return;
+	qsort( dur, n, sizeof(double), double_cmp );
+	fprintf( stderr, "heap allocations per frame after that: median %.0f, 95%% %.0f, max %.0f; %ld of %ld frames had none\n",
+		*(dur + (n-1)/2),
+		*(dur + (long)(0.95*(double)(n-1))),
+		*(dur + n-1),
+		n_none, n );
+}
+
+/*******************************************************************************
+ * Write the spans in the Chrome trace event format.  Threads are numbered
+ * in the order they first show up.
+ */
+	static void
+timing_write_trace( char *fname )
+{
+	FILE		*f;
+	long		i;
+	int		tid, n_threads;
+	unsigned long	thread[64];
+
+	if( (f = fopen( fname, "w" )) == NULL ) {
+		fprintf( stderr, "ncview: can't open timing trace file \"%s\" for writing\n", fname );
+		return;
+		}
+
+	n_threads = 0;
+	fprintf( f, "{\"traceEvents\":[\n" );
+	for( i=0; i<n_events; i++ ) {
+		for( tid=0; tid<n_threads; tid++ )
+			if( thread[tid] == (events+i)->thread )
+				break;
+		if( (tid == n_threads) && (n_threads < 64) )
+			thread[n_threads++] = (events+i)->thread;
+		fprintf( f, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d",
+			stage_name[(events+i)->stage],
+			((events+i)->stage < TIMING_FRAME) ? "startup" : "frame",
+			1.0e6*(events+i)->start, 1.0e6*(events+i)->dur, tid+1 );
+		if( (events+i)->stage == TIMING_FRAME )
+			fprintf( f, ",\"args\":{\"allocs\":%ld}", (events+i)->allocs );
+		fprintf( f, "}%s\n", (i == n_events-1) ? "" : "," );
+		}
+	fprintf( f, "],\"displayTimeUnit\":\"ms\"}\n" );
+	fclose( f );
+
+	fprintf( stderr, "timing trace written to %s\n", fname );
+}
+
+/*******************************************************************************/
+	static int
+double_cmp( const void *a, const void *b )
+{
+	double	da, db;
+
+	da = *(double *)a;
+	db = *(double *)b;
+	if( da < db )
+		return( -1 );
+	if( da > db )
+		return( 1 );
+	return( 0 );
+}
+
+#if defined(COUNT_ALLOCS) && defined(__GLIBC__)
+/*******************************************************************************
+ * glibc lets a program supply its own malloc; these count the call and
+ * hand it straight on to glibc's.  free is left alone.
+ */
+extern void	*__libc_malloc( size_t size );
+extern void	*__libc_calloc( size_t n, size_t size );
+extern void	*__libc_realloc( void *ptr, size_t size );
+
+	void *
+malloc( size_t size )
+{
+	if( count_allocs )
+		__sync_fetch_and_add( &n_allocs, 1L );
+	return( __libc_malloc( size ));
+}
+
+	void *
+calloc( size_t n, size_t size )
+{
+	if( count_allocs )
+		__sync_fetch_and_add( &n_allocs, 1L );
+	return( __libc_calloc( n, size ));
+}
+
+	void *
+realloc( void *ptr, size_t size )
+{
+	if( count_allocs )
+		__sync_fetch_and_add( &n_allocs, 1L );
+	return( __libc_realloc( ptr, size ));
+}
+#endif
@@ -49,6 +49,8 @@ static UniqList *uniq = NULL;
 #include "utCalendar_cal.h"
 #include "utCalendar_cal.c"
 
+static CalDate	*cached_date( NCDim *dim, double val );
+
 /******************************************************************************/
 void udu_utinit( char *path )
 {
@@ -199,6 +201,7 @@ void udu_fmt_time( char *temp_string, double new_dimval, NCDim *dim, int include
 	static utUnit	dataunits;
 	int	year, month, day, hour, minute, debug;
 	float	second;
+	CalDate	*date;
 	static  char last_units[1024];
 	static	char months[12][4] = { "Jan\0", "Feb\0", "Mar\0", "Apr\0",
 				       "May\0", "Jun\0", "Jul\0", "Aug\0",
@@ -223,7 +226,15 @@ void udu_fmt_time( char *temp_string, double new_dimval, NCDim *dim, int include
 		strncpy( last_units, dim->units, 1023 );
 		}
 
-	if( utCalendar_cal( new_dimval, &dataunits, &year, &month, &day, &hour, 
+	if( (date = cached_date( dim, new_dimval )) != NULL ) {
+		year   = date->year;
+		month  = date->month;
+		day    = date->day;
+		hour   = date->hour;
+		minute = date->minute;
+		second = date->second;
+		}
+	else if( utCalendar_cal( new_dimval, &dataunits, &year, &month, &day, &hour, 
 				&minute, &second, dim->calendar ) != 0 ) {
 		fprintf( stderr, "internal error: udu_fmt_time can't convert to calendar value!\n");
 		fprintf( stderr, "units: >%s<\n", dim->units );
@@ -257,6 +268,124 @@ void udu_fmt_time( char *temp_string, double new_dimval, NCDim *dim, int include
 		}
 }
 
+/******************************************************************************
+ * Convert all 'n' values of a udunits time dim to dates at once, and keep
+ * them on the dim so that formatting a time along the axis is just a lookup.
+ * 'vals' must be in increasing order; if they are not, nothing is done.
+ * Returns TRUE if the dates were made, in which case 'vals' now belongs to 
+ * the dim and must not be freed by the caller.
+ */
+	int
+udu_cache_dates( NCDim *d, double *vals, size_t n )
+{
+	utUnit	dataunits;
+	int	*year, *month, *day, *hour, *minute, err;
+	float	*second;
+	size_t	i;
+
+	if( (! valid_udunits_pkg) || (! d->timelike) || (d->time_std != TSTD_UDUNITS) || (n == 0) )
+		return( FALSE );
+
+	for( i=1; i<n; i++ )
+		if( *(vals+i) <= *(vals+i-1) )
+			return( FALSE );
+
+	if( utScan( d->units, &dataunits ) != 0 )
+		return( FALSE );
+
+	year   = (int   *)malloc( n*sizeof(int)   );
+	month  = (int   *)malloc( n*sizeof(int)   );
+	day    = (int   *)malloc( n*sizeof(int)   );
+	hour   = (int   *)malloc( n*sizeof(int)   );
+	minute = (int   *)malloc( n*sizeof(int)   );
+	second = (float *)malloc( n*sizeof(float) );
+	d->dates = (CalDate *)malloc( n*sizeof(CalDate) );
+	if( (year == NULL) || (month == NULL) || (day == NULL) || (hour == NULL) ||
+	    (minute == NULL) || (second == NULL) || (d->dates == NULL) ) {
+		fprintf( stderr, "ncview: udu_cache_dates: failed on malloc of %ld dates\n", (long)n );
+		exit( -1 );
+		}
+
+	err = utCalendar_cal_array( vals, n, &dataunits, year, month, day, hour, minute, 
+			second, d->calendar );
+	if( err == 0 ) {
+		for( i=0; i<n; i++ ) {
+			(d->dates+i)->year   = *(year+i);
+			(d->dates+i)->month  = *(month+i);
+			(d->dates+i)->day    = *(day+i);
+			(d->dates+i)->hour   = *(hour+i);
+			(d->dates+i)->minute = *(minute+i);
+			(d->dates+i)->second = *(second+i);
+			}
+		d->n_dates     = n;
+		d->date_values = vals;
+		}
+	else
+		{
+		free( d->dates );
+		d->dates = NULL;
+		}
+
+	free( year );
+	free( month );
+	free( day );
+	free( hour );
+	free( minute );
+	free( second );
+
+	return( err == 0 );
+}
+
+/******************************************************************************
+ * Find the cached date for dim value 'val', or NULL if there isn't one.  The
+ * value is first looked for exactly.  Failing that, if 'val' is a float (as
+ * the values in dim->values are), a dim value that rounds to the same float
+ * is taken as long as it is the only one that does.
+ */
+	static CalDate *
+cached_date( NCDim *dim, double val )
+{
+	size_t	lo, hi, mid, n;
+	double	*dv;
+	float	fval;
+
+	if( dim->dates == NULL )
+		return( NULL );
+
+	n  = dim->n_dates;
+	dv = dim->date_values;
+
+	lo = 0;
+	hi = n;
+	while( lo < hi ) {
+		mid = (lo + hi)/2;
+		if( *(dv+mid) < val )
+			lo = mid + 1;
+		else
+			hi = mid;
+		}
+	if( (lo < n) && (*(dv+lo) == val) )
+		return( dim->dates + lo );
+
+	fval = (float)val;
+	if( (double)fval != val )
+		return( NULL );
+
+	lo = 0;
+	hi = n;
+	while( lo < hi ) {
+		mid = (lo + hi)/2;
+		if( (float)*(dv+mid) < fval )
+			lo = mid + 1;
+		else
+			hi = mid;
+		}
+	if( (lo < n) && ((float)*(dv+lo) == fval) && ((lo+1 == n) || ((float)*(dv+lo+1) != fval)) )
+		return( dim->dates + lo );
+
+	return( NULL );
+}
+
 /******************************************************************************/
 	static int 
 is_unique( char *units )
@@ -311,4 +440,9 @@ void udu_fmt_time( char *temp_string, double new_dimval, NCDim *dim, int include
 	sprintf( temp_string, "%g", new_dimval );
 }
 
+int udu_cache_dates( NCDim *d, double *vals, size_t n )
+{
+	return( FALSE );
+}
+
 #endif
@@ -27,6 +27,10 @@ character argument at the end that indicates the calendar to use.  The calendar
 can be "standard", "noleap", "365_day", or "360_day" at the moment.  If the calendar
 string is set to NULL, a standard calendar is used.
 
+utCalendar_cal_array does the same conversion for a whole array of values at once,
+which is much faster than converting them one by one for the noleap and 360_day
+calendars.
+
 Note that these routines call the udunits routines, so they have to be installed to use this!
 
 Version 2.03
@@ -48,11 +52,21 @@ Thanks to Christian Page' of CERFACS, France, for bug fixes!
 static long days_per_month_reg_year[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
 static long days_per_month_360[]      = { 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30 };
 
+#define CAL_STANDARD	0
+#define CAL_NOLEAP	1
+#define CAL_360		2
+
 static utUnit udu_origin_zero, udu_days;
+static int init_origin_zero( void );
+static int calendar_type( char *calendar );
 static double udu_sec_since_ref_date( double val, utUnit *dataunits, int *yr0, int *mon0, 
 		int *day0, int *hr0, int *min0, float *sec0 );
 static int utCalendar_noleap_inner( double val, utUnit *dataunits, int *year, int *month, int *day, int *hour, 
 				int *minute, float *second, int days_per_year, long *days_per_month );
+static long noleap_ref_days( int mon0, int day0, long *days_per_month );
+static void noleap_from_ref( double ss, int yr0, long ref_days, int hr0, int min0, int *year, 
+				int *month, int *day, int *hour, int *minute, float *second, 
+				int days_per_year, long *days_per_month );
 static int utCalendar_360( double val, utUnit *dataunits, int *year, int *month, int *day, int *hour, 
 				int *minute, float *second );
 static int utCalendar_noleap( double val, utUnit *dataunits, int *year, int *month, int *day, int *hour, 
@@ -94,54 +108,129 @@ static void dateify( int year, int month, int day, int hour, int minute,
 int utCalendar_cal( double val, utUnit *dataunits, int *year, int *month, int *day, int *hour, 
 				int *minute, float *second, char *calendar ) 
 {
-	int err;
-	static int have_shown_warning = 0;
-	static int have_initted = 0;
-
 #ifdef DEBUG
 	printf( "entering utCalendar_cal\n" );
 	printf( "Input value: %lf  Input calendar: %s\n", val, calendar );
 #endif
 
-	if( have_initted == 0 ) {
+	if( init_origin_zero() != 0 )
+		return(-1);
+
+	switch( calendar_type( calendar )) {
+		case CAL_NOLEAP:
+			return( utCalendar_noleap( val, dataunits, year, month, day, hour, minute, second ));
+
+		case CAL_360:
+			return( utCalendar_360( val, dataunits, year, month, day, hour, minute, second ));
+
+		default:
+			return( utCalendar( val, dataunits, year, month, day, hour, minute, second ));
+		}
+}
+
+/******************************************************************************/
+/* Converts the 'n' values in val[] to dates, the same as calling utCalendar_cal
+ * on each one, and puts the results in the passed arrays, which must each have
+ * room for 'n' entries.  The calendar is looked up only once, and for the 
+ * noleap and 360_day calendars the reference date in the units is also only 
+ * worked out once, which is the expensive part of the conversion.
+ */
+int utCalendar_cal_array( double *val, size_t n, utUnit *dataunits, int *year, int *month, int *day, 
+				int *hour, int *minute, float *second, char *calendar )
+{
+	int	err, yr0, mon0, day0, hr0, min0, days_per_year;
+	float	sec0;
+	long	*days_per_month, ref_days;
+	size_t	i;
+
+	if( init_origin_zero() != 0 )
+		return(-1);
+
+	switch( calendar_type( calendar )) {
+		case CAL_NOLEAP:
+			days_per_year  = 365;
+			days_per_month = days_per_month_reg_year;
+			break;
+
+		case CAL_360:
+			days_per_year  = 360;
+			days_per_month = days_per_month_360;
+			break;
+
+		default:
+			for( i=0; i<n; i++ ) {
+				err = utCalendar( val[i], dataunits, year+i, month+i, day+i, hour+i,
+						minute+i, second+i );
+				if( err != 0 )
+					return( err );
+				}
+			return(0);
+		}
+
+	udu_sec_since_ref_date( 0.0, dataunits, &yr0, &mon0, &day0, &hr0, &min0, &sec0 );
+	ref_days = noleap_ref_days( mon0, day0, days_per_month );
+	for( i=0; i<n; i++ )
+		noleap_from_ref( val[i] * dataunits->factor, yr0, ref_days, hr0, min0, year+i, month+i,
+				day+i, hour+i, minute+i, second+i, days_per_year, days_per_month );
+
+	return(0);
+}
+
+/******************************************************************************/
+/* The idea of this snippet is to "trick" the udunits library into telling us the year, month,
+ * and date that the user specified in the units string.  This prevents us from having to 
+ * reinvent the wheel by parsing the units string ourselves.  See further comments
+ * in routine udu_sec_since_ref_date
+ */
+static int init_origin_zero( void )
+{
+	int err;
+	static int have_initted = 0;
+
+	if( have_initted )
+		return(0);
+
 #ifdef DEBUG
-		printf( "utCalendar_cal: initting\n" );
+	printf( "utCalendar_cal: initting\n" );
 #endif
-		/*-------------------------------------------------------------------------------------------
-		 * The idea of this snippet is to "trick" the udunits library into telling us the year, month,
-		 * and date that the user specified in the units string.  This prevents us from having to 
-		 * reinvent the wheel by parsing the units string ourselves.  See further comments
-		 * in routine udu_sec_since_ref_date
-		 *------------------------------------------------------------------------------------------*/
-		err = utScan( "seconds since 1234-05-06 00:00", &udu_origin_zero );  /* YYYY-MM-DD used here is irrelevant */
-		if( err == 0 ) {
-			udu_origin_zero.origin = 0.0;   /* override specified YYYY-MM-DD to set to same date as lib uses internally */
-			}
-		else
-			{
-			fprintf( stderr, "Error, could not decode internal date string for reference date!\n" );
-			return(-1);
-			}
-		have_initted = 1;
+	err = utScan( "seconds since 1234-05-06 00:00", &udu_origin_zero );  /* YYYY-MM-DD used here is irrelevant */
+	if( err == 0 ) {
+		udu_origin_zero.origin = 0.0;   /* override specified YYYY-MM-DD to set to same date as lib uses internally */
+		}
+	else
+		{
+		fprintf( stderr, "Error, could not decode internal date string for reference date!\n" );
+		return(-1);
 		}
+	have_initted = 1;
+	return(0);
+}
+
+/******************************************************************************/
+/* Which of the calendars we know how to do should be used for the passed 
+ * CF-1.0 calendar name.  Warns about the ones we don't know.
+ */
+static int calendar_type( char *calendar )
+{
+	static int have_shown_warning = 0;
 
 	if( (calendar == NULL) || (strncasecmp(calendar,"standard",8)==0) || (strncasecmp(calendar,"gregorian",9)==0) ) {
 #ifdef DEBUG
 		printf( "utCalendar_cal: using standard calendar\n" );
 #endif
-		return( utCalendar( val, dataunits, year, month, day, hour, minute, second ));
+		return( CAL_STANDARD );
 		}
 	else if( (strncasecmp(calendar,"365_day",7)==0) || (strncasecmp(calendar,"noleap",6)==0) ) {
 #ifdef DEBUG
 		printf( "utCalendar_cal: using 365-day calendar\n" );
 #endif
-		return( utCalendar_noleap( val, dataunits, year, month, day, hour, minute, second ));
+		return( CAL_NOLEAP );
 		}
 	else if( strncasecmp(calendar,"360_day",7)==0) {
 #ifdef DEBUG
 		printf( "utCalendar_cal: using 360-day calendar\n" );
 #endif
-		return( utCalendar_360( val, dataunits, year, month, day, hour, minute, second ));
+		return( CAL_360 );
 		}
 	else if( strncasecmp(calendar,"proleptic_gregorian",19)==0) {
 		if( shown_proleptic_warning == 0 ) {
@@ -150,11 +239,11 @@ int utCalendar_cal( double val, utUnit *dataunits, int *year, int *month, int *d
 			fprintf( stderr, "********************************************************************************\n" );
 			shown_proleptic_warning = 1;
 			}
-		return( utCalendar( val, dataunits, year, month, day, hour, minute, second ));
+		return( CAL_STANDARD );
 		}
 	else if( strncasecmp(calendar,"julian",6)==0) {
 		fprintf( stderr, "sorry, julian calendar not implemented yet; using standard calendar\n" );
-		return( utCalendar( val, dataunits, year, month, day, hour, minute, second ));
+		return( CAL_STANDARD );
 		}
 	else
 		{
@@ -162,7 +251,7 @@ int utCalendar_cal( double val, utUnit *dataunits, int *year, int *month, int *d
 			fprintf( stderr, "WARNING: unknown calendar: \"%s\". Using standard calendar instead!\n", calendar );
 			have_shown_warning = 1;
 			}
-		return( utCalendar( val, dataunits, year, month, day, hour, minute, second ));
+		return( CAL_STANDARD );
 		}
 }
 
@@ -205,13 +294,7 @@ int utCalendar_noleap_inner( double val, utUnit *dataunits, int *year, int *mont
 {
 	int yr0, mon0, day0, hr0, min0;
 	float sec0;
-	double ss, ss_extra;
-	long dy, ds, sec_per_day, sec_per_hour, sec_per_min, nny;
-	long nhrs, nmin;
-
-	sec_per_day   = 86400;
-	sec_per_hour  = 3600;
-	sec_per_min   = 60;
+	double ss;
 
 	/* -------------------------------------------------------------------------------------
 	 * Get both the REFERENCE TIME that the netCDF file specifies for the units string
@@ -225,6 +308,46 @@ int utCalendar_noleap_inner( double val, utUnit *dataunits, int *year, int *mont
  	printf( "converting time %lf seconds since %04d-%02d-%02d %02d:%02d\n", ss, yr0, mon0, day0, hr0, min0 ); 
 #endif
 
+	noleap_from_ref( ss, yr0, noleap_ref_days( mon0, day0, days_per_month ), hr0, min0,
+		year, month, day, hour, minute, second, days_per_year, days_per_month );
+
+	return(0);
+}
+
+/*************************************************************************************/
+/* Number of days from 1 Jan to the reference date's month and day.  This only
+ * depends on the units, so when converting many values it is done just once.
+ */
+static long noleap_ref_days( int mon0, int day0, long *days_per_month )
+{
+	long ds;
+
+	ds = day0-1;
+	while( mon0 > 1 ) {
+		ds += days_per_month[ mon0-2 ];	/*  -2 cuz -1 for prev month, -1 for 0 offset */
+		mon0--;
+		}
+
+	return( ds );
+}
+
+/*************************************************************************************/
+/* Turns 'ss' seconds since the reference date into a date.  The reference date
+ * is given as its year, the days from 1 Jan of that year to its month and day 
+ * (from noleap_ref_days), and its hour and minute.
+ */
+static void noleap_from_ref( double ss, int yr0, long ref_days, int hr0, int min0, int *year, 
+				int *month, int *day, int *hour, int *minute, float *second, 
+				int days_per_year, long *days_per_month )
+{
+	double ss_extra;
+	long dy, ds, sec_per_day, sec_per_hour, sec_per_min, nny;
+	long nhrs, nmin;
+
+	sec_per_day   = 86400;
+	sec_per_hour  = 3600;
+	sec_per_min   = 60;
+
 	/*--------------------------------------------------------------------------
 	 * If we have a date before our reference date (indicated by a negative ss),
 	 * then wind back the reference date to to be before the target
@@ -257,22 +380,9 @@ int utCalendar_noleap_inner( double val, utUnit *dataunits, int *year, int *mont
 	/*--------------------------------------
 	 * Easier to do things relative to 1 Jan 
 	 *-------------------------------------*/
-	if( (min0 != 0) || (hr0 != 0) || (day0 != 1) || (mon0 != 1)) {
-
-		ss_extra += min0 * sec_per_min;
-		min0 = 0;
-
-		ss_extra += hr0 * sec_per_hour;
-		hr0 = 0;
-
-		ds += (day0-1);
-		day0 = 1;
-
-		while( mon0 > 1 ) {
-			ds += days_per_month[ mon0-2 ];	/*  -2 cuz -1 for prev month, -1 for 0 offset */
-			mon0--;
-			}
-		}
+	ss_extra += min0 * sec_per_min;
+	ss_extra += hr0 * sec_per_hour;
+	ds += ref_days;
 
 	dy = ds / days_per_year;
 	*year = yr0 + dy;
@@ -295,8 +405,6 @@ int utCalendar_noleap_inner( double val, utUnit *dataunits, int *year, int *mont
 	ss_extra -= nmin * sec_per_min;
 
 	*second = ss_extra;
-
-	return(0);
 }
 
 /******************************************************************************/
@@ -1,3 +1,7 @@
 int utCalendar_cal( double val, utUnit *dataunits, int *year, int *month, int *day, int *hour, 
 				int *minute, float *second, char *calendar );
 
+int utCalendar_cal_array( double *val, size_t n, utUnit *dataunits, int *year, int *month, int *day, 
+				int *hour, int *minute, float *second, char *calendar );
+int utInvCalendar_cal( int year, int month, int day, int hour, int minute, 
+		double second, utUnit *unit, double *value, const char *calendar );
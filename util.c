@@ -45,20 +45,71 @@ extern NCVar     *variables;
 extern ncv_pixel *pixel_transform;
 extern FrameStore framestore;
 
+/* A range scan run on the worker thread; see init_min_max_background */
+typedef struct {
+	NCVar	*var;
+	size_t	n_timesteps, n_other;
+	int	method, whole;		/* whole: read every time entry */
+	float	min, max;		/* what the scan has found */
+	float	user_min, user_max;	/* the variable's range when the scan started */
+	float	*data;			/* one time entry; see min_max_scan_start */
+} MinMaxScan;
+
 static void get_min_max_onestep( NCVar *var, size_t n_other, size_t tstep, float *data, 
 					float *min, float *max, int verbose );
+static int  min_max_scan_start( NCVar *var, int whole, int modal );
+static void min_max_scan_work( WorkerTask *task );
+static void min_max_scan_done( WorkerTask *task, int use_result );
+static long min_max_scan_n_steps( MinMaxScan *scan );
+static size_t min_max_scan_step( MinMaxScan *scan, long k );
 static void handle_time_dim( int fileid, NCVar *v, int dimid );
 static int  months_calc_tgran( int fileid, NCDim *d );
-static float util_mean( float *x, size_t n, float fill_value );
-static float util_mode( float *x, size_t n, float fill_value );
-static void contract_data( float *small_data, View *v, float fill_value );
+static float util_mode( float *x, size_t n, float fill_value, RenderScratch *s );
+static void contract_data_mean( float *small_data, float *data, long nx, long ny, long n, 
+		size_t x0, size_t y0, size_t w, size_t h, float fill_value, RenderScratch *s );
+static void contract_data_mode( float *small_data, float *data, long nx, long ny, long n, 
+		size_t x0, size_t y0, size_t w, size_t h, float fill_value, RenderScratch *s );
 static int equivalent_FDBs( NCVar *v1, NCVar *v2 );
+static unsigned long name_hash( char *s );
+static NCDim *find_identical_dim( NCVar *v, NCDim *d );
+static void copy_dim_info( NCDim *dsrc, NCDim *d, size_t dim_len );
+static void load_dim_info( NCVar *v, int i );
+static int stringlist_cmp( const void *a, const void *b );
 static int data_has_mv( float *data, size_t n, float fill_value );
+static float *reduced_field( View *v, float fill_value, size_t new_x_size, size_t new_y_size );
+static void overlay_pixels( ncv_pixel *pixels, size_t x_size, size_t y_size, size_t new_x_size, 
+		size_t new_y_size, long blowup, size_t px0, size_t py0, size_t pw, size_t ph );
+static void expand_data_bilinear( float *big_data, float *data, size_t x_size, size_t y_size, 
+		int blowup, float fill_val, size_t x0, size_t y0, size_t w, size_t h, RenderScratch *s );
+static RenderScratch *view_scratch( View *v );
+static void bilin_interp_row( float *src, size_t x_size, size_t i0, size_t nspan, int blowup, 
+		float *weight, float fill_val, float *dest, char *mask );
 
 /* Variables local to routines in this file */
 static  char    *month_name[12] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
 	"Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
 
+/* Variables on the global list are also kept in a hash table by name, so that
+ * get_var doesn't have to walk the list.  Dims that have had their values 
+ * read are kept in a hash table by their identity -- the dim name plus the 
+ * set of files the variable lives in -- so that the values are only read 
+ * once however many variables share the dim.
+ */
+#define NAME_HASH_N_BUCKETS	1024
+
+typedef struct _dimreg {
+	NCVar	*var;
+	NCDim	*dim;
+	unsigned long hash;
+	struct _dimreg *next;
+} DimReg;
+
+static	NCVar	*var_bucket[NAME_HASH_N_BUCKETS];
+static	DimReg	*dim_bucket[NAME_HASH_N_BUCKETS];
+
+/* What views with no scratch of their own draw with */
+static	RenderScratch main_scratch;
+
 /*******************************************************************************
  * Determine whether the data is "close enough" to the fill value
  */
@@ -130,62 +181,77 @@ add_to_stringlist( Stringlist **list, char *new_string, void *aux )
 }
 
 /*******************************************************************************
- * Adds the given string to the list, and returns a pointer to the 
- * new list element, with alphabetic ordering.
+ * Adds the given string to the front of the list, and returns a pointer to
+ * the new list element.  This is quick no matter how long the list is; 
+ * build a list this way and then call sort_stringlist once to get it in
+ * alphabetic order.
  */
 	Stringlist *
-add_to_stringlist_ordered( Stringlist **list, char *new_string, void *aux )
+prepend_to_stringlist( Stringlist **list, char *new_string, void *aux )
 {
-	Stringlist 	*cursor, *new_el, *prev_el;
-	int		i;
+	Stringlist 	*new_el;
 
 	new_stringlist( &new_el );
 	new_el->string = (char *)malloc( strlen( new_string )+1);
-	if( new_el == NULL ) {
-		fprintf( stderr, "ncview: add_to_stringlist: malloc failed\n" );
+	if( new_el->string == NULL ) {
+		fprintf( stderr, "ncview: prepend_to_stringlist: malloc failed\n" );
 		fprintf( stderr, "string trying to add: %s\n", new_string );
 		exit( -1 );
 		}
 	strcpy( new_el->string, new_string );
-	new_el->aux    = aux;
+	new_el->aux   = aux;
+	new_el->prev  = NULL;
+	new_el->next  = *list;
+	new_el->index = 0;
+	if( *list != NULL )
+		(*list)->prev = new_el;
+	*list = new_el;
 
-	i = 0;
-	if( *list == NULL ) {
-		*list = new_el;
-		new_el->prev = NULL;
+	return( new_el );
+}
+
+/*******************************************************************************
+ * Put the list into alphabetic order, and renumber the indices to match.
+ */
+	void
+sort_stringlist( Stringlist **list )
+{
+	Stringlist	*cursor, **els;
+	int		i, n;
+
+	n = 0;
+	for( cursor = *list; cursor != NULL; cursor = cursor->next )
+		n++;
+	if( n == 0 )
+		return;
+
+	els = (Stringlist **)malloc( n*sizeof(Stringlist *) );
+	if( els == NULL ) {
+		fprintf( stderr, "ncview: sort_stringlist: malloc failed on %d entries\n", n );
+		exit( -1 );
 		}
-	else
-		{
-		i = 1;
-		cursor = *list;
-		prev_el = NULL;
-		while( (cursor != NULL) && (strcmp( new_string, cursor->string) > 0)) {
-			prev_el = cursor;
-			cursor  = cursor->next;
-			i++;
-			}
-		if( cursor == NULL ) {
-			prev_el->next = new_el;
-			new_el->prev  = prev_el;
-			}
-		else if( prev_el == NULL ) {
-			*list = new_el;
-			new_el->next = cursor;
-			cursor->prev = new_el;
-			}
-		else
-			{
-			new_el->next = cursor;
-			cursor->prev = new_el;
-			prev_el->next = new_el;
-			new_el->prev  = prev_el;
-			}
+	i = 0;
+	for( cursor = *list; cursor != NULL; cursor = cursor->next )
+		*(els+i++) = cursor;
+
+	qsort( els, n, sizeof(Stringlist *), stringlist_cmp );
+
+	for( i=0; i<n; i++ ) {
+		(*(els+i))->prev  = (i == 0)   ? NULL : *(els+i-1);
+		(*(els+i))->next  = (i == n-1) ? NULL : *(els+i+1);
+		(*(els+i))->index = i;
 		}
-	new_el->index = i;
+	*list = *els;
 
-	return( new_el );
+	free( els );
 }
 
+/*******************************************************************************/
+	static int
+stringlist_cmp( const void *a, const void *b )
+{
+	return( strcmp( (*(Stringlist **)a)->string, (*(Stringlist **)b)->string ));
+}
 
 /*******************************************************************************
  * Concatenate onto a stringlist
@@ -213,13 +279,18 @@ new_stringlist( Stringlist **el )
 }
 
 /******************************************************************************
- * Add the passed NCVar element to the list 
+ * Add the passed NCVar element to the list, and index it by name for get_var
  */
 	void
 add_to_varlist( NCVar **list, NCVar *new_el )
 {
 	int	i;
 	NCVar	*cursor;
+	unsigned long h;
+
+	h = name_hash( new_el->name ) % NAME_HASH_N_BUCKETS;
+	new_el->hash_next = var_bucket[h];
+	var_bucket[h] = new_el;
 
 	i = 0;
 	if( *list == NULL ) {
@@ -265,6 +336,7 @@ new_fdblist( FDBlist **el )
 
 #ifdef INC_UDUNITS
 	(*el)->udunits	    = (utUnit *)malloc( sizeof(utUnit) );
+	(*el)->recdim_conv  = RECDIM_CONV_UNKNOWN;
 #endif
 
 	strcpy( (*el)->filename, "UNINITIALIZED" );
@@ -321,6 +393,191 @@ data_has_mv( float *data, size_t n, float fill_value )
 	return(0);
 }
 
+/******************************************************************************
+ * Extend *min and *max to cover the valid values of the 'n' data points,
+ * i.e., those that are not NaN, not the fill value (as close_enough judges
+ * it), and not FILL_FLOAT.  Returns the number of valid points.  The fill
+ * test and the min/max are done in the same pass over the data, without
+ * branches, and RANGE_LANES points at a time into separate extremes, so 
+ * that the compiler can turn the inner loop into SIMD instructions.
+ */
+#define RANGE_LANES	8
+
+	size_t
+data_valid_range( float *data, size_t n, float fill_value, float *min, float *max )
+{
+	size_t	i, n_valid, count[RANGE_LANES];
+	float	d, diff, criterion, lo[RANGE_LANES], hi[RANGE_LANES];
+	int	k, valid;
+
+	if( fill_value == 0.0 )
+		criterion = 1.0e-5;
+	else if( fill_value < 0.0 )
+		criterion = -1.0e-5*fill_value;
+	else
+		criterion = 1.0e-5*fill_value;
+
+	/* The fill test is written as !(diff <= criterion), the same as
+	 * close_enough, so that a NaN fill value (which xarray writes by
+	 * default), where every diff is NaN, marks nothing as fill; the NaN
+	 * points themselves are thrown out by d == d.
+	 */
+	for( k=0; k<RANGE_LANES; k++ ) {
+		lo[k]    = *min;
+		hi[k]    = *max;
+		count[k] = 0L;
+		}
+
+	for( i=0; i+RANGE_LANES <= n; i += RANGE_LANES )
+		for( k=0; k<RANGE_LANES; k++ ) {
+			d        = *(data+i+k);
+			diff     = d - fill_value;
+			diff     = (diff < 0.0f) ? -diff : diff;
+			valid    = (d == d) & (! (diff <= criterion)) & (d != FILL_FLOAT);
+			lo[k]    = (valid & (d < lo[k])) ? d : lo[k];
+			hi[k]    = (valid & (d > hi[k])) ? d : hi[k];
+			count[k] += valid;
+			}
+
+	/* Whatever is left over when n isn't a multiple of RANGE_LANES */
+	for( ; i<n; i++ ) {
+		d        = *(data+i);
+		diff     = d - fill_value;
+		diff     = (diff < 0.0f) ? -diff : diff;
+		valid    = (d == d) & (! (diff <= criterion)) & (d != FILL_FLOAT);
+		lo[0]    = (valid & (d < lo[0])) ? d : lo[0];
+		hi[0]    = (valid & (d > hi[0])) ? d : hi[0];
+		count[0] += valid;
+		}
+
+	n_valid = 0L;
+	for( k=0; k<RANGE_LANES; k++ ) {
+		if( lo[k] < *min )
+			*min = lo[k];
+		if( hi[k] > *max )
+			*max = hi[k];
+		n_valid += count[k];
+		}
+
+	return( n_valid );
+}
+
+/******************************************************************************
+ * Work out the range that the frame now in v->data is drawn with when
+ * options.range_mode is RANGE_MODE_FRAME: its own min and max, blended with
+ * the range of the frame drawn before it if options.range_smooth is set,
+ * so that the colors don't flicker when animating.  The result goes in
+ * v->frame_min and v->frame_max, and is remembered for the frame so that
+ * the labels can be set when it is redrawn from the saved frames.
+ */
+	void
+set_frame_range( View *v )
+{
+	size_t	x_size, y_size, frameno, n_frames, i;
+	float	min, max, w;
+
+	x_size = *(v->variable->size + v->x_axis_id);
+	y_size = *(v->variable->size + v->y_axis_id);
+
+	min = 1.0e35;
+	max = -min;
+	if( data_valid_range( (float *)v->data, x_size*y_size, v->variable->fill_value,
+				&min, &max ) == 0 ) {
+		min = 0.0;
+		max = 1.0;
+		}
+	else if( min == max ) {
+		if( max == 0.0 )
+			max = 1.0;
+		else if( max > 0.0 )
+			min = 0.0;
+		else
+			max = 0.0;
+		}
+
+	if( v->scan_axis_id == -1 ) {
+		frameno  = 0L;
+		n_frames = 1L;
+		}
+	else
+		{
+		frameno  = *(v->var_place    + v->scan_axis_id);
+		n_frames = *(v->variable->size + v->scan_axis_id);
+		}
+
+	/* Smooth against the last different frame, so that drawing the
+	 * same frame again (e.g., at full resolution after a coarse
+	 * version) gives the same range.
+	 */
+	if( v->have_frame_range && (frameno != v->range_frameno) ) {
+		v->prev_min        = v->frame_min;
+		v->prev_max        = v->frame_max;
+		v->have_prev_range = TRUE;
+		}
+	if( v->have_prev_range && (options.range_smooth > 0.0) ) {
+		w   = options.range_smooth;
+		min = w*v->prev_min + (1.0-w)*min;
+		max = w*v->prev_max + (1.0-w)*max;
+		}
+
+	v->frame_min           = min;
+	v->frame_max           = max;
+	v->range_frameno       = frameno;
+	v->have_frame_range    = TRUE;
+	v->frame_range_current = TRUE;
+
+	if( v->n_frame_ranges != n_frames ) {
+		if( v->frame_ranges != NULL )
+			free( v->frame_ranges );
+		v->frame_ranges = (float *)malloc( 2*n_frames*sizeof(float) );
+		if( v->frame_ranges == NULL ) {
+			fprintf( stderr, "ncview: set_frame_range: failed on malloc\n" );
+			exit( -1 );
+			}
+		v->n_frame_ranges = n_frames;
+		for( i=0; i<n_frames; i++ ) {
+			*(v->frame_ranges + 2*i)   = 1.0;
+			*(v->frame_ranges + 2*i+1) = 0.0;
+			}
+		}
+	*(v->frame_ranges + 2*frameno)   = min;
+	*(v->frame_ranges + 2*frameno+1) = max;
+}
+
+/******************************************************************************
+ * Returns TRUE, and sets min and max, if the indicated frame has been drawn
+ * with a per frame range since the last call to forget_frame_ranges.
+ */
+	int
+get_frame_range( View *v, size_t frameno, float *min, float *max )
+{
+	if( (v->frame_ranges == NULL) || (frameno >= v->n_frame_ranges) )
+		return( FALSE );
+	if( *(v->frame_ranges + 2*frameno+1) < *(v->frame_ranges + 2*frameno) )
+		return( FALSE );
+
+	*min = *(v->frame_ranges + 2*frameno);
+	*max = *(v->frame_ranges + 2*frameno+1);
+	return( TRUE );
+}
+
+/******************************************************************************
+ * The saved frames have been thrown out, so the ranges they were drawn
+ * with are no longer needed.  The smoothing starts over as well.
+ */
+	void
+forget_frame_ranges( View *v )
+{
+	size_t	i;
+
+	for( i=0; i<v->n_frame_ranges; i++ ) {
+		*(v->frame_ranges + 2*i)   = 1.0;
+		*(v->frame_ranges + 2*i+1) = 0.0;
+		}
+	v->have_frame_range = FALSE;
+	v->have_prev_range  = FALSE;
+}
+
 /******************************************************************************
  * Scale the data, replicate it, and convert to a pixel type array.  I'm afraid
  * that for speed, this considers 'ncv_pixel' to be a single byte value.  Make sure
@@ -330,12 +587,33 @@ data_has_mv( float *data, size_t n, float fill_value )
 	int
 data_to_pixels( View *v )
 {
-	long	i, j, j2;
 	size_t	x_size, y_size, new_x_size, new_y_size;
+
+	x_size = *(v->variable->size + v->x_axis_id);
+	y_size = *(v->variable->size + v->y_axis_id);
+	view_get_scaled_size( options.blowup, x_size, y_size, &new_x_size, &new_y_size );
+
+	return( data_to_pixels_region( v, 0L, 0L, new_x_size, new_y_size ));
+}
+
+/******************************************************************************
+ * Same as data_to_pixels, but only the pw x ph rectangle of the pixel array
+ * that starts at (px0,py0) is filled in.  The pixel array is always the full
+ * scaled size; this is what lets us render just what is visible when the 
+ * image is bigger than the window.
+ */
+	int
+data_to_pixels_region( View *v, size_t px0, size_t py0, size_t pw, size_t ph )
+{
+	long	i, j, j2;
+	size_t	x_size, y_size, new_x_size, new_y_size, sy0;
 	ncv_pixel pix_val;
-	float	data_range, rawdata, data, fill_value, *scaled_data;
-	long	blowup, result, orig_minmax_method;
+	float	data_range, range_min, range_max, rawdata, data, fill_value;
+	long	blowup, result;
 	char	error_message[1024];
+	float	*scaled_data, *reduced;
+	RenderScratch *s;
+	double	t0;
 
 	/* Make sure the limits have been set on this variable.
 	 * They won't always be because an initial expose event can 
@@ -352,35 +630,59 @@ data_to_pixels( View *v )
 
 	view_get_scaled_size( options.blowup, x_size, y_size, &new_x_size, &new_y_size );
 
-	scaled_data   = (float *)malloc( new_x_size*new_y_size*sizeof(float));
-	if( scaled_data == NULL ) {
-		fprintf( stderr, "ncview: data_to_pixels: can't allocate data expansion array\n" );
-		fprintf( stderr, "requested size: %ld bytes\n", new_x_size*new_y_size*sizeof(float) );
-		fprintf( stderr, "new_x_size, new_y_size, float_size: %ld %ld %ld\n", 
-				new_x_size, new_y_size, sizeof(float) );
-		fprintf( stderr, "blowup: %d\n", options.blowup );
-		exit( -1 );
-		}
+	if( (pw == 0) || (ph == 0) )
+		return( 0 );
 
-	/* If we are doing overlays, implement them */
-	if( options.overlay->doit && (options.overlay->overlay != NULL)) {
-		for( i=0; i<(x_size*y_size); i++ ) {
-			*((float *)v->data + i) = 
-			     (float)(1 - *(options.overlay->overlay+i)) * *((float *)v->data + i) +
-			     (float)(*(options.overlay->overlay+i)) * v->variable->fill_value;
+	/* Kept between calls, since we are called once per tile when only
+	 * rendering the visible part of the image
+	 */
+	s = view_scratch( v );
+	if( pw*ph > s->scaled_data_size ) {
+		if( s->scaled_data != NULL ) {
+			free( s->scaled_data );
+			membudget_release( MEM_RENDER, s->scaled_data_size*sizeof(float) );
+			s->scaled_data      = NULL;
+			s->scaled_data_size = 0L;
+			}
+		s->scaled_data = (float *)malloc( pw*ph*sizeof(float));
+		if( s->scaled_data == NULL ) {
+			fprintf( stderr, "ncview: data_to_pixels: can't allocate data expansion array\n" );
+			fprintf( stderr, "requested size: %ld bytes\n", pw*ph*sizeof(float) );
+			fprintf( stderr, "new_x_size, new_y_size, float_size: %ld %ld %ld\n", 
+					new_x_size, new_y_size, sizeof(float) );
+			fprintf( stderr, "blowup: %d\n", options.blowup );
+			exit( -1 );
 			}
+		s->scaled_data_size = pw*ph;
+		membudget_charge( MEM_RENDER, s->scaled_data_size*sizeof(float) );
 		}
+	scaled_data = s->scaled_data;
 
 	fill_value = v->variable->fill_value;
 
-	if( blowup > 0 )
-		expand_data( scaled_data, v );
+	/* The pixel array is flipped top to bottom relative to the data
+	 * unless invert_physical is set, so work out which rows of the
+	 * scaled data this region needs.
+	 */
+	if( options.invert_physical )
+		sy0 = py0;
 	else
-		contract_data( scaled_data, v, fill_value );
+		sy0 = new_y_size - (py0 + ph);
 
-	data_range = v->variable->user_max - v->variable->user_min;
+	TIMING_BEGIN( t0 );
+	if( blowup > 0 )
+		expand_data( scaled_data, v, px0, sy0, pw, ph );
+	else if( (reduced = reduced_field( v, fill_value, new_x_size, new_y_size )) != NULL ) {
+		for( j=0; j<ph; j++ )
+			memcpy( scaled_data + j*pw, reduced + px0 + (sy0+j)*new_x_size, pw*sizeof(float) );
+		}
+	else
+		contract_data( scaled_data, v, fill_value, px0, sy0, pw, ph );
+	TIMING_END( TIMING_RESAMPLE, t0 );
 
-	if( (v->variable->user_max == 0) &&
+	/* A frame's own range has already been made usable by set_frame_range */
+	if( (options.range_mode == RANGE_MODE_GLOBAL) &&
+	    (v->variable->user_max == 0) &&
 	    (v->variable->user_min == 0) ) {
 		in_set_cursor_normal();
 		in_button_pressed( BUTTON_PAUSE, MOD_1 );
@@ -396,11 +698,12 @@ data_to_pixels( View *v )
 	    				v->variable->name );
 		result = in_dialog( error_message, NULL, TRUE );
 		if( result == MESSAGE_OK ) {
-			orig_minmax_method = options.min_max_method;
-			options.min_max_method = MIN_MAX_METHOD_EXHAUST;
-			init_min_max( v->variable );
-			options.min_max_method = orig_minmax_method;
-			if( (v->variable->user_max == 0) &&
+			if( ! init_min_max_exhaustive( v->variable )) {
+				if( ! data_has_mv( v->data, x_size*y_size, fill_value ) )
+					return( -1 );
+				v->variable->user_max = 1;
+				}
+			else if( (v->variable->user_max == 0) &&
 	    		    (v->variable->user_min == 0) ) {
 	    			sprintf( error_message, "min and max both 0 for variable %s.\n(Checked all data)", 
 								v->variable->name );
@@ -410,7 +713,7 @@ data_to_pixels( View *v )
 				v->variable->user_max = 1;
 				}
 			else
-				return( data_to_pixels(v) );
+				return( data_to_pixels_region( v, px0, py0, pw, ph ));
 			}
 		else
 			{
@@ -420,7 +723,8 @@ data_to_pixels( View *v )
 			}
 	    	}
 
-	if( v->variable->user_max == v->variable->user_min ) {
+	if( (options.range_mode == RANGE_MODE_GLOBAL) &&
+	    (v->variable->user_max == v->variable->user_min) ) {
 		in_set_cursor_normal();
 	    	sprintf( error_message, "min and max both %g for variable %s",
 	    		v->variable->user_min, v->variable->name );
@@ -438,20 +742,33 @@ data_to_pixels( View *v )
 			v->variable->user_max = 0;
 	    	}
 
-	for( j=0; j<new_y_size; j++ ) {
+	if( options.range_mode == RANGE_MODE_FRAME ) {
+		range_min = v->frame_min;
+		range_max = v->frame_max;
+		}
+	else
+		{
+		range_min = v->variable->user_min;
+		range_max = v->variable->user_max;
+		}
+	data_range = range_max - range_min;
+
+	TIMING_BEGIN( t0 );
+	for( j=py0; j<py0+ph; j++ ) {
 
 		if( options.invert_physical )
 			j2 = j;
 		else
 			j2 = new_y_size - j - 1;
+		j2 -= sy0;
 
-		for( i=0; i<new_x_size; i++ ) {
-			rawdata =  *(scaled_data + i + j2*new_x_size);
+		for( i=px0; i<px0+pw; i++ ) {
+			rawdata =  *(scaled_data + (i-px0) + j2*pw);
 			if( close_enough(rawdata, fill_value) || (rawdata == FILL_FLOAT))
 				pix_val = *pixel_transform;
 			else
 				{
-				data = (rawdata - v->variable->user_min) / data_range;
+				data = (rawdata - range_min) / data_range;
 				clip_f( &data, 0.0, .9999 );
 				switch( options.transform ) {
 					case TRANSFORM_NONE:	break;
@@ -475,10 +792,182 @@ data_to_pixels( View *v )
 			*(v->pixels + i + j*new_x_size) = pix_val;
 			}
 		}
-	free( scaled_data );
+	TIMING_END( TIMING_QUANTIZE, t0 );
+
+	/* If we are doing overlays, draw them on top */
+	if( options.overlay->doit && (options.overlay->points != NULL))
+		overlay_pixels( v->pixels, x_size, y_size, new_x_size, new_y_size, blowup,
+				px0, py0, pw, ph );
+
 	return( 0 );
 }
 
+/******************************************************************************
+ * Views drawn on other threads than the main one, at the same time as
+ * something else is being drawn, must have their own scratch space: set
+ * the view's 'scratch' to one of these, and free it when done.
+ */
+	RenderScratch *
+render_scratch_new( void )
+{
+	RenderScratch *s;
+
+	s = (RenderScratch *)malloc( sizeof(RenderScratch) );
+	if( s == NULL ) {
+		fprintf( stderr, "ncview: render_scratch_new: failed on malloc\n" );
+		exit( -1 );
+		}
+	s->scaled_data      = NULL;
+	s->scaled_data_size = 0L;
+	s->weight           = NULL;
+	s->weight_blowup    = 0;
+	s->row_buf          = NULL;
+	s->mask_buf         = NULL;
+	s->span_w           = 0L;
+	s->sum              = NULL;
+	s->has_fill         = NULL;
+	s->sum_w            = 0L;
+	s->tmpv             = NULL;
+	s->tmpv_n           = 0L;
+	s->count_vals       = NULL;
+	s->unique_vals      = NULL;
+	s->slot_index       = NULL;
+	s->slot_stamp       = NULL;
+	s->stamp            = 0L;
+	s->mode_n           = 0L;
+	s->hash_size        = 0L;
+
+	return( s );
+}
+
+/******************************************************************************/
+	void
+render_scratch_free( RenderScratch *s )
+{
+	if( s->scaled_data != NULL ) {
+		free( s->scaled_data );
+		membudget_release( MEM_RENDER, s->scaled_data_size*sizeof(float) );
+		}
+	if( s->weight != NULL )
+		free( s->weight );
+	if( s->row_buf != NULL ) {
+		free( s->row_buf );
+		free( s->mask_buf );
+		}
+	if( s->sum != NULL ) {
+		free( s->sum );
+		free( s->has_fill );
+		}
+	if( s->tmpv != NULL )
+		free( s->tmpv );
+	if( s->count_vals != NULL ) {
+		free( s->count_vals );
+		free( s->unique_vals );
+		free( s->slot_index );
+		free( s->slot_stamp );
+		}
+	free( s );
+}
+
+/******************************************************************************/
+	static RenderScratch *
+view_scratch( View *v )
+{
+	if( v->scratch != NULL )
+		return( v->scratch );
+	return( &main_scratch );
+}
+
+/******************************************************************************
+ * Returns the whole field of v->data shrunk by the current factor and
+ * method, from the slab cache if it has been made before.  Otherwise it
+ * is made now and put in the cache, so that coming back to this frame,
+ * or to this shrink factor, doesn't mean reducing the full resolution data
+ * again.  Returns NULL if the cache can't hold it, in which case the caller
+ * should just reduce the part it needs, as it also must for coarse or
+ * edited data.
+ */
+	static float *
+reduced_field( View *v, float fill_value, size_t new_x_size, size_t new_y_size )
+{
+	float	*reduced;
+
+	/* Only data as read from the file can be shared through the cache */
+	if( v->data_status != VDS_VALID )
+		return( NULL );
+
+	reduced = slabcache_get_reduced( v->variable, v->var_place, v->x_axis_id, v->y_axis_id,
+			-options.blowup, options.shrink_method );
+	if( reduced != NULL )
+		return( reduced );
+
+	reduced = slabcache_alloc_reduced( v->variable, v->var_place, v->x_axis_id, v->y_axis_id,
+			-options.blowup, options.shrink_method, new_x_size*new_y_size );
+	if( reduced == NULL )
+		return( NULL );
+
+	contract_data( reduced, v, fill_value, 0L, 0L, new_x_size, new_y_size );
+	return( reduced );
+}
+
+/******************************************************************************
+ * Paint the overlay points onto the finished pixel array in the fill color.
+ * When magnifying, each overlay point covers its whole blowup x blowup block;
+ * when shrinking, it covers the one output pixel whose square contains it.
+ * The data itself is not touched, so the points around the overlay are
+ * scaled from the real values.  This gives the same picture as setting the
+ * data to the fill value did, except with bilinear magnification: that 
+ * spread the fill into the neighboring interpolated pixels, which are now
+ * interpolated from the real data.  (When shrinking, a block holding a fill
+ * value already came out as fill, the same as painting its pixel now.)
+ * Only pixels in the pw x ph rectangle at (px0,py0) are painted.
+ */
+	static void
+overlay_pixels( ncv_pixel *pixels, size_t x_size, size_t y_size, size_t new_x_size, 
+		size_t new_y_size, long blowup, size_t px0, size_t py0, size_t pw, size_t ph )
+{
+	size_t	k, idx, i, j, row, out_row, ox0, ox1;
+	long	line;
+	ncv_pixel fill_pix;
+
+	fill_pix = *pixel_transform;
+
+	for( k=0; k<options.overlay->n_points; k++ ) {
+		idx = *(options.overlay->points + k);
+		if( idx >= x_size*y_size )
+			break;	/* points are sorted, so all the rest are off the end too */
+		i = idx % x_size;
+		j = idx / x_size;
+
+		if( blowup > 0 ) {
+			ox0 = i*blowup;
+			ox1 = ox0 + blowup;
+			if( ox0 < px0 )
+				ox0 = px0;
+			if( ox1 > px0+pw )
+				ox1 = px0+pw;
+			if( ox0 >= ox1 )
+				continue;
+			for( line=0; line<blowup; line++ ) {
+				row = j*blowup + line;
+				out_row = options.invert_physical ? row : new_y_size - row - 1;
+				if( (out_row < py0) || (out_row >= py0+ph) )
+					continue;
+				memset( pixels + ox0 + out_row*new_x_size, fill_pix, ox1-ox0 );
+				}
+			}
+		else
+			{
+			row = j/(-blowup);
+			out_row = options.invert_physical ? row : new_y_size - row - 1;
+			ox0 = i/(-blowup);
+			if( (ox0 < px0) || (ox0 >= px0+pw) || (out_row < py0) || (out_row >= py0+ph) )
+				continue;
+			*(pixels + ox0 + out_row*new_x_size) = fill_pix;
+			}
+		}
+}
+
 /******************************************************************************
  * Returns the number of entries in the NCVarlist
  */
@@ -551,6 +1040,7 @@ add_var_to_list( char *var_name, int file_id, char *filename, int nfiles )
 	NCVar	*var, *new_var;
 	int	n_dims, err;
 	FDBlist	*new_fdb, *fdb;
+	double	t0;
 
 	/* make a new file description entry for this var/file combo */
 	new_fdblist( &new_fdb );
@@ -566,7 +1056,9 @@ add_var_to_list( char *var_name, int file_id, char *filename, int nfiles )
 	/* fill out auxilliary (data-file format dependent) information
 	 * for the new fdb.
 	 */
+	TIMING_BEGIN( t0 );
 	fi_fill_aux_data( file_id, var_name, new_fdb );
+	TIMING_END( TIMING_AUX_FILL, t0 );
 #ifdef INC_UDUNITS
 	err = utScan( new_fdb->recdim_units, new_fdb->udunits );
 	if( err != 0 )
@@ -595,6 +1087,8 @@ add_var_to_list( char *var_name, int file_id, char *filename, int nfiles )
 		new_var->fill_value = DEFAULT_FILL_VALUE;
 		fi_fill_value( new_var, &(new_var->fill_value) );
 		new_fdb->prev       = NULL;
+		new_var->n_files    = 1;
+		new_var->file_signature = (unsigned long)file_id;
 		fill_dim_structs( new_var );
 		add_to_varlist  ( &variables, new_var );
 		new_var->is_virtual = FALSE;
@@ -612,14 +1106,14 @@ add_var_to_list( char *var_name, int file_id, char *filename, int nfiles )
 			fprintf( stderr, "inconsistancy; var has no last_file\n" );
 			exit( -1 );
 			}
-		fdb = var->first_file;
-		while( fdb->next != NULL )
-			fdb = fdb->next;
+		fdb = var->last_file;
 		fdb->next         = new_fdb;
 		new_fdb->prev     = fdb;
 		var->last_file    = new_fdb;
 		*(var->size)      += *(new_fdb->var_size);
 		var->is_virtual   = TRUE;
+		var->n_files++;
+		var->file_signature = var->file_signature*1000003L + (unsigned long)file_id;
 		}
 }
 
@@ -741,17 +1235,214 @@ init_min_max( NCVar *var )
 	free( data );
 }
 
+/******************************************************************************
+ * Like init_min_max, but only the first, middle, and last time entries are
+ * read now, so the variable can be shown right away.  If the -minmax method
+ * wants more than that, the rest are read on the worker thread, and when
+ * they are done the range is widened to cover them (unless the user has set
+ * the range in the meantime).
+ */
+	void
+init_min_max_background( NCVar *var )
+{
+	int	method;
+
+	method = options.min_max_method;
+	options.min_max_method = MIN_MAX_METHOD_FAST;
+	init_min_max( var );
+	options.min_max_method = method;
+
+	if( (method != MIN_MAX_METHOD_FAST) && (*(var->size) > 3) )
+		min_max_scan_start( var, FALSE, FALSE );
+}
+
+/******************************************************************************
+ * Find the range from every time entry, waiting for it, but with the window
+ * showing progress and a Cancel button.  Returns FALSE if it was cancelled,
+ * or there wasn't the memory to do it, in which case the range is left as
+ * it was.
+ */
+	int
+init_min_max_exhaustive( NCVar *var )
+{
+	worker_cancel_all();
+	return( min_max_scan_start( var, TRUE, TRUE ) );
+}
+
+/******************************************************************************/
+	static int
+min_max_scan_start( NCVar *var, int whole, int modal )
+{
+	MinMaxScan	*scan;
+	WorkerTask	*task;
+	long		i;
+
+	scan = (MinMaxScan *)malloc( sizeof( MinMaxScan ));
+	if( scan == NULL ) {
+		fprintf( stderr, "ncview: min_max_scan_start: failed on malloc\n" );
+		exit( -1 );
+		}
+	scan->var         = var;
+	scan->n_timesteps = *(var->size);
+	scan->n_other     = 1L;
+	for( i=1; i<var->n_dims; i++ )
+		scan->n_other *= *(var->size+i);
+	scan->method      = options.min_max_method;
+	scan->whole       = whole;
+	scan->min         =  9.9e30;
+	scan->max         = -9.9e30;
+	scan->user_min    = var->user_min;
+	scan->user_max    = var->user_max;
+
+	/* Allocated here rather than on the worker thread, since making
+	 * room for it can mean evicting from the caches, which belong to
+	 * the main thread.
+	 */
+	scan->data = (float *)membudget_malloc( MEM_RENDER, scan->n_other*sizeof(float) );
+	if( scan->data == NULL ) {
+		in_error( "Not enough memory to find the range of this variable" );
+		free( scan );
+		return( FALSE );
+		}
+
+	task = worker_new_task( "Finding the range", min_max_scan_work, min_max_scan_done, scan );
+	if( modal )
+		return( worker_run_modal( task ));
+	worker_run( task );
+	return( TRUE );
+}
+
+/******************************************************************************
+ * Runs on the worker thread.
+ */
+	static void
+min_max_scan_work( WorkerTask *task )
+{
+	MinMaxScan	*scan;
+	long		k, n_steps;
+
+	scan = (MinMaxScan *)task->data;
+
+	n_steps = min_max_scan_n_steps( scan );
+	for( k=0; k<n_steps; k++ ) {
+		if( worker_cancelled( task ))
+			break;
+		get_min_max_onestep( scan->var, scan->n_other, min_max_scan_step( scan, k ), scan->data, 
+				&(scan->min), &(scan->max), FALSE );
+		worker_progress( task, (float)(k+1)/(float)n_steps );
+		}
+}
+
+/******************************************************************************
+ * Back on the main thread with what the scan found.
+ */
+	static void
+min_max_scan_done( WorkerTask *task, int use_result )
+{
+	MinMaxScan	*scan;
+	NCVar		*var;
+	int		user_unchanged;
+
+	scan = (MinMaxScan *)task->data;
+	var  = scan->var;
+
+	if( use_result && scan->whole ) {
+		if( scan->min > scan->max ) {	/* nothing but fill values */
+			var->global_min = 0.0;
+			var->global_max = 0.0;
+			}
+		else
+			{
+			var->global_min = scan->min;
+			var->global_max = scan->max;
+			}
+		check_ranges( var );
+		}
+
+	else if( use_result && (scan->min <= scan->max) && 
+			((scan->min < var->global_min) || (scan->max > var->global_max)) ) {
+		if( options.debug )
+			fprintf( stderr, "range of %s widened to %g %g by the full scan\n", var->name,
+				(scan->min < var->global_min) ? scan->min : var->global_min,
+				(scan->max > var->global_max) ? scan->max : var->global_max );
+		user_unchanged = (var->user_min == scan->user_min) && (var->user_max == scan->user_max);
+		if( scan->min < var->global_min )
+			var->global_min = scan->min;
+		if( scan->max > var->global_max )
+			var->global_max = scan->max;
+		if( user_unchanged ) {
+			check_ranges( var );
+			view_range_changed( var );
+			}
+		}
+
+	/* Cut short, so start over the next time the variable is picked */
+	else if( (! use_result) && (! scan->whole) &&
+			(var->user_min == scan->user_min) && (var->user_max == scan->user_max) )
+		var->have_set_range = FALSE;
+
+	membudget_free( MEM_RENDER, scan->data, scan->n_other*sizeof(float) );
+	free( scan );
+}
+
+/******************************************************************************
+ * How many time entries the scan reads.  Other than for the whole thing,
+ * these are the ones the -minmax method reads beyond the first, middle, and
+ * last, which init_min_max_background has already done.
+ */
+	static long
+min_max_scan_n_steps( MinMaxScan *scan )
+{
+	if( scan->whole )
+		return( (long)scan->n_timesteps );
+
+	switch( scan->method ) {
+		case MIN_MAX_METHOD_MED:     return( 2L );
+		case MIN_MAX_METHOD_SLOW:    return( 8L );
+		case MIN_MAX_METHOD_EXHAUST: return( (long)scan->n_timesteps - 3L );
+		}
+	return( 0L );
+}
+
+/******************************************************************************
+ * The k'th time entry for the scan to read; the same ones init_min_max reads.
+ */
+	static size_t
+min_max_scan_step( MinMaxScan *scan, long k )
+{
+	long	n1;
+
+	n1 = (long)scan->n_timesteps - 1L;
+	if( scan->whole )
+		return( (size_t)k );
+
+	switch( scan->method ) {
+		case MIN_MAX_METHOD_MED:     return( (size_t)(((1L+2L*k)*n1)/4L) );
+		case MIN_MAX_METHOD_SLOW:    return( (size_t)(((k+2L)*n1)/10L) );
+		}
+	return( (size_t)(k+1L) );
+}
+
 /******************************************************************************
  * Try to reconcile the computed and specified (if any) data range
  */
 	void
 check_ranges( NCVar *var )
 {
-	float	min, max;
-	int	message;
+	float	min, max, valid_min, valid_max;
+	int	message, have_range, have_min, have_max;
 	char	temp_string[ 1024 ];
 
-	if( netcdf_min_max_option_set( var, &min, &max ) ) {
+	/* Get the attributes first, so the file isn't held while the
+	 * dialogs are up
+	 */
+	fi_lock();
+	have_range = netcdf_min_max_option_set( var, &min, &max );
+	have_min   = netcdf_min_option_set( var, &valid_min );
+	have_max   = netcdf_max_option_set( var, &valid_max );
+	fi_unlock();
+
+	if( have_range ) {
 		if( var->global_min < min ) {
 			sprintf( temp_string, "Calculated minimum (%g) is less than\nvalid_range minimum (%g).  Reset\nminimum to valid_range minimum?", var->global_min, min );
 			message = in_dialog( temp_string, NULL, TRUE );
@@ -766,7 +1457,8 @@ check_ranges( NCVar *var )
 			}
 		}
 
-	if( netcdf_min_option_set( var, &min ) ) {
+	if( have_min ) {
+		min = valid_min;
 		if( var->global_min < min ) {
 			sprintf( temp_string, "Calculated minimum (%g) is less than\nvalid_min minimum (%g).  Reset\nminimum to valid_min value?", var->global_min, min );
 			message = in_dialog( temp_string, NULL, TRUE );
@@ -775,7 +1467,8 @@ check_ranges( NCVar *var )
 			}
 		}
 
-	if( netcdf_max_option_set( var, &max ) ) {
+	if( have_max ) {
+		max = valid_max;
 		if( var->global_max > max ) {
 			sprintf( temp_string, "Calculated maximum (%g) is greater than\nvalid_max maximum (%g).  Reset\nmaximum to valid_max value?", var->global_max, max );
 			message = in_dialog( temp_string, NULL, TRUE );
@@ -797,13 +1490,10 @@ check_ranges( NCVar *var )
 get_min_max_onestep( NCVar *var, size_t n_other, size_t tstep, float *data, 
 					float *min, float *max, int verbose )
 {
-	size_t	*start, *count, n_time;
-	size_t	j;
+	size_t	start[MAX_VAR_DIMS], count[MAX_VAR_DIMS], n_time;
 	int	i;
-	float	dat, fill_v;
+	float	fill_v;
 	
-	count  = (size_t *)malloc( var->n_dims * sizeof( size_t ));
-	start  = (size_t *)malloc( var->n_dims * sizeof( size_t ));
 	fill_v = var->fill_value;
 
 	n_time = *(var->size);
@@ -824,21 +1514,7 @@ get_min_max_onestep( NCVar *var, size_t n_other, size_t tstep, float *data,
 
 	fi_get_data( var, start, count, data );
 
-	for( j=0; j<n_other; j++ ) {
-		dat = *(data+j);
-		if( dat != dat )
-			dat = fill_v;
-		if( (! close_enough(dat, fill_v)) && (dat != FILL_FLOAT) )
-			{
-			if( dat > *max )
-				*max = dat;
-			if( dat < *min )
-				*min = dat;
-			}
-		}
-		
-	free( count );
-	free( start );
+	data_valid_range( data, n_other, fill_v, min, max );
 }
 
 /******************************************************************************
@@ -849,16 +1525,29 @@ get_var( char *var_name )
 {
 	NCVar	*ret_val;
 
-	ret_val = variables;
+	ret_val = var_bucket[ name_hash( var_name ) % NAME_HASH_N_BUCKETS ];
 	while( ret_val != NULL )
 		if( strcmp( var_name, ret_val->name ) == 0 )
 			return( ret_val );
 		else
-			ret_val = ret_val->next;
+			ret_val = ret_val->hash_next;
 
 	return( NULL );
 }
 
+/******************************************************************************/
+	static unsigned long
+name_hash( char *s )
+{
+	unsigned long	h;
+
+	h = 5381L;
+	while( *s != '\0' )
+		h = h*33L + (unsigned char)(*s++);
+
+	return( h );
+}
+
 /******************************************************************************
  * Clip out of range floats 
  */
@@ -925,9 +1614,8 @@ fill_dim_structs( NCVar *v )
 {
 	int	i, fileid;
 	NCDim	*d;
-	char	*dim_name, *tmp_units;
+	char	*dim_name;
 	static  int global_id = 0;
-	FDBlist	*cursor;
 
 	fileid = v->first_file->id;
 	v->dim = (NCDim **)malloc( v->n_dims*sizeof( NCDim *));
@@ -937,14 +1625,18 @@ fill_dim_structs( NCVar *v )
 			*(v->dim + i)	= (NCDim *)malloc( sizeof( NCDim ));
 			d            	= *(v->dim+i);
 			d->name      	= dim_name;
-			d->long_name 	= fi_dim_longname( fileid, dim_name );
-			d->have_calc_minmax = 0;
-			d->units     	= fi_dim_units   ( fileid, dim_name );
+			d->have_info	= 0;	/* the rest is filled in by load_var_dims() */
+			d->long_name 	= NULL;
+			d->units     	= NULL;
 			d->units_change = 0;
+			d->calendar  	= NULL;
+			d->timelike	= 0;
+			d->have_calc_minmax = 0;
 			d->size      	= *(v->size+i);
-			d->calendar  	= fi_dim_calendar( fileid, dim_name );
 			d->global_id 	= ++global_id;
-			handle_time_dim( fileid, v, i );
+			d->n_dates	= 0L;
+			d->date_values	= NULL;
+			d->dates	= NULL;
 			if( options.debug ) 
 				fprintf( stderr, "adding scannable dim to var %s: dimname: %s dimsize: %ld\n", v->name, dim_name, d->size );
 			}
@@ -956,26 +1648,6 @@ fill_dim_structs( NCVar *v )
 				fprintf( stderr, "adding non-scannable dim to var %s\n", v->name );
 			}
 		}
-
-	/* If this variable lives in more than one file, it might have 
-	 * different time units in each one.  Check for this.
-	 */
-	if( v->is_virtual && (*(v->dim) != NULL) && (v->first_file->next != NULL) ) {
-		/* The timelike dimension MUST be the first one! */
-		if( d->timelike ) {
-			/* Go through each file and see if it has the same units
-			 * as the first file, which is stored in d->units 
-			 */
-			cursor = v->first_file->next;
-			while( cursor != NULL ) {
-				tmp_units = fi_dim_units( cursor->id, d->name );
-				if( strcmp( d->units, tmp_units ) != 0 ) {
-					printf( "** Warning: different time units found in different files.  Trying to compensate...\n" );
-					d->units_change = 1;
-					}
-				}
-			}
-		}
 }
 
 /******************************************************************************
@@ -997,43 +1669,68 @@ is_scannable( NCVar *v, int i )
 
 /******************************************************************************
  * Return the mode (most common value) of passed array "x".  We assume "x"
- * contains the floating point representation of integers.
+ * contains the floating point representation of integers.  Values already
+ * seen are found through a small open-addressing hash table; its slots are
+ * tagged with a per-call stamp so the table never has to be cleared, and
+ * all scratch space is kept in 's' between calls, so in the steady state 
+ * this does no allocation.  Ties go to whichever value was seen first.
  */
 	float
-util_mode( float *x, size_t n, float fill_value )
+util_mode( float *x, size_t n, float fill_value, RenderScratch *s )
 {
+	long	*count_vals, *unique_vals, *slot_stamp, *slot_index, stamp;
 	long 	i, n_vals;
-	double 	sum;
-	long 	ival, *count_vals, max_count, *unique_vals;
-	int	foundval, j, max_index;
+	long 	ival, max_count;
+	long	max_index;
+	unsigned long h, hash_mask;
 	float	retval;
 
-	count_vals  = (long *)malloc( n*sizeof(long) );
-	unique_vals = (long *)malloc( n*sizeof(long) );
+	if( n > s->mode_n ) {
+		if( s->count_vals != NULL ) {
+			free( s->count_vals );
+			free( s->unique_vals );
+			free( s->slot_index );
+			free( s->slot_stamp );
+			}
+		s->hash_size = 16L;
+		while( s->hash_size < 2*n )
+			s->hash_size *= 2L;
+		s->count_vals  = (long *)malloc( n*sizeof(long) );
+		s->unique_vals = (long *)malloc( n*sizeof(long) );
+		s->slot_index  = (long *)malloc( s->hash_size*sizeof(long) );
+		s->slot_stamp  = (long *)calloc( s->hash_size, sizeof(long) );
+		if( (s->count_vals == NULL) || (s->unique_vals == NULL) || 
+		    (s->slot_index == NULL) || (s->slot_stamp == NULL) ) {
+			fprintf( stderr, "ncview: util_mode: failed to allocate scratch space\n" );
+			exit( -1 );
+			}
+		s->mode_n = n;
+		s->stamp  = 0L;
+		}
+	count_vals  = s->count_vals;
+	unique_vals = s->unique_vals;
+	slot_index  = s->slot_index;
+	slot_stamp  = s->slot_stamp;
+	hash_mask   = s->hash_size - 1L;
+	stamp       = ++s->stamp;
 
-	sum = 0.0;
 	n_vals = 0;
 	for( i=0L; i<n; i++ ) {
-		if( close_enough( x[i], fill_value )) {
-			free(count_vals);
-			free(unique_vals);
+		if( close_enough( x[i], fill_value ))
 			return( fill_value );
-			}
 		ival = (x[i] > 0.) ? (long)(x[i]+.4) : (long)(x[i]-.4); /* round x[i] to nearest integer */
-		foundval = -1;
-		for( j=0; j<n_vals; j++ ) {
-			if( unique_vals[j] == ival ) {
-				foundval = j;
-				break;
-				}
-			}
-		if( foundval == -1 ) {
+		h = ((unsigned long)ival * 2654435761UL) & hash_mask;
+		while( (slot_stamp[h] == stamp) && (unique_vals[slot_index[h]] != ival) )
+			h = (h+1L) & hash_mask;
+		if( slot_stamp[h] != stamp ) {
+			slot_stamp[h] = stamp;
+			slot_index[h] = n_vals;
 			unique_vals[n_vals] = ival;
 			count_vals[n_vals] = 1;
 			n_vals++;
 			}
 		else
-			count_vals[foundval]++;
+			count_vals[slot_index[h]]++;
 		}
 
 	max_count = -1;
@@ -1046,36 +1743,18 @@ util_mode( float *x, size_t n, float fill_value )
 
 	retval = (float)unique_vals[max_index];
 
-	free(count_vals);
-	free(unique_vals);
-
 	return( retval );
 }
 
-/******************************************************************************/
-	float
-util_mean( float *x, size_t n, float fill_value )
-{
-	long i;
-	double sum;
-
-	sum = 0.0;
-	for( i=0L; i<n; i++ ) {
-		if( close_enough( x[i], fill_value ))
-			return( fill_value );
-		sum += x[i];
-		}
-
-	sum = sum / (double)n;
-	return( sum );
-}
-
 /******************************************************************************/
 	int
 equivalent_FDBs( NCVar *v1, NCVar *v2 )
 {
 	FDBlist *f1, *f2;
 
+	if( (v1->n_files != v2->n_files) || (v1->file_signature != v2->file_signature) )
+		return(0);
+
 	f1 = v1->first_file;
 	f2 = v2->first_file;
 	while( f1 != NULL ) {
@@ -1097,107 +1776,202 @@ equivalent_FDBs( NCVar *v1, NCVar *v2 )
 	return(1);
 }
 
+/******************************************************************************
+ * Return a dim that has already had its values read and is the same as the
+ * passed dim of var 'v' -- same name, and its var lives in the same files.
+ * Returns NULL if there isn't one yet, in which case the passed dim is 
+ * remembered as the one to use for the next var that has it.
+ */
+	static NCDim *
+find_identical_dim( NCVar *v, NCDim *d )
+{
+	DimReg	*r;
+	unsigned long h;
+
+	h = name_hash( d->name )*31L + v->file_signature;
+	for( r=dim_bucket[h % NAME_HASH_N_BUCKETS]; r != NULL; r=r->next )
+		if( (r->hash == h) && (strcmp( r->dim->name, d->name ) == 0) &&
+				equivalent_FDBs( r->var, v ))
+			return( r->dim );
+
+	r = (DimReg *)malloc( sizeof(DimReg) );
+	if( r == NULL ) {
+		fprintf( stderr, "ncview: find_identical_dim: malloc failed\n" );
+		exit( -1 );
+		}
+	r->var  = v;
+	r->dim  = d;
+	r->hash = h;
+	r->next = dim_bucket[h % NAME_HASH_N_BUCKETS];
+	dim_bucket[h % NAME_HASH_N_BUCKETS] = r;
+
+	return( NULL );
+}
+
 /******************************************************************************/
-	void
-copy_info_to_identical_dims( NCVar *vsrc, NCDim *dsrc, size_t dim_len )
+	static void
+copy_dim_info( NCDim *dsrc, NCDim *d, size_t dim_len )
 {
-	NCVar	*v;
-	int	i, dims_are_same;
-	NCDim	*d;
 	size_t	j;
 
-	v = variables;
-	while( v != NULL ) {
-		for( i=0; i<v->n_dims; i++ ) {
-			d = *(v->dim+i);
-			if( (d != NULL) && (d->have_calc_minmax == 0)) {
-				/* See if this dim is same as passed dim */
-				dims_are_same = (strcmp( dsrc->name, d->name ) == 0 ) &&
-						equivalent_FDBs( vsrc, v );
-				if( dims_are_same ) {
-					if( options.debug ) 
-						fprintf( stderr, "Dim %s (%d) is same as dim %s (%d), copying min&max from former to latter...\n", dsrc->name, dsrc->global_id, d->name, d->global_id );
-					d->min = dsrc->min;
-					d->max = dsrc->max;
-					d->have_calc_minmax = 1;
-					d->values = (float *)malloc(dim_len*sizeof(float));
-					for( j=0L; j<dim_len; j++ )
-						*(d->values + j) = *(dsrc->values + j);
-					d->is_lat = dsrc->is_lat;
-					d->is_lon = dsrc->is_lon;
-					}
-				}
-			}
-		v = v->next;
+	if( options.debug ) 
+		fprintf( stderr, "Dim %s (%d) is same as dim %s (%d), copying min&max from former to latter...\n", dsrc->name, dsrc->global_id, d->name, d->global_id );
+	d->min = dsrc->min;
+	d->max = dsrc->max;
+	d->have_calc_minmax = 1;
+	d->values = (float *)malloc(dim_len*sizeof(float));
+	membudget_charge( MEM_DIMS, dim_len*sizeof(float) );
+	for( j=0L; j<dim_len; j++ )
+		*(d->values + j) = *(dsrc->values + j);
+	d->is_lat = dsrc->is_lat;
+	d->is_lon = dsrc->is_lon;
+	if( (dsrc->dates != NULL) && (strcmp( dsrc->units, d->units ) == 0) ) {
+		d->n_dates     = dsrc->n_dates;
+		d->date_values = dsrc->date_values;
+		d->dates       = dsrc->dates;
 		}
 }
 
 /******************************************************************************
- * Calculate the minimum and maximum values in the dimension structs.  While
- * we are messing with the dims, we also try to determine if they are lat and
- * lon.
+ * Read in what we need to know about the passed variable's dims: their units,
+ * calendar, and so on, and their values.  From the values we calculate the 
+ * minimum and maximum, and try to determine if they are lat and lon.  None
+ * of this is done when the files are opened, because with a lot of variables
+ * it takes a long time and most of them are never looked at.  Instead, it is
+ * done the first time a variable is selected; calling it again does nothing.
  */
 	void
-calc_dim_minmaxes( void )
+load_var_dims( NCVar *v )
 {
 	int	i, j;
-	NCVar	*v;
-	NCDim	*d;
+	NCDim	*d, *dsrc;
 	char	temp_str[1024];
 	nc_type	type;
-	double	temp_double, bounds_max, bounds_min;
-	int	has_bounds, name_lat, name_lon, units_lat, units_lon;
+	double	temp_double, bounds_max, bounds_min, *time_values;
+	int	has_bounds, name_lat, name_lon, units_lat, units_lon, did_work;
 	size_t	dim_len;
+	double	t0;
 
-	v = variables;
-	while( v != NULL ) {
-		for( i=0; i<v->n_dims; i++ ) {
-			d = *(v->dim+i);
-			if( (d != NULL) && (d->have_calc_minmax == 0)) {
-				if( options.debug ) 
-					fprintf( stderr, "...min & maxes for dim %s (%d)...\n", d->name, d->global_id );
-				dim_len = *(v->size+i);
-				d->values = (float *)malloc(dim_len*sizeof(float));
-				type = fi_dim_value( v, i, 0L, &temp_double, temp_str, &has_bounds, &bounds_min, &bounds_max );
-				if( type == NC_DOUBLE ) {
-					for( j=0; j<dim_len; j++ ) {
-						type = fi_dim_value( v, i, j, &temp_double, temp_str, &has_bounds, &bounds_min, &bounds_max );
-						*(d->values+j) = (float)temp_double;
+	did_work = FALSE;
+	TIMING_BEGIN( t0 );
+
+	for( i=0; i<v->n_dims; i++ ) {
+		d = *(v->dim+i);
+		if( (d != NULL) && (d->have_info == 0) ) {
+			load_dim_info( v, i );
+			did_work = TRUE;
+			}
+		if( (d != NULL) && (d->have_calc_minmax == 0)) {
+			did_work = TRUE;
+			dim_len = *(v->size+i);
+
+			/* There is a funny thing we need to do at this point.  Think about the following case.
+			 * We want to look at 3 different files, and they all have a dim named 'lon' in them,
+			 * and each is different.  Because this might happen, we can't use the name as an
+			 * indication of a unique dimension.  On the other hand, it is very slow to repeatedly
+			 * reprocess the same dim over and over, especially if it's the time dim in a series
+			 * of virtually concatenated input files.  For that reason, if we have already found
+			 * the values for an identical dim, we just copy them.
+			 */
+			if( (dsrc = find_identical_dim( v, d )) != NULL ) {
+				copy_dim_info( dsrc, d, dim_len );
+				continue;
+				}
+
+			if( options.debug ) 
+				fprintf( stderr, "...min & maxes for dim %s (%d)...\n", d->name, d->global_id );
+			d->values = (float *)malloc(dim_len*sizeof(float));
+			membudget_charge( MEM_DIMS, dim_len*sizeof(float) );
+			type = fi_dim_value( v, i, 0L, &temp_double, temp_str, &has_bounds, &bounds_min, &bounds_max );
+			if( type == NC_DOUBLE ) {
+				/* Keep the full precision time values so they can all
+				 * be turned into dates in one go; see udu_cache_dates()
+				 */
+				time_values = NULL;
+				if( d->timelike && (d->time_std == TSTD_UDUNITS) ) {
+					time_values = (double *)malloc( dim_len*sizeof(double) );
+					if( time_values == NULL ) {
+						fprintf( stderr, "ncview: load_var_dims: failed on malloc of %ld time values\n", (long)dim_len );
+						exit( -1 );
 						}
-					d->min  = *(d->values);
-					d->max  = *(d->values + dim_len - 1);
 					}
-				else
-					{
-					if( options.debug ) 
-						fprintf( stderr, "**Note: non-float dim found; i=%d\n", i );
-					d->min  = 1.0;
-					d->max  = (float)dim_len;
-					for( j=0; j<dim_len; j++ )
-						*(d->values+j) = (float)j;
+				for( j=0; j<dim_len; j++ ) {
+					type = fi_dim_value( v, i, j, &temp_double, temp_str, &has_bounds, &bounds_min, &bounds_max );
+					*(d->values+j) = (float)temp_double;
+					if( time_values != NULL )
+						*(time_values+j) = temp_double;
 					}
-				d->have_calc_minmax = 1;
-				
-				/* Try to see if the dim is a lat or lon.  Not an exact science by a long shot */
-				name_lat  = strncmp_nocase(d->name,  "lat",    3)==0;
-				units_lat = strncmp_nocase(d->units, "degree", 6) == 0;
-				name_lon  = strncmp_nocase(d->name,  "lon",    3)==0;
-				units_lon = strncmp_nocase(d->units, "degree", 6) == 0;
-				d->is_lat = ((name_lat || units_lat) && (d->max <  90.01) && (d->min > -90.01));
-				d->is_lon = ((name_lon || units_lon) && (d->max < 360.01) && (d->min > -180.01));
-
-				/* There is a funny thing we need to do at this point.  Think about the following case.
-				 * We want to look at 3 different files, and they all have a dim named 'lon' in them,
-				 * and each is different.  Because this might happen, we can't use the name as an
-				 * indication of a unique dimension.  On the other hand, it is very slow to repeatedly
-				 * reprocess the same dim over and over, especially if it's the time dim in a series
-				 * of virtually concatenated input files.  For that reason, we copy the min and max
-				 * values we just found to all identical dims.
-				 */
-				copy_info_to_identical_dims( v, d, dim_len );
+				d->min  = *(d->values);
+				d->max  = *(d->values + dim_len - 1);
+				if( (time_values != NULL) && (! udu_cache_dates( d, time_values, dim_len )) )
+					free( time_values );
+				}
+			else
+				{
+				if( options.debug ) 
+					fprintf( stderr, "**Note: non-float dim found; i=%d\n", i );
+				d->min  = 1.0;
+				d->max  = (float)dim_len;
+				for( j=0; j<dim_len; j++ )
+					*(d->values+j) = (float)j;
+				}
+			d->have_calc_minmax = 1;
+			
+			/* Try to see if the dim is a lat or lon.  Not an exact science by a long shot */
+			name_lat  = strncmp_nocase(d->name,  "lat",    3)==0;
+			units_lat = strncmp_nocase(d->units, "degree", 6) == 0;
+			name_lon  = strncmp_nocase(d->name,  "lon",    3)==0;
+			units_lon = strncmp_nocase(d->units, "degree", 6) == 0;
+			d->is_lat = ((name_lat || units_lat) && (d->max <  90.01) && (d->min > -90.01));
+			d->is_lon = ((name_lon || units_lon) && (d->max < 360.01) && (d->min > -180.01));
+			}
+		}
+
+	/* Only the calls that actually read something are worth reporting */
+	if( did_work )
+		TIMING_END( TIMING_DIM_LOAD, t0 );
+}
+
+/******************************************************************************
+ * Read the attributes of dim number 'i' of the passed variable, and work out
+ * whether it is timelike.
+ */
+	static void
+load_dim_info( NCVar *v, int i )
+{
+	int	fileid;
+	NCDim	*d;
+	char	*tmp_units;
+	FDBlist	*cursor;
+
+	fileid = v->first_file->id;
+	d      = *(v->dim+i);
+
+	d->long_name 	= fi_dim_longname( fileid, d->name );
+	d->units     	= fi_dim_units   ( fileid, d->name );
+	d->units_change = 0;
+	d->calendar  	= fi_dim_calendar( fileid, d->name );
+	handle_time_dim( fileid, v, i );
+	d->have_info	= 1;
+
+	/* If this variable lives in more than one file, it might have 
+	 * different time units in each one.  Check for this.
+	 * The timelike dimension MUST be the first one!
+	 */
+	if( (i == 0) && v->is_virtual && d->timelike ) {
+		/* Go through each file and see if it has the same units
+		 * as the first file, which is stored in d->units 
+		 */
+		cursor = v->first_file->next;
+		while( cursor != NULL ) {
+			tmp_units = fi_dim_units( cursor->id, d->name );
+			if( (d->units != NULL) && (tmp_units != NULL) && (strcmp( d->units, tmp_units ) != 0) ) {
+				printf( "** Warning: different time units found in different files.  Trying to compensate...\n" );
+				d->units_change = 1;
+				break;
 				}
+			cursor = cursor->next;
 			}
-		v = v->next;
 		}
 }
 	
@@ -1207,13 +1981,15 @@ calc_dim_minmaxes( void )
  * or by averaging over the square.  Remember that our standard for how to 
  * interpret 'options.blowup' is that a value of "-N" means to shrink by a factor
  * of N.  So, blowup == -2 means make it half size, -3 means 1/3 size, etc.
+ * Squares that run off the right or bottom edge reuse the last column or row.
+ * Only the w x h rectangle of the small field starting at (x0,y0) is 
+ * computed; it is written to 'small_data' with a row length of 'w'.
  */
 	void
-contract_data( float *small_data, View *v, float fill_value )
+contract_data( float *small_data, View *v, float fill_value, size_t x0, size_t y0, 
+		size_t w, size_t h )
 {
-	long 	i, j, n, nx, ny, ii, jj;
-	size_t	new_nx, new_ny, idx, ioffset, joffset;
-	float 	*tmpv;
+	long 	n, nx, ny;
 
 	if( options.blowup > 0 ) {
 		fprintf( stderr, "internal error, contract_data called with a positive blowup factor!\n" );
@@ -1221,64 +1997,154 @@ contract_data( float *small_data, View *v, float fill_value )
 		}
 
 	n = -options.blowup;
-	tmpv = (float *)malloc( n*n * sizeof(float) );
-	if( tmpv == NULL ) {
-		fprintf( stderr, "internal error, failed to allocate array for calculating reduced means\n" );
-		exit( -1 );
-		}
 
-	/* Get old and new sizes (new size is smaller in this routine) */
 	nx   = *(v->variable->size + v->x_axis_id);
 	ny   = *(v->variable->size + v->y_axis_id);
-	view_get_scaled_size( options.blowup, nx, ny, &new_nx, &new_ny );
-
-	for( j=0; j<new_ny; j++ )
-	for( i=0; i<new_nx; i++ ) {
-		for( jj=0; jj<n; jj++ )
-		for( ii=0; ii<n; ii++ ) {
-			ioffset = i*n + ii;
-			joffset = j*n + jj;
-			if( ioffset >= nx )
-				ioffset = nx-1;
+
+	if( options.shrink_method == SHRINK_METHOD_MEAN )
+		contract_data_mean( small_data, (float *)v->data, nx, ny, n, x0, y0, w, h, fill_value,
+				view_scratch( v ));
+
+	else if( options.shrink_method == SHRINK_METHOD_MODE )
+		contract_data_mode( small_data, (float *)v->data, nx, ny, n, x0, y0, w, h, fill_value,
+				view_scratch( v ));
+
+	else
+		{
+		fprintf( stderr, "Error in contract_data: unknown value of options.shrink_method!\n" );
+		exit( -1 );
+		}
+}
+
+/********************************************************************************
+ * Block means.  Rather than gathering each n x n square and summing it, we
+ * sweep the input a row at a time, adding each row's contribution into a 
+ * per-output-column accumulator.  Every input point is touched once, in
+ * order, and each accumulator sees its values in the same order the old
+ * gather-and-sum did, so the results are identical.  Any fill value in a
+ * square makes the whole output point fill.
+ */
+	static void
+contract_data_mean( float *small_data, float *data, long nx, long ny, long n, 
+		size_t x0, size_t y0, size_t w, size_t h, float fill_value, RenderScratch *s )
+{
+	double	*sum;
+	char	*has_fill;
+	long	i, j, ii, jj, ioffset, joffset;
+	float	*row, val;
+	double	npts;
+
+	if( w > s->sum_w ) {
+		if( s->sum != NULL ) {
+			free( s->sum );
+			free( s->has_fill );
+			}
+		s->sum      = (double *)malloc( w*sizeof(double) );
+		s->has_fill = (char   *)malloc( w );
+		if( (s->sum == NULL) || (s->has_fill == NULL) ) {
+			fprintf( stderr, "internal error, failed to allocate array for calculating reduced means\n" );
+			exit( -1 );
+			}
+		s->sum_w = w;
+		}
+	sum      = s->sum;
+	has_fill = s->has_fill;
+
+	npts = (double)(n*n);
+
+	for( j=0; j<h; j++ ) {
+		for( i=0; i<w; i++ ) {
+			sum[i]      = 0.0;
+			has_fill[i] = FALSE;
+			}
+
+		for( jj=0; jj<n; jj++ ) {
+			joffset = (y0+j)*n + jj;
 			if( joffset >= ny )
 				joffset = ny-1;
-			idx = ioffset + joffset*nx;
-			tmpv[ii + jj*n] = *((float *)v->data + idx);
+			row = data + joffset*nx;
+
+			for( i=0; i<w; i++ ) {
+				if( has_fill[i] )
+					continue;
+				for( ii=0; ii<n; ii++ ) {
+					ioffset = (x0+i)*n + ii;
+					if( ioffset >= nx )
+						ioffset = nx-1;
+					val = *(row + ioffset);
+					if( close_enough( val, fill_value )) {
+						has_fill[i] = TRUE;
+						break;
+						}
+					sum[i] += val;
+					}
+				}
 			}
 
-		if( options.shrink_method == SHRINK_METHOD_MEAN )
-			small_data[i + j*new_nx] = util_mean( tmpv, n*n, fill_value );
-
-		else if( options.shrink_method == SHRINK_METHOD_MODE ) {
-			small_data[i + j*new_nx] = util_mode( tmpv, n*n, fill_value );
+		for( i=0; i<w; i++ ) {
+			if( has_fill[i] )
+				small_data[i + j*w] = fill_value;
+			else
+				small_data[i + j*w] = (float)(sum[i] / npts);
 			}
-		else
-			{
-			fprintf( stderr, "Error in contract_data: unknown value of options.shrink_method!\n" );
+		}
+}
+
+/********************************************************************************
+ * Block modes.  Each n x n square is gathered into a scratch array that is
+ * kept in 's' between calls, then handed to util_mode.
+ */
+	static void
+contract_data_mode( float *small_data, float *data, long nx, long ny, long n, 
+		size_t x0, size_t y0, size_t w, size_t h, float fill_value, RenderScratch *s )
+{
+	float	*tmpv;
+	long	i, j, ii, jj, ioffset, joffset;
+	float	*row;
+
+	if( n*n > s->tmpv_n ) {
+		if( s->tmpv != NULL )
+			free( s->tmpv );
+		s->tmpv = (float *)malloc( n*n * sizeof(float) );
+		if( s->tmpv == NULL ) {
+			fprintf( stderr, "internal error, failed to allocate array for calculating reduced modes\n" );
 			exit( -1 );
 			}
+		s->tmpv_n = n*n;
 		}
+	tmpv = s->tmpv;
 
-
-	free(tmpv);
+	for( j=0; j<h; j++ )
+	for( i=0; i<w; i++ ) {
+		for( jj=0; jj<n; jj++ ) {
+			joffset = (y0+j)*n + jj;
+			if( joffset >= ny )
+				joffset = ny-1;
+			row = data + joffset*nx;
+			for( ii=0; ii<n; ii++ ) {
+				ioffset = (x0+i)*n + ii;
+				if( ioffset >= nx )
+					ioffset = nx-1;
+				tmpv[ii + jj*n] = *(row + ioffset);
+				}
+			}
+		small_data[i + j*w] = util_mode( tmpv, n*n, fill_value, s );
+		}
 }
 
 /******************************************************************************
  * Actually do the "blowup" of the FLOATING POINT (not pixel) data, converting 
- * it to the large version by either interpolation or replication.
+ * it to the large version by either interpolation or replication.  Only the
+ * w x h rectangle of the big field starting at (x0,y0) is computed; it is
+ * written to 'big_data' with a row length of 'w'.
  * NOTE this routine is only called when options.blowup > 0!
  */
 	void
-expand_data( float *big_data, View *v )
+expand_data( float *big_data, View *v, size_t x0, size_t y0, size_t w, size_t h )
 {
-	size_t	to_width, x_size, y_size;
-	long	line, i, j, i2, j2;
-	int	blowup, blowupsq;
-	float	step;
-	float	base_val, right_val, below_val, val, bupr;
-	float	base_x, base_y, del_x, del_y;
-	float	est1, est2, frac_x, frac_y;
-	float 	fill_val;
+	size_t	to_width, x_size, y_size, i, j, ii;
+	int	blowup, blowupsq, k;
+	float 	fill_val, *out, *src;
 
 	fill_val = v->variable->fill_value;
 	x_size   = *(v->variable->size + v->x_axis_id);
@@ -1295,97 +2161,180 @@ expand_data( float *big_data, View *v )
 		}
 
 	if( options.blowup_type == BLOWUP_REPLICATE ) { 
-		for( j=0; j<y_size; j++ ) {
-			for( i=0; i<x_size; i++ )
-				for( i2=0; i2<blowup; i2++ )
-					*(big_data + i*blowup + j*to_width*blowup + i2) = *((float *)((float *)v->data)+i+j*x_size);
-			for( line=1; line<blowup; line++ )
-				for( i2=0; i2<to_width; i2++ )
-					*(big_data + i2 + j*to_width*blowup + line*to_width) =
-						*(big_data + i2 + j*to_width*blowup);
+		for( j=0; j<h; j++ ) {
+			out = big_data + j*w;
+			if( (j > 0) && (((y0+j) % blowup) != 0) ) {
+				memcpy( out, out - w, w*sizeof(float) );
+				continue;
+				}
+			src = (float *)v->data + ((y0+j)/blowup)*x_size;
+			ii  = x0/blowup;
+			k   = x0%blowup;
+			for( i=0; i<w; i++ ) {
+				*(out+i) = *(src+ii);
+				if( ++k == blowup ) {
+					k = 0;
+					ii++;
+					}
+				}
 			}
 		} 
-	else 	{ /* BLOWUP_BILINEAR */
-		bupr = 1.0/(float)blowup;
-
-		/* Horizontal base lines */
-		for( j=0; j<y_size; j++ )
-		for( i=0; i<x_size-1; i++ ) {
-			base_val  = *((float *)v->data + i   + j*x_size);
-			right_val = *((float *)v->data + i+1 + j*x_size);
-
-			if( close_enough(base_val,  fill_val) || 
-			    close_enough(right_val, fill_val))
-				step = 0.0;
-			else
-				step = (right_val-base_val)*bupr;
-			val = base_val;
+	else 	/* BLOWUP_BILINEAR */
+		expand_data_bilinear( big_data, (float *)v->data, x_size, y_size, 
+				blowup, fill_val, x0, y0, w, h, view_scratch( v ));
+}
 
-			for( i2=0; i2 < blowup; i2++ ) {
-				*(big_data + i*blowup+i2 + j*x_size*blowupsq ) = val;
-				val += step;
-				}
+/******************************************************************************
+ * Horizontally interpolate spans i0 .. i0+nspan-1 of one source row into a
+ * row 'blowup' times as wide.  'mask' is filled in with whether each of 
+ * those source points is the fill value.  If either end of a span is fill, 
+ * or there is no point to the right, the span just replicates its base value.
+ */
+	static void
+bilin_interp_row( float *src, size_t x_size, size_t i0, size_t nspan, int blowup, 
+		float *weight, float fill_val, float *dest, char *mask )
+{
+	size_t	i, k;
+	int	i2, right_is_fill;
+	float	base_val, del, *out;
+
+	for( k=0; k<nspan; k++ )
+		*(mask+k) = (char)close_enough( *(src+i0+k), fill_val );
+
+	for( k=0; k<nspan; k++ ) {
+		i        = i0 + k;
+		base_val = *(src+i);
+		out      = dest + k*blowup;
+		if( i == x_size-1 )
+			right_is_fill = TRUE;
+		else if( k+1 < nspan )
+			right_is_fill = *(mask+k+1);
+		else
+			right_is_fill = close_enough( *(src+i+1), fill_val );
+
+		if( *(mask+k) || right_is_fill ) {
+			for( i2=0; i2<blowup; i2++ )
+				*(out+i2) = base_val;
+			}
+		else
+			{
+			del = *(src+i+1) - base_val;
+			for( i2=0; i2<blowup; i2++ )
+				*(out+i2) = base_val + *(weight+i2)*del;
 			}
+		}
+}
 
-		/* Vertical base lines */
-		for( j=0; j<y_size-1; j++ )
-		for( i=0; i<x_size; i++ ) {
-			base_val  = *((float *)v->data + i   + j*x_size);
-			below_val = *((float *)v->data + i + (j+1)*x_size);
-			if( close_enough(base_val,  fill_val) || 
-			    close_enough(below_val, fill_val))
-				step = 0.0;
-			else
-				step = (below_val-base_val)*bupr;
-			val = base_val;
+/******************************************************************************
+ * Bilinear blowup, done separably.  Each source row is interpolated
+ * horizontally exactly once, and each output row is then a vertical blend 
+ * of two adjacent interpolated rows.  Only those two rows are live at a 
+ * time, so the working set stays in cache however big the field is, and 
+ * the output is written strictly in order.  Interpolation weights only
+ * depend on the blowup factor, so are computed once per factor.  Spans that
+ * touch a fill value replicate their base value instead of interpolating.
+ * The last row and column have nothing to interpolate towards, so they
+ * are replicated rather than drawn as missing.  Only the source spans that
+ * cover the requested rectangle are interpolated.
+ */
+	static void
+expand_data_bilinear( float *big_data, float *data, size_t x_size, size_t y_size, 
+		int blowup, float fill_val, size_t x0, size_t y0, size_t w, size_t h, RenderScratch *s )
+{
+	float	*weight, *row_buf;
+	char	*mask_buf;
+	float	*row0, *row1, *line, *tmp_row, *out, *a, *b, wt;
+	char	*mask0, *mask1, *tmp_mask;
+	size_t	i0, nspan, span_w, off, j, j_first, j_last, r, k;
+	int	i2, j2, have_next;
+
+	i0      = x0/blowup;
+	nspan   = (x0+w-1)/blowup - i0 + 1;
+	span_w  = nspan*blowup;
+	off     = x0 - i0*blowup;
+	j_first = y0/blowup;
+	j_last  = (y0+h-1)/blowup;
+
+	if( blowup != s->weight_blowup ) {
+		if( s->weight != NULL )
+			free( s->weight );
+		s->weight = (float *)malloc( blowup*sizeof(float) );
+		if( s->weight == NULL ) {
+			fprintf( stderr, "ncview: expand_data: failed to allocate weights\n" );
+			exit( -1 );
+			}
+		for( i2=0; i2<blowup; i2++ )
+			*(s->weight+i2) = (float)i2/(float)blowup;
+		s->weight_blowup = blowup;
+		}
 
-			for( j2=0; j2 < blowup; j2++ ) {
-				*(big_data + i*blowup + j*to_width*blowup + j2*to_width ) = val;
-				val += step;
-				}
+	if( span_w > s->span_w ) {
+		if( s->row_buf != NULL ) {
+			free( s->row_buf );
+			free( s->mask_buf );
 			}
-		/* Now, fill in the interior of the square by 
-		 * interpolating from the horizontal and vertical
-		 * base lines.
-		 */
-		for( j=0; j<y_size-1; j++ )
-		for( i=0; i<x_size-1; i++ ) {
-			for( j2=1; j2<blowup; j2++ )
-			for( i2=1; i2<blowup; i2++ ) {
-				frac_x = (float)i2*bupr;
-				frac_y = (float)j2*bupr;
-				base_x = *(big_data + i*blowup + j*to_width*blowup+j2*to_width);
-				right_val = *(big_data + (i+1)*blowup + j*to_width*blowup+ j2*to_width);
-				base_y = *(big_data + i*blowup+i2 + j*to_width*blowup);
-				below_val = *(big_data + i*blowup+i2 + (j+1)*to_width*blowup);
-
-				if( close_enough(base_x,    fill_val) || 
-				    close_enough(right_val, fill_val) || 
-				    (i == x_size-1) )
-					del_x = 0.0;
-				else
-					del_x  = right_val - base_x;
-				if( close_enough(base_y,    fill_val) || 
-				    close_enough(below_val, fill_val) || 
-				    (j == y_size-1) )
-					del_y = 0.0;
+		s->row_buf  = (float *)malloc( 3*span_w*sizeof(float) );
+		s->mask_buf = (char  *)malloc( 2*span_w );
+		if( (s->row_buf == NULL) || (s->mask_buf == NULL) ) {
+			fprintf( stderr, "ncview: expand_data: failed to allocate row buffers\n" );
+			fprintf( stderr, "requested size: %ld bytes\n", 3*span_w*sizeof(float) );
+			exit( -1 );
+			}
+		s->span_w = span_w;
+		}
+	weight   = s->weight;
+	row_buf  = s->row_buf;
+	mask_buf = s->mask_buf;
+
+	row0  = row_buf;
+	row1  = row_buf + span_w;
+	line  = row_buf + 2*span_w;
+	mask0 = mask_buf;
+	mask1 = mask_buf + span_w;
+
+	bilin_interp_row( data + j_first*x_size, x_size, i0, nspan, blowup, weight, fill_val, 
+			row0, mask0 );
+
+	for( j=j_first; j<=j_last; j++ ) {
+
+		have_next = (j < y_size-1);
+		if( have_next )
+			bilin_interp_row( data + (j+1)*x_size, x_size, i0, nspan, blowup, weight, 
+					fill_val, row1, mask1 );
+
+		for( j2=0; j2<blowup; j2++ ) {
+			r = j*blowup + j2;
+			if( r < y0 )
+				continue;
+			if( r >= y0+h )
+				break;
+			out = big_data + (r-y0)*w;
+
+			/* First output line of each block is the interpolated row itself */
+			if( (j2 == 0) || (! have_next) ) {
+				memcpy( out, row0 + off, w*sizeof(float) );
+				continue;
+				}
+
+			wt = *(weight+j2);
+			for( k=0; k<nspan; k++ ) {
+				a = row0 + k*blowup;
+				b = row1 + k*blowup;
+				if( *(mask0+k) || *(mask1+k) ) {
+					for( i2=0; i2<blowup; i2++ )
+						*(line + k*blowup + i2) = *(a+i2);
+					}
 				else
-					del_y  = below_val - base_y;
-				est1 = frac_x*del_x + base_x;
-				est2 = frac_y*del_y + base_y;
-				*(big_data + i*blowup+i2 + j*to_width*blowup + j2*to_width ) =
-					(est1 + est2)*.5;
+					{
+					for( i2=0; i2<blowup; i2++ )
+						*(line + k*blowup + i2) = *(a+i2) + wt*(*(b+i2) - *(a+i2));
+					}
 				}
+			memcpy( out, line + off, w*sizeof(float) );
 			}
-		/* Fill in right hand side */
-		for( j=0; j<blowup*y_size; j++ )
-		for( i=0; i<blowup; i++ )
-			*(big_data + (x_size-1)*blowup+i + j*to_width ) = fill_val;
 
-		/* Fill in bottom */
-		for( j=0; j<blowup; j++ )
-		for( i=0; i<blowup*x_size; i++ )
-			*(big_data + i + (y_size-1)*to_width*blowup + j*to_width ) = fill_val;
+		tmp_row  = row0;  row0  = row1;  row1  = tmp_row;
+		tmp_mask = mask0; mask0 = mask1; mask1 = tmp_mask;
 		}
 }
 
@@ -1486,7 +2435,9 @@ months_calc_tgran( int fileid, NCDim *d )
 		return( TGRAN_DAY );
 		}
 
+	fi_lock();
 	type = netcdf_dim_value( fileid, d->name, 0L, &temp_double, temp_string, 0L, &has_bounds, &bounds_min, &bounds_max );
+	fi_unlock();
 	if( type == NC_DOUBLE )
 		v0 = (float)temp_double;
 	else
@@ -1496,7 +2447,9 @@ months_calc_tgran( int fileid, NCDim *d )
 		return( TGRAN_DAY );
 		}
 
+	fi_lock();
 	type = netcdf_dim_value( fileid, d->name, 1L, &temp_double, temp_string, 1L, &has_bounds, &bounds_min, &bounds_max );
+	fi_unlock();
 	if( type == NC_DOUBLE )
 		v1 = (float)temp_double;
 	else
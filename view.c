@@ -51,6 +51,7 @@ static int 	lockout_view_changes = FALSE;
  * dumping out.
  */
 static double *plot_XY_xvals = NULL, *plot_XY_yvals = NULL;
+static long   plot_XY_n = 0L;		/* how many values they have room for */
 
 /* Saved dimension for the XY plot of the relevant index,
  * so that we know how to format dumps of that dim's values. Note
@@ -63,12 +64,86 @@ static NCDim *plot_XY_dim[MAX_PLOT_XY];
 #define	BUTTONS_TIMEAXIS_OFF	2
 #define	BUTTONS_ALL_OFF		3
 
+/* When the scaled image is bigger than the window, view->pixels is rendered
+ * in square tiles of this many pixels, and only the tiles within 
+ * VIEW_TILE_MARGIN pixels of the visible part of the image are made.
+ * tile_valid records which tiles are up to date.
+ */
+#define VIEW_TILE_SIZE		128
+#define VIEW_TILE_MARGIN	64
+
+static unsigned char	*tile_valid = NULL;
+static size_t		tiles_nx = 0L, tiles_ny = 0L;
+static size_t		tiles_image_nx = 0L, tiles_image_ny = 0L;
+static int		tiles_error = FALSE;
+
+/* With options.progressive, a frame of at least PROGRESSIVE_MIN_POINTS points
+ * that has to come from the file is first read with a stride that gives about
+ * PROGRESSIVE_COARSE_SIZE points along its longer side.  It is then read in 
+ * full on the worker thread, without holding up the animation, and drawn 
+ * again when it comes in.  Without a worker thread a work procedure does
+ * it when there is nothing else to do (refine_pending).
+ */
+#define PROGRESSIVE_MIN_POINTS	(1024L*1024L)
+#define PROGRESSIVE_COARSE_SIZE	256
+
+static int		refine_pending = FALSE;
+
+/* The frame being read on the worker thread; see view_read_start.  Only one
+ * read is ever out, so this, with its buffer and task, is used over and over.
+ * If another frame is wanted while it is out, 'again' is set and that frame
+ * is read when this one comes back.  The generation goes up with each frame
+ * asked for, so that the worker can skip a read that is out of date before
+ * it starts.
+ */
+typedef struct {
+	NCVar	*var;
+	size_t	place[MAX_VAR_DIMS], count[MAX_VAR_DIMS];
+	int	x_axis_id, y_axis_id;
+	unsigned long generation;
+	int	busy;		/* given to the worker, and not back yet */
+	int	again;		/* then read whatever frame the view is on */
+	int	done;		/* set by the worker once the data is read */
+	void	*buf;		/* read into, then swapped with view->data */
+	size_t	bytes;
+	WorkerTask task;
+} ViewRead;
+
+static ViewRead		frame_read;
+static unsigned long	read_generation = 0L;
+
+/* While a frame that was stepped to is being read, the animation timer is
+ * held, and -timing times the step from read_t0 until the frame is drawn.
+ * draw_deferred is set when view_draw_inner leaves the drawing to 
+ * view_read_done.
+ */
+static int		read_holds_timer = FALSE;
+static double		read_t0;
+static int		draw_deferred = FALSE;
+
+/* An XY plot being read on the worker thread; see plot_XY_sc */
+typedef struct {
+	NCVar	*var;
+	size_t	start[MAX_VAR_DIMS], count[MAX_VAR_DIMS];
+	int	dim_to_plot;
+	long	n;
+	int	done;		/* set by the worker once the data is read */
+	double	*xvals, *yvals;
+	float	*tmp_yvals;
+} PlotRead;
+
+/* The range the colorbar was last made for, so that animating in 
+ * RANGE_MODE_FRAME only remakes it when the range changes.
+ */
+static float		cbar_min = 1.0, cbar_max = 0.0;
+
 /* Prototypes applicable to routines used ONLY in this file */
 static void 		determine_scan_axes( View *view, NCVar *var, View *old_view );
 static void 		initial_determine_scan_axes( View *view, NCVar *var );
 static void 		fill_view_data( View *v );
 static void 		view_set_axis( View *local_view, int dimension, char *new_dim_name );
-static void 		alloc_view_storage( View *view );
+static int 		alloc_view_storage( View *view );
+static void 		free_view_storage( View *view );
 static void 		init_view( View **view, NCVar *var );
 static void 		set_buttons( int to_state );
 static void 		re_determine_scan_axes( View *new_view, NCVar *new_var, View *old_view );
@@ -87,6 +162,26 @@ static void 		invalidate_variable( NCVar *var );
 static void 		plot_XY_sc( size_t *start, size_t *count );
 static void 		mouse_xy_to_data_xy( int mouse_x, int mouse_y, int blowup, size_t *data_x, size_t *data_y );
 static int 		view_data_has_missing( View *v );
+static int		view_draw_inner( int allow_framestore_usage, int keep_tiles, int clip_to_window );
+static void		tiles_invalidate( void );
+static void		tiles_setup( size_t image_nx, size_t image_ny );
+static int		tiles_all_valid( size_t image_nx, size_t image_ny );
+static void		tiles_render( size_t image_nx, size_t image_ny, size_t x, size_t y, size_t w, size_t h );
+static int		fill_view_data_coarse( View *v );
+static Boolean		refine_view_data( XtPointer client_data );
+static void		update_frame_range( void );
+static void		show_frame_range( float min, float max );
+static void		make_colorbar( float min, float max );
+static void		print_selection( NCVar *var, size_t *start, size_t *count );
+static int		view_read_start( View *v, int hold_timer );
+static int		view_read_pending( View *v );
+static int		view_read_matches( ViewRead *r, View *v );
+static void		view_read_work( WorkerTask *task );
+static void		view_read_done( WorkerTask *task, int use_result );
+static void		view_read_free( void );
+static void		plot_XY_read_work( WorkerTask *task );
+static void		plot_XY_read_done( WorkerTask *task, int use_result );
+static void		plot_XY_show( size_t *start, int dim_to_plot, long n, float *tmp_yvals );
 
 /********************************************************************************
  * Make the passed variable the new variable which can be scanned using the
@@ -96,17 +191,26 @@ static int 		view_data_has_missing( View *v );
 set_scan_variable( NCVar *var )
 {
 	View	*new_view, *old_view;
-	size_t	*start, *count, x_size, y_size, scaled_x_size, scaled_y_size;
+	size_t	start[MAX_VAR_DIMS], count[MAX_VAR_DIMS], x_size, y_size, scaled_x_size, scaled_y_size;
 	long	i;
 	int	changed_size, overlay2use;
 	float	range_x, range_y;
+	double	t0;
 	NCDim	*xdim, *ydim, *xdim_old, *xdim_new, *ydim_old, *ydim_new;
 
 	if( options.debug )
 		fprintf( stderr, "\n\n******************************************\nentering set_scan_variable with var=%s\n", var->name );
 
+	/* A range scan still going for the last variable would only hold up
+	 * the reads for this one
+	 */
+	if( (view == NULL) || (view->variable != var) )
+		worker_cancel_all();
+
 	in_set_cursor_busy();
 
+	load_var_dims( var );
+
 	set_buttons( BUTTONS_ALL_ON );
 	unlock_plot();
 
@@ -124,16 +228,12 @@ set_scan_variable( NCVar *var )
 			fprintf( stderr, "...determining scan axes (NEW)\n" );
 		determine_scan_axes( view, var, NULL );
 		if( var->effective_dimensionality == 1 ) {
-			start = (size_t *)malloc(view->variable->n_dims*sizeof(size_t));
-			count = (size_t *)malloc(view->variable->n_dims*sizeof(size_t));
 			for( i=0; i<view->variable->n_dims; i++ ) {
 				*(start+i) = *(view->var_place+i);
 				*(count+i) = 1L;
 				}
 			*(count+view->x_axis_id) = *(view->variable->size + view->x_axis_id);
 			plot_XY_sc( start, count );
-			free( start );
-			free( count );
 			in_popdown_2d_window();
 			in_set_cursor_normal();
 			return(0);
@@ -177,16 +277,12 @@ set_scan_variable( NCVar *var )
 		determine_scan_axes( new_view, var, old_view );
 		if( var->effective_dimensionality == 1 ) {
 			view = new_view;
-			start = (size_t *)malloc(view->variable->n_dims*sizeof(size_t));
-			count = (size_t *)malloc(view->variable->n_dims*sizeof(size_t));
 			for( i=0; i<view->variable->n_dims; i++ ) {
 				*(start+i) = *(view->var_place+i);
 				*(count+i) = 1L;
 				}
 			*(count+view->x_axis_id) = *(view->variable->size + view->x_axis_id);
 			plot_XY_sc( start, count );
-			free( start );
-			free( count );
 			in_popdown_2d_window();
 			in_set_cursor_normal();
 			return(0);
@@ -217,9 +313,10 @@ set_scan_variable( NCVar *var )
 			}
 
 		/* Release the old storage */
-		free( old_view->data      );
-		free( old_view->pixels    );
+		free_view_storage( old_view );
 		free( old_view->var_place );
+		if( old_view->frame_ranges != NULL )
+			free( old_view->frame_ranges );
 
 		view = new_view;
 		}
@@ -229,8 +326,15 @@ set_scan_variable( NCVar *var )
 	 */
 	set_scan_buttons( view );
 
-	/* Allocate storage space for the data */
-	alloc_view_storage( view );
+	/* Allocate storage space for the data.  If there isn't room, the
+	 * user can still pick a smaller variable.
+	 */
+	if( alloc_view_storage( view ) < 0 ) {
+		set_buttons( BUTTONS_ALL_OFF );
+		in_popdown_2d_window();
+		in_set_cursor_normal();
+		return( -1 );
+		}
 
 	/* Actually read the data in from the file */
 	if( options.debug )
@@ -245,8 +349,11 @@ set_scan_variable( NCVar *var )
 		}
 
 	/* Set the min and maxes of the data */
-	if( !view->variable->have_set_range )
-		init_min_max( var );
+	if( !view->variable->have_set_range ) {
+		TIMING_BEGIN( t0 );
+		init_min_max_background( var );
+		TIMING_END( TIMING_MIN_MAX, t0 );
+		}
 
 	/* If we are automatically putting on overlays, do so now */
 	xdim = *(view->variable->dim + view->x_axis_id);
@@ -271,6 +378,7 @@ set_scan_variable( NCVar *var )
 	if( options.debug )
 		fprintf( stderr, "...converting data to pixels\n" );
 	lockout_view_changes = TRUE;
+	update_frame_range();
 	if( data_to_pixels( view ) < 0 ) {
 		in_timer_clear();
 		if( view->variable->global_min == view->variable->global_max )
@@ -433,10 +541,10 @@ change_view( int delta, int interpretation )
 	void
 set_scan_view( size_t scan_place )
 {
-	char	temp_string[1024], view_place[1024];
+	char	temp_string[1024], view_place[1200], mem_string[64];
 	size_t	size;
 	char	*dim_name;
-	double	new_dimval, bound_min, bound_max;
+	double	new_dimval, bound_min, bound_max, fps;
 	nc_type	type;
 	NCDim	*dim;
 	int	has_bounds;
@@ -511,7 +619,13 @@ set_scan_view( size_t scan_place )
 	in_set_cur_dim_value( dim_name, temp_string );
 	view->data_status = VDS_INVALID;
 	if( options.want_extra_info ) {
-		in_set_label( LABEL_CCINFO_2, temp_string );
+		membudget_usage_string( mem_string );
+		fps = in_timer_achieved_fps();
+		if( fps > 0.0 ) 
+			sprintf( view_place, "%s   (%.1f fps, %s)", temp_string, fps, mem_string );
+		else
+			sprintf( view_place, "%s   (%s)", temp_string, mem_string );
+		in_set_label( LABEL_CCINFO_2, view_place );
 		}
 }
 
@@ -521,9 +635,55 @@ set_scan_view( size_t scan_place )
 	int
 view_draw( int allow_framestore_usage )
 {
-	long		i; 
-	size_t		x_size, y_size, scaled_x_size, scaled_y_size, framesize, frameno;
+	int	retval;
+	double	t0;
+
+	TIMING_BEGIN( t0 );
+	retval = view_draw_inner( allow_framestore_usage, FALSE, TRUE );
+	if( ! draw_deferred )	/* else it is timed by view_read_done */
+		TIMING_END( TIMING_FRAME, t0 );
+
+	return( retval );
+}
+
+/********************************************************************************
+ * Called when part of the image window has been exposed, including when it
+ * is scrolled.  Nothing about the view has changed, so any tiles that have
+ * already been rendered are still good and only the missing ones are made.
+ */
+	int
+view_expose( void )
+{
+	return( view_draw_inner( TRUE, TRUE, TRUE ));
+}
+
+/********************************************************************************
+ * Draw the current view, rendering every pixel even if the image is bigger
+ * than the window.  This is for things (like printing) that want to use
+ * view->pixels afterwards.
+ */
+	int
+view_draw_all_pixels( void )
+{
+	return( view_draw_inner( FALSE, FALSE, FALSE ));
+}
+
+/********************************************************************************
+ * If keep_tiles is FALSE, the pixels are assumed to be out of date and 
+ * everything that is shown gets rendered again.  If clip_to_window is TRUE
+ * and the scaled image is bigger than the window, only the tiles that are
+ * visible (plus a margin, so that small scrolls are already done) are
+ * rendered and sent to the display.
+ */
+	static int
+view_draw_inner( int allow_framestore_usage, int keep_tiles, int clip_to_window )
+{
+	size_t		x_size, y_size, scaled_x_size, scaled_y_size, frameno;
+	size_t		vis_x, vis_y, vis_w, vis_h;
 	static int	last_x_size=0, last_y_size=0;
+	ncv_pixel	*stored_frame;
+	int		use_tiles, have_range, new_data;
+	float		range_min, range_max;
 
 	/* The reason why we have to lockout the possiblity that this
 	 * routine is called WHILE it is executing is tricky.  The 
@@ -534,6 +694,7 @@ view_draw( int allow_framestore_usage )
 	 * way of locking out entry to this subroutine while it is actively
 	 * being executed or the other modal dialogs are popped up.
 	 */
+	draw_deferred = FALSE;
 	if( lockout_view_changes )
 		return(0);
 	lockout_view_changes = TRUE;
@@ -551,7 +712,6 @@ view_draw( int allow_framestore_usage )
 	y_size = *(view->variable->size + view->y_axis_id);
 	view_get_scaled_size( options.blowup, x_size, y_size, &scaled_x_size, &scaled_y_size );
 
-	framesize = scaled_x_size * scaled_y_size;
 	if( view->scan_axis_id == -1 )
 		frameno = 0;
 	else
@@ -567,22 +727,70 @@ view_draw( int allow_framestore_usage )
 						frameno );
 		}
 
+	/* With a range for each frame, a saved frame is only any good if
+	 * we know what range it was drawn with, to label it.
+	 */
+	if( options.range_mode == RANGE_MODE_FRAME )
+		have_range = get_frame_range( view, frameno, &range_min, &range_max );
+	else
+		have_range = TRUE;
+
+	/* Is this frame being kept on the display server? */
+	if( allow_framestore_usage && have_range && (! options.dump_frames) &&
+	    in_draw_frame_pixmap( frameno, scaled_x_size, scaled_y_size )) {
+		if( options.debug )
+			printf( "drawing from frame pixmap...\n" );
+		if( ! keep_tiles )
+			tiles_invalidate();
+		if( options.range_mode == RANGE_MODE_FRAME )
+			show_frame_range( range_min, range_max );
+		lockout_view_changes = FALSE;
+		return(0);
+		}
+
 	/* Is this frame stored in the framestore? */
-	if( framestore.valid && allow_framestore_usage ) {
-		if( *(framestore.frame_valid + frameno) == TRUE ) {
+	if( framestore.valid && allow_framestore_usage && have_range ) {
+		stored_frame = framestore_get( frameno, scaled_x_size, scaled_y_size );
+		if( stored_frame != NULL ) {
 			if( options.debug )
 				printf( "drawing from framestore...\n" );
-			in_draw_2d_field( (framestore.frame + frameno*framesize), 
-				scaled_x_size, scaled_y_size, frameno );
+			if( ! keep_tiles )
+				tiles_invalidate();
+			in_draw_2d_field( stored_frame, scaled_x_size, scaled_y_size, frameno );
+			in_save_frame_pixmap( frameno, scaled_x_size, scaled_y_size );
+			if( options.range_mode == RANGE_MODE_FRAME )
+				show_frame_range( range_min, range_max );
 			lockout_view_changes = FALSE;
 			return(0);
 			}
 		}
 
+	/* A frame that has to come from the file is read on the worker thread
+	 * and drawn when it comes in (see view_read_done).  Until then the old
+	 * picture stays up, and exposes are served from the backing pixmap.
+	 */
+	new_data = FALSE;
 	if( view->data_status == VDS_INVALID ) {
+		if( clip_to_window && (! options.dump_frames) ) {
+			if( view_read_pending( view ) ||
+			    ((! fill_view_data_coarse( view )) && view_read_start( view, TRUE ))) {
+				draw_deferred        = TRUE;
+				lockout_view_changes = FALSE;
+				return(0);
+				}
+			}
+		if( view->data_status == VDS_INVALID ) {
+			if( options.debug )
+				printf( "Reading data to contour...\n" );
+			fill_view_data( view );
+			}
+		new_data = TRUE;
+		}
+	else if( (view->data_status == VDS_COARSE) && (! keep_tiles) && (! view_read_pending( view )) ) {
 		if( options.debug )
-			printf( "Reading data to contour...\n" );
+			printf( "Reading full resolution data to contour...\n" );
 		fill_view_data( view );
+		new_data = TRUE;
 		}
 	else
 		{
@@ -590,16 +798,12 @@ view_draw( int allow_framestore_usage )
 			printf( "NOT reading data to contour, since data is valid (%d)\n", view->data_status );
 		}
 
-	if( options.debug )
-		printf( "Calling data_to_pixels...\n" );
-	if( data_to_pixels( view ) < 0 ) {
-		in_timer_clear();
-		if( view->variable->global_min == view->variable->global_max )
-			invalidate_variable( view->variable );
-		lockout_view_changes = FALSE;
-		return( -1 );
+	if( (! keep_tiles) || new_data ) {
+		tiles_invalidate();
+		in_invalidate_2d_backing();
 		}
 
+	/* The window has to be the right size before we can tell what is visible */
 	if( (last_x_size != scaled_x_size) ||
 	    (last_y_size != scaled_y_size)) {
 		last_x_size = scaled_x_size;
@@ -607,20 +811,185 @@ view_draw( int allow_framestore_usage )
 		in_set_2d_size  ( scaled_x_size, scaled_y_size );
 		}
 
+	/* Frames being dumped to disk have to be complete */
+	use_tiles = FALSE;
+	if( clip_to_window && (! options.dump_frames) ) {
+		in_get_visible_region( scaled_x_size, scaled_y_size, &vis_x, &vis_y, &vis_w, &vis_h );
+		if( (vis_w < scaled_x_size) || (vis_h < scaled_y_size) )
+			use_tiles = TRUE;
+		}
+
+	update_frame_range();
+
+	if( options.debug )
+		printf( "Calling data_to_pixels...\n" );
+	if( use_tiles )
+		tiles_render( scaled_x_size, scaled_y_size, vis_x, vis_y, vis_w, vis_h );
+	else if( ! tiles_all_valid( scaled_x_size, scaled_y_size ))
+		tiles_render( scaled_x_size, scaled_y_size, 0L, 0L, scaled_x_size, scaled_y_size );
+	if( tiles_error ) {
+		tiles_error = FALSE;
+		tiles_invalidate();
+		in_timer_clear();
+		if( view->variable->global_min == view->variable->global_max )
+			invalidate_variable( view->variable );
+		lockout_view_changes = FALSE;
+		return( -1 );
+		}
+
 	if( options.debug )
 		printf( "Calling draw_2d_field...\n" );
-	in_draw_2d_field( view->pixels, scaled_x_size, scaled_y_size, frameno );
+	if( use_tiles )
+		in_draw_2d_region( view->pixels, scaled_x_size, scaled_y_size, 
+				vis_x, vis_y, vis_w, vis_h, frameno );
+	else
+		in_draw_2d_field( view->pixels, scaled_x_size, scaled_y_size, frameno );
 
-	if( framestore.valid == TRUE ) {
-		for( i=0; i<framesize; i++ )
-			*(framestore.frame + frameno*framesize + i) = *(view->pixels + i);
-		*(framestore.frame_valid + frameno) = TRUE;
+	/* Only complete, full resolution frames go into the framestore */
+	if( (framestore.valid == TRUE) && (view->data_status != VDS_COARSE) &&
+	    tiles_all_valid( scaled_x_size, scaled_y_size ))
+		framestore_put( frameno, view->pixels, scaled_x_size, scaled_y_size );
+	if( view->data_status != VDS_COARSE )
+		in_save_frame_pixmap( frameno, scaled_x_size, scaled_y_size );
+
+	if( (view->data_status == VDS_COARSE) && (! view_read_pending( view )) &&
+	    (! view_read_start( view, FALSE )) && (! refine_pending) ) {
+		refine_pending = TRUE;
+		in_work_proc_set( refine_view_data, NULL );
 		}
 
+	if( options.timing )
+		timing_first_draw();
+
 	lockout_view_changes = FALSE;
 	return( 0 );
 }
 
+/********************************************************************************
+ * Work procedure that replaces the low resolution version of a frame with
+ * the full resolution one, when there is no worker thread to read it.  If
+ * the user has moved on to a frame that has not been drawn yet, there is 
+ * nothing to do; the frame that was passed by is never read in full.
+ */
+	static Boolean
+refine_view_data( XtPointer client_data )
+{
+	refine_pending = FALSE;
+	if( (view != NULL) && (view->data_status == VDS_COARSE) )
+		view_draw( TRUE );
+	return( True );
+}
+
+/********************************************************************************
+ * Forget which tiles of view->pixels have been rendered.
+ */
+	static void
+tiles_invalidate( void )
+{
+	size_t	i;
+
+	if( tile_valid == NULL )
+		return;
+	for( i=0; i<tiles_nx*tiles_ny; i++ )
+		*(tile_valid+i) = FALSE;
+}
+
+/********************************************************************************
+ * Make sure the tile bookkeeping is set up for an image of the given size.
+ * Changing the size throws away what we knew about the old tiles.
+ */
+	static void
+tiles_setup( size_t image_nx, size_t image_ny )
+{
+	if( (tile_valid != NULL) && (image_nx == tiles_image_nx) && (image_ny == tiles_image_ny))
+		return;
+
+	if( tile_valid != NULL )
+		free( tile_valid );
+
+	tiles_image_nx = image_nx;
+	tiles_image_ny = image_ny;
+	tiles_nx = (image_nx + VIEW_TILE_SIZE - 1)/VIEW_TILE_SIZE;
+	tiles_ny = (image_ny + VIEW_TILE_SIZE - 1)/VIEW_TILE_SIZE;
+
+	tile_valid = (unsigned char *)malloc( tiles_nx*tiles_ny );
+	if( tile_valid == NULL ) {
+		fprintf( stderr, "ncview: tiles_setup: failed on malloc of %ld bytes\n",
+			(long)(tiles_nx*tiles_ny) );
+		exit( -1 );
+		}
+	tiles_invalidate();
+}
+
+/********************************************************************************
+ * Returns TRUE if every tile of an image of the given size has been rendered.
+ */
+	static int
+tiles_all_valid( size_t image_nx, size_t image_ny )
+{
+	size_t	i;
+
+	if( (tile_valid == NULL) || (image_nx != tiles_image_nx) || (image_ny != tiles_image_ny))
+		return( FALSE );
+	for( i=0; i<tiles_nx*tiles_ny; i++ )
+		if( ! *(tile_valid+i) )
+			return( FALSE );
+	return( TRUE );
+}
+
+/********************************************************************************
+ * Render all the tiles of view->pixels that touch the given rectangle, 
+ * widened by VIEW_TILE_MARGIN on each side, and have not been rendered yet.
+ * Runs of adjacent missing tiles in a row of tiles are done in one call to
+ * data_to_pixels_region.  Sets tiles_error if that fails.
+ */
+	static void
+tiles_render( size_t image_nx, size_t image_ny, size_t x, size_t y, size_t w, size_t h )
+{
+	size_t	tx, ty, tx0, tx1, ty0, ty1, run_start, px0, py0, pw, ph;
+
+	tiles_setup( image_nx, image_ny );
+	if( (w == 0) || (h == 0) )
+		return;
+
+	tx0 = (x > VIEW_TILE_MARGIN) ? (x - VIEW_TILE_MARGIN)/VIEW_TILE_SIZE : 0L;
+	ty0 = (y > VIEW_TILE_MARGIN) ? (y - VIEW_TILE_MARGIN)/VIEW_TILE_SIZE : 0L;
+	tx1 = (x + w + VIEW_TILE_MARGIN - 1)/VIEW_TILE_SIZE;
+	ty1 = (y + h + VIEW_TILE_MARGIN - 1)/VIEW_TILE_SIZE;
+	if( tx1 >= tiles_nx )
+		tx1 = tiles_nx - 1;
+	if( ty1 >= tiles_ny )
+		ty1 = tiles_ny - 1;
+
+	for( ty=ty0; ty<=ty1; ty++ ) {
+		py0 = ty*VIEW_TILE_SIZE;
+		ph  = image_ny - py0;
+		if( ph > VIEW_TILE_SIZE )
+			ph = VIEW_TILE_SIZE;
+		tx = tx0;
+		while( tx <= tx1 ) {
+			if( *(tile_valid + tx + ty*tiles_nx) ) {
+				tx++;
+				continue;
+				}
+			run_start = tx;
+			while( (tx <= tx1) && (! *(tile_valid + tx + ty*tiles_nx)) ) {
+				*(tile_valid + tx + ty*tiles_nx) = TRUE;
+				tx++;
+				}
+			px0 = run_start*VIEW_TILE_SIZE;
+			pw  = tx*VIEW_TILE_SIZE;
+			if( pw > image_nx )
+				pw = image_nx;
+			pw -= px0;
+			if( data_to_pixels_region( view, px0, py0, pw, ph ) < 0 ) {
+				tiles_error = TRUE;
+				return;
+				}
+			}
+		}
+}
+
 /********************************************************************************
  * Determine what axes we should display the data using.  This returns
  * a three element Stringlist*; the first is the 'scan' axis, the second
@@ -751,18 +1120,23 @@ initial_determine_scan_axes( View *view, NCVar *var )
 
 /********************************************************************************
  * Actually go to the data file and read the data in, putting the result
- * in the view structure.
+ * in the view structure.  Slabs we have read before come out of the 
+ * slab cache instead.
  */
 	static void
 fill_view_data( View *v )
 {
-	size_t	*count;
+	size_t	count[MAX_VAR_DIMS];
 	int	i;
 
-	if( v->data_status == VDS_VALID )
+	if( (v->data_status == VDS_VALID) || (v->data == NULL) )
 		return;
 
-	count = (size_t *)malloc( v->variable->n_dims * sizeof( size_t ));
+	v->frame_range_current = FALSE;
+	if( slabcache_get( v->variable, v->var_place, v->x_axis_id, v->y_axis_id, (float *)v->data )) {
+		v->data_status = VDS_VALID;
+		return;
+		}
 
 	/* By default, count of 1 for all uninteresting dimensions */
 	for( i=0; i<v->variable->n_dims; i++ ) 
@@ -772,26 +1146,308 @@ fill_view_data( View *v )
 	*(count+v->x_axis_id) = *(v->variable->size + v->x_axis_id);
 	*(count+v->y_axis_id) = *(v->variable->size + v->y_axis_id);
 
-	if( options.show_sel ) {
-		printf( "-var %s -start \\(", v->variable->name );
-		for( i=v->variable->n_dims-1; i >= 0; i-- ) {
-			printf( "%1ld", 1 + (*(v->var_place+i)) );
-			if( i != 0 )
-				printf( "," );
+	if( options.show_sel )
+		print_selection( v->variable, v->var_place, count );
+
+	fi_get_data( v->variable, v->var_place, count, v->data );
+	slabcache_put( v->variable, v->var_place, v->x_axis_id, v->y_axis_id, (float *)v->data,
+		*(count+v->x_axis_id) * *(count+v->y_axis_id) );
+
+	v->data_status = VDS_VALID;
+}
+
+/********************************************************************************
+ * With the -progressive option, quickly fill v->data with a low resolution
+ * version of a large field that is not in the slab cache.  Every stride'th 
+ * point is read, and copied over the stride x stride block that it stands for.
+ * Sets v->data_status to VDS_COARSE and returns TRUE if this was done (or if 
+ * the field was in the cache after all, in which case it is VDS_VALID).
+ * Returns FALSE if the field should just be read normally.
+ */
+	static int
+fill_view_data_coarse( View *v )
+{
+	size_t	count[MAX_VAR_DIMS], nx, ny, n_fast, n_slow, c_fast, c_slow, stride, i, j;
+	ptrdiff_t strides[MAX_VAR_DIMS];
+	float	*coarse, *row, *crow;
+	int	k, fast_axis_id, slow_axis_id;
+
+	if( (! options.progressive) || (v->data == NULL) )
+		return( FALSE );
+
+	nx = *(v->variable->size + v->x_axis_id);
+	ny = *(v->variable->size + v->y_axis_id);
+	if( nx*ny < PROGRESSIVE_MIN_POINTS )
+		return( FALSE );
+
+	v->frame_range_current = FALSE;
+	if( slabcache_get( v->variable, v->var_place, v->x_axis_id, v->y_axis_id, (float *)v->data )) {
+		v->data_status = VDS_VALID;
+		return( TRUE );
+		}
+
+	/* The data is laid out with the later dimension varying fastest */
+	if( v->x_axis_id > v->y_axis_id ) {
+		fast_axis_id = v->x_axis_id;
+		slow_axis_id = v->y_axis_id;
+		}
+	else
+		{
+		fast_axis_id = v->y_axis_id;
+		slow_axis_id = v->x_axis_id;
+		}
+	n_fast = *(v->variable->size + fast_axis_id);
+	n_slow = *(v->variable->size + slow_axis_id);
+
+	stride = (((nx > ny) ? nx : ny) + PROGRESSIVE_COARSE_SIZE - 1)/PROGRESSIVE_COARSE_SIZE;
+	c_fast = (n_fast + stride - 1)/stride;
+	c_slow = (n_slow + stride - 1)/stride;
+
+	coarse  = (float *)malloc( c_fast*c_slow*sizeof( float ));
+	if( coarse == NULL ) {
+		fprintf( stderr, "ncview: fill_view_data_coarse: failed on malloc\n" );
+		exit( -1 );
+		}
+	for( k=0; k<v->variable->n_dims; k++ ) {
+		*(count+k)   = 1;
+		*(strides+k) = 1;
+		}
+	*(count+fast_axis_id)   = c_fast;
+	*(count+slow_axis_id)   = c_slow;
+	*(strides+fast_axis_id) = (ptrdiff_t)stride;
+	*(strides+slow_axis_id) = (ptrdiff_t)stride;
+
+	if( fi_get_data_strided( v->variable, v->var_place, count, strides, coarse ) < 0 ) {
+		free( coarse );
+		return( FALSE );
+		}
+
+	for( j=0; j<n_slow; j++ ) {
+		row = (float *)v->data + j*n_fast;
+		if( j%stride != 0 ) {
+			memcpy( row, row - n_fast, n_fast*sizeof(float) );
+			continue;
+			}
+		crow = coarse + (j/stride)*c_fast;
+		for( i=0; i<n_fast; i++ )
+			*(row+i) = *(crow + i/stride);
+		}
+
+	v->data_status = VDS_COARSE;
+	free( coarse );
+	return( TRUE );
+}
+
+/********************************************************************************
+ * With options.show_sel, print the selection being read in the form of 
+ * ncview's -var/-start/-count arguments (1-based, slowest dimension last).
+ */
+	static void
+print_selection( NCVar *var, size_t *start, size_t *count )
+{
+	int	i;
+
+	printf( "-var %s -start \\(", var->name );
+	for( i=var->n_dims-1; i >= 0; i-- ) {
+		printf( "%1ld", 1 + (*(start+i)) );
+		if( i != 0 )
+			printf( "," );
+		}
+	printf( "\\) -count \\(" );
+	for( i=var->n_dims-1; i >= 0; i-- ) {
+		printf( "%1ld", *(count+i) );
+		if( i != 0 )
+			printf( "," );
+		}
+	printf( "\\) %s\n", var->first_file->filename );
+}
+
+/********************************************************************************
+ * Start reading the frame the view is on into frame_read's buffer, on the 
+ * worker thread, and return TRUE.  view_read_done puts it in the view and 
+ * draws it when it comes in.  Returns FALSE if the frame must be read 
+ * the usual way instead, which is when there is no worker thread or no
+ * memory for the buffer; or if the frame was in the slab cache, in which
+ * case the view has it already.
+ *
+ * If hold_timer is TRUE the animation waits for the frame, so that
+ * it doesn't step on before anything is seen.
+ */
+	static int
+view_read_start( View *v, int hold_timer )
+{
+	ViewRead	*r;
+	int		i;
+
+	r = &frame_read;
+	if( (! worker_threaded()) || (v->data == NULL) )
+		return( FALSE );
+
+	if( slabcache_get( v->variable, v->var_place, v->x_axis_id, v->y_axis_id, (float *)v->data )) {
+		v->data_status         = VDS_VALID;
+		v->frame_range_current = FALSE;
+		return( FALSE );
+		}
+
+	if( ! r->busy ) {
+		if( (r->buf == NULL) || (r->bytes != v->data_bytes) ) {
+			membudget_free( MEM_VIEW, r->buf, r->bytes );
+			r->bytes = v->data_bytes;
+			r->buf   = membudget_malloc( MEM_VIEW, r->bytes );
+			if( r->buf == NULL ) {
+				r->bytes = 0L;
+				return( FALSE );
+				}
 			}
-		printf( "\\) -count \\(" );
-		for( i=v->variable->n_dims-1; i >= 0; i-- ) {
-			printf( "%1ld", *(count+i) );
-			if( i != 0 )
-				printf( "," );
+		r->var       = v->variable;
+		r->x_axis_id = v->x_axis_id;
+		r->y_axis_id = v->y_axis_id;
+		for( i=0; i<v->variable->n_dims; i++ ) {
+			*(r->place+i) = *(v->var_place+i);
+			*(r->count+i) = 1;
 			}
-		printf( "\\) %s\n", v->variable->first_file->filename );
+		*(r->count+v->x_axis_id) = *(v->variable->size + v->x_axis_id);
+		*(r->count+v->y_axis_id) = *(v->variable->size + v->y_axis_id);
+
+		if( options.show_sel )
+			print_selection( r->var, r->place, r->count );
 		}
 
-	fi_get_data( v->variable, v->var_place, count, v->data );
+	/* A read that is out for an older frame is skipped if it hasn't started */
+	__atomic_store_n( &read_generation, read_generation+1L, __ATOMIC_RELEASE );
 
-	v->data_status = VDS_VALID;
-	free( count );
+	if( hold_timer && (! read_holds_timer) ) {
+		in_timer_hold();
+		TIMING_BEGIN( read_t0 );
+		}
+	else if( read_holds_timer && (! hold_timer) )
+		in_timer_release();
+	read_holds_timer = hold_timer;
+
+	if( r->busy ) {
+		r->again = TRUE;
+		return( TRUE );
+		}
+
+	r->generation = read_generation;
+	r->busy       = TRUE;
+	r->again      = FALSE;
+	r->done       = FALSE;
+	worker_init_task( &(r->task), "Reading the data", view_read_work, view_read_done, r );
+	r->task.lane = WORKER_LANE_VIEW;
+	worker_run( &(r->task) );
+	return( TRUE );
+}
+
+/********************************************************************************
+ * Returns TRUE if the frame the view is on is going to come from 
+ * view_read_done.
+ */
+	static int
+view_read_pending( View *v )
+{
+	return( frame_read.busy && (frame_read.again || view_read_matches( &frame_read, v )));
+}
+
+/********************************************************************************
+ * Returns TRUE if the read is of the frame the view is on.
+ */
+	static int
+view_read_matches( ViewRead *r, View *v )
+{
+	int	i;
+
+	if( (r->var != v->variable) || (r->bytes != v->data_bytes) ||
+	    (r->x_axis_id != v->x_axis_id) || (r->y_axis_id != v->y_axis_id) )
+		return( FALSE );
+	for( i=0; i<r->var->n_dims; i++ )
+		if( *(r->place+i) != *(v->var_place+i) )
+			return( FALSE );
+	return( TRUE );
+}
+
+/********************************************************************************
+ * Work routine for view_read_start; runs on the worker thread.  By the time
+ * a read gets to the front of the queue the user may have moved on, and
+ * then it isn't done at all.
+ */
+	static void
+view_read_work( WorkerTask *task )
+{
+	ViewRead	*r;
+
+	r = (ViewRead *)task->data;
+	if( worker_cancelled( task ) || 
+	    (r->generation != __atomic_load_n( &read_generation, __ATOMIC_ACQUIRE )))
+		return;
+	fi_get_data( r->var, r->place, r->count, r->buf );
+	r->done = TRUE;
+}
+
+/********************************************************************************
+ * Done routine for view_read_start.  If the view is still on the frame that
+ * was read, and hasn't got it some other way meanwhile, the new data is
+ * swapped in and drawn; the view's old buffer is read into next time.  If
+ * the view has moved on to another frame meanwhile, that one is read now,
+ * unless the read was cancelled.
+ */
+	static void
+view_read_done( WorkerTask *task, int use_result )
+{
+	ViewRead	*r;
+	void		*tmp;
+
+	r       = (ViewRead *)task->data;
+	r->busy = FALSE;
+
+	if( use_result && r->done && (view != NULL) && view_read_matches( r, view ) &&
+	    ((view->data_status == VDS_INVALID) || (view->data_status == VDS_COARSE)) ) {
+		tmp        = view->data;
+		view->data = r->buf;
+		r->buf     = tmp;
+		slabcache_put( r->var, r->place, r->x_axis_id, r->y_axis_id, (float *)view->data,
+			*(r->count+r->x_axis_id) * *(r->count+r->y_axis_id) );
+		view->data_status         = VDS_VALID;
+		view->frame_range_current = FALSE;
+		if( read_holds_timer ) {
+			/* The step is timed up to now, not to when view_draw returned */
+			view_draw_inner( TRUE, FALSE, TRUE );
+			TIMING_END( TIMING_FRAME, read_t0 );
+			}
+		else
+			view_draw( TRUE );
+		}
+
+	if( r->again && use_result && (view != NULL) ) {
+		r->again = FALSE;
+		if( view->data_status == VDS_INVALID )
+			view_draw( TRUE );
+		else if( (view->data_status == VDS_COARSE) && (! view_read_start( view, FALSE )) &&
+			 (view->data_status == VDS_VALID) )
+			view_draw( TRUE );
+		if( r->busy )
+			return;
+		}
+	r->again = FALSE;
+
+	/* Drawing the frame counts as part of stepping to it */
+	if( read_holds_timer ) {
+		read_holds_timer = FALSE;
+		in_timer_release();
+		}
+}
+
+/********************************************************************************
+ * Give back frame_read's buffer, unless the worker is using it.
+ */
+	static void
+view_read_free( void )
+{
+	if( frame_read.busy )
+		return;
+	membudget_free( MEM_VIEW, frame_read.buf, frame_read.bytes );
+	frame_read.buf   = NULL;
+	frame_read.bytes = 0L;
 }
 
 /********************************************************************************
@@ -802,9 +1458,10 @@ view_change_blowup( int delta, int redraw_flag )
 {
 	size_t	x_size, y_size, scaled_x_size, scaled_y_size;
 	char	blowup_label[32];
-	int	changed_size;
+	int	changed_size, old_blowup;
 
 	in_set_cursor_busy();
+	old_blowup = options.blowup;
 
 	/* Sequence of 'options.blowup' should be: ..., -4, -3, -2, 1, 2, 3, ... */
 	if( delta > 0 ) {
@@ -824,6 +1481,28 @@ view_change_blowup( int delta, int redraw_flag )
 			options.blowup += delta;
 		}
 
+	membudget_free( MEM_VIEW, view->pixels, view->pixels_bytes );
+
+	x_size       = *(view->variable->size + view->x_axis_id);
+	y_size       = *(view->variable->size + view->y_axis_id);
+	view_get_scaled_size( options.blowup, x_size, y_size, &scaled_x_size, &scaled_y_size );
+
+	view->pixels_bytes = scaled_x_size*scaled_y_size*sizeof(ncv_pixel);
+	view->pixels = (void *)membudget_malloc( MEM_VIEW, view->pixels_bytes );
+	if( (view->pixels == NULL) && (options.blowup != old_blowup) ) {
+		/* No room at this magnification; stay at the one we had */
+		options.blowup = old_blowup;
+		view_get_scaled_size( options.blowup, x_size, y_size, &scaled_x_size, &scaled_y_size );
+		view->pixels_bytes = scaled_x_size*scaled_y_size*sizeof(ncv_pixel);
+		view->pixels = (void *)membudget_malloc( MEM_VIEW, view->pixels_bytes );
+		in_error( "Not enough memory to change the magnification that much" );
+		}
+	if( view->pixels == NULL ) {
+		fprintf( stderr, "ncview: can't allocate pixel array of %ld x %ld\n",
+				scaled_x_size, scaled_y_size );
+		exit( -1 );
+		}
+
 	if( options.blowup > 0 ) 
 		sprintf( blowup_label, "M X%1d", options.blowup );
 	else
@@ -831,14 +1510,6 @@ view_change_blowup( int delta, int redraw_flag )
 
         in_set_label( LABEL_BLOWUP, blowup_label );
 
-	free( view->pixels );
-
-	x_size       = *(view->variable->size + view->x_axis_id);
-	y_size       = *(view->variable->size + view->y_axis_id);
-	view_get_scaled_size( options.blowup, x_size, y_size, &scaled_x_size, &scaled_y_size );
-
-	view->pixels = (void *)malloc( scaled_x_size*scaled_y_size*sizeof(ncv_pixel) );
-
 	if( options.save_frames == TRUE ) {
 		if( options.debug )
 			fprintf( stderr, "calling init_saveframes from view_change_blowup\n" );
@@ -861,8 +1532,7 @@ view_change_blowup( int delta, int redraw_flag )
 	void
 redraw_ccontour()
 {
-printf( "got an expose event\n" );
-	view_draw( TRUE ); 
+	view_expose();
 }
 
 /************************************************************************
@@ -1018,7 +1688,12 @@ view_set_scan_dims( void )
 		flip_if_inverted( view );
 		redraw_dimension_info();
 		view->data_status = VDS_INVALID;
-		alloc_view_storage( view );
+		if( alloc_view_storage( view ) < 0 ) {
+			set_buttons( BUTTONS_ALL_OFF );
+			in_popdown_2d_window();
+			in_set_cursor_normal();
+			return;
+			}
 		init_saveframes();
 		set_scan_buttons( view );
 		view_draw( TRUE ); /* 'TRUE' because we initialized saveframes above */
@@ -1090,11 +1765,16 @@ view_set_axis( View *local_view, int dimension, char *new_dim_name )
 	in_indicate_active_dim( dimension, new_dim_name );
 }
 
-/**************************************************************************************/
-	static void
+/**************************************************************************************
+ * Returns 0 on success, or -1 (having told the user) if there is not enough
+ * memory for the data.  view->data is then NULL; nothing is drawn, and
+ * everything that looks at the data checks for that first.
+ */
+	static int
 alloc_view_storage( View *view )
 {
-	size_t	x_size, y_size, tot_size, scaled_x_size, scaled_y_size;
+	size_t	x_size, y_size, scaled_x_size, scaled_y_size;
+	char	message[1024], stats[40*MEM_N_SUBSYSTEMS];
 
 	/* Allocate storage space for the data in the view structure
 	 */
@@ -1103,49 +1783,42 @@ alloc_view_storage( View *view )
 		view_data_edit_warn();
 	view->data_status = VDS_INVALID;
 		
-	if( view->data   != NULL )
-		free( view->data   );
-	if( view->pixels != NULL )
-		free( view->pixels );
+	free_view_storage( view );
 	x_size       = *(view->variable->size + view->x_axis_id);
 	y_size       = *(view->variable->size + view->y_axis_id);
 	view_get_scaled_size( options.blowup, x_size, y_size, &scaled_x_size, &scaled_y_size );
 
-	tot_size     = x_size*y_size*sizeof(float);
-	view->data   = (void *)malloc( tot_size );
-	if( view->data == NULL ) {
-		fprintf( stderr, "ncview: can't allocate data array\n" );
-		fprintf( stderr, "variable name: %s\n", view->variable->name );
-		fprintf( stderr, "requested size: %ldx%ld\n", x_size, y_size );
-		fprintf( stderr, "x axis id:%d  y axis id:%d\n",
-			view->x_axis_id, view->y_axis_id );
-		fprintf( stderr, "x axis name:%s  y axis name:%s\n",
-			fi_dim_id_to_name( view->variable->first_file->id,
-					   view->variable->name,
-					   view->x_axis_id ),
-			fi_dim_id_to_name( view->variable->first_file->id,
-					   view->variable->name,
-					   view->y_axis_id ) );
-		exit( -1 );
-		}
-	view->pixels = (ncv_pixel *)malloc( scaled_x_size*scaled_y_size*sizeof(ncv_pixel) );
-	if( view->pixels == NULL ) {
-		fprintf( stderr, "ncview: can't allocate pixel array\n" );
-		fprintf( stderr, "variable name: %s\n", view->variable->name );
-		fprintf( stderr, "requested size: %ld x %ld\n", 
-				scaled_x_size, 
-				scaled_y_size );
-		fprintf( stderr, "x axis id:%d  y axis id:%d\n",
-			view->x_axis_id, view->y_axis_id );
-		fprintf( stderr, "x axis name:%s  y axis name:%s\n",
-			fi_dim_id_to_name( view->variable->first_file->id,
-					   view->variable->name,
-					   view->x_axis_id ),
-			fi_dim_id_to_name( view->variable->first_file->id,
-					   view->variable->name,
-					   view->y_axis_id ) );
-		exit( -1 );
+	view->data_bytes   = x_size*y_size*sizeof(float);
+	view->pixels_bytes = scaled_x_size*scaled_y_size*sizeof(ncv_pixel);
+	view->data   = (void *)membudget_malloc( MEM_VIEW, view->data_bytes );
+	view->pixels = (ncv_pixel *)membudget_malloc( MEM_VIEW, view->pixels_bytes );
+	if( (view->data == NULL) || (view->pixels == NULL) ) {
+		free_view_storage( view );
+		membudget_stats_string( stats );
+		fprintf( stderr, "ncview: not enough memory to show variable %s; in use: %s\n",
+			view->variable->name, stats );
+		snprintf( message, 1024, "Not enough memory to show variable %s\n(%ld x %ld, %.1f MB for the data and %.1f MB for the picture)",
+			view->variable->name, (long)x_size, (long)y_size,
+			(double)(x_size*y_size*sizeof(float))/1048576.0,
+			(double)(scaled_x_size*scaled_y_size*sizeof(ncv_pixel))/1048576.0 );
+		in_error( message );
+		return( -1 );
 		}
+
+	return( 0 );
+}
+
+/**************************************************************************************/
+	static void
+free_view_storage( View *view )
+{
+	membudget_free( MEM_VIEW, view->data,   view->data_bytes   );
+	membudget_free( MEM_VIEW, view->pixels, view->pixels_bytes );
+	view->data         = NULL;
+	view->pixels       = NULL;
+	view->data_bytes   = 0L;
+	view->pixels_bytes = 0L;
+	view_read_free();
 }
 
 /********************************************************************
@@ -1168,6 +1841,7 @@ view_set_range( void )
 
 	view->variable->user_min = new_min;
 	view->variable->user_max = new_max;
+	options.range_mode = RANGE_MODE_GLOBAL;
 	set_range_labels( new_min, new_max );
 	view->data_status = VDS_INVALID;
 	invalidate_all_saveframes();
@@ -1251,30 +1925,25 @@ set_range_labels( float min, float max )
 	void
 view_set_range_frame( void )
 {
-	long	i;
 	size_t	x_size, y_size;
-	float	min, max, dat;
+	float	min, max;
+
+	if( (view == NULL) || (view->data == NULL) )
+		return;
+
+	if( view->data_status == VDS_COARSE )
+		fill_view_data( view );
 
 	x_size = *(view->variable->size + view->x_axis_id);
 	y_size = *(view->variable->size + view->y_axis_id);
 
 	min = 1.0e35;
 	max = -min;
-
-	for( i=0; i<x_size*y_size; i++ ) {
-		dat = *((float *)(view->data)+i);
-		if( dat != dat ) 
-			dat = view->variable->fill_value;
-		if( ! close_enough( dat, view->variable->fill_value) && (dat != FILL_FLOAT)) {
-			if( dat > max )
-				max = dat;
-			if( dat < min )
-				min = dat;
-			}
-		}
+	data_valid_range( (float *)view->data, x_size*y_size, view->variable->fill_value, &min, &max );
 
 	view->variable->user_min = min;
 	view->variable->user_max = max;
+	options.range_mode = RANGE_MODE_GLOBAL;
 	set_range_labels( min, max );
 	view->data_status = VDS_INVALID;
 	invalidate_all_saveframes();
@@ -1283,6 +1952,25 @@ view_set_range_frame( void )
 	view_recompute_colorbar();
 }
 
+/**************************************************************************************
+ * The range of the passed variable has been widened by the range scan on the
+ * worker thread.  If it is being shown, with the colors stretched over the
+ * variable's range, redraw it.
+ */
+	void
+view_range_changed( NCVar *var )
+{
+	if( (view == NULL) || (view->variable != var) || (options.range_mode != RANGE_MODE_GLOBAL) )
+		return;
+
+	set_range_labels( var->user_min, var->user_max );
+	view->data_status = VDS_INVALID;
+	invalidate_all_saveframes();
+	view_draw( TRUE ); /* 'TRUE' because we just invalidated all saveframes */
+
+	view_recompute_colorbar();
+}
+
 /**************************************************************************************/
 	void
 beep()
@@ -1295,17 +1983,17 @@ beep()
 	void
 init_saveframes()
 {
-	long	i;
 	size_t	storage_size, n_scan_entries, x_size, y_size, scaled_x_size, scaled_y_size;
 	char	err_message[132];
 
+	in_clear_frame_pixmaps();
+	if( view != NULL )
+		forget_frame_ranges( view );
+
 	if( options.save_frames == FALSE )
 		return;
 
-	if( framestore.frame != NULL ) {
-		free( framestore.frame );
-		free( framestore.frame_valid );
-		}
+	framestore_free();
 
 	if( view->scan_axis_id == -1 )
 		n_scan_entries = 1;
@@ -1324,41 +2012,34 @@ init_saveframes()
 		fprintf( stderr, "	frame size: %ld\n", 
 				*(view->variable->size + view->x_axis_id) *
 				*(view->variable->size + view->y_axis_id) );
-		fprintf( stderr, "	total storage size:%ld\n", storage_size );
+		fprintf( stderr, "	total storage size (unencoded):%ld\n", storage_size );
+		fprintf( stderr, "	memory budget: %d MB\n", options.frame_mem_mb );
 		}
 
-	framestore.frame = (ncv_pixel *)malloc( storage_size*sizeof( ncv_pixel ));
-	if( framestore.frame == NULL ) {
-		framestore.valid = FALSE;
-		sprintf( err_message, "Can't allocate space for frame store.\nRequested size: %.1f MB",
-				(float)(storage_size*sizeof( ncv_pixel ))/1000000. );
+	/* Frames are encoded and evicted as needed to stay under the budget,
+	 * so all that has to be allocated up front is the bookkeeping.
+	 */
+	if( framestore_init( n_scan_entries, scaled_x_size, scaled_y_size, 
+			(size_t)options.frame_mem_mb * 1048576L ) < 0 ) {
+		sprintf( err_message, "Can't allocate space for frame store.\nFrame size: %.1f MB",
+				(float)(scaled_x_size*scaled_y_size*sizeof( ncv_pixel ))/1000000. );
 		options.save_frames = FALSE;
 		in_error( err_message );
 		}
-	else
-		{
-		framestore.valid = TRUE;
-		framestore.frame_valid = (int *)(malloc( n_scan_entries * sizeof( int )));
-		for( i=0; i<n_scan_entries; i++ )
-			*(framestore.frame_valid+i) = FALSE;
-		}
 }
 
 /**************************************************************************************/
 	void
 invalidate_all_saveframes()
 {
-	size_t	i, n_scan_entries;
+	in_clear_frame_pixmaps();
+	if( view != NULL )
+		forget_frame_ranges( view );
 
-	if( view == NULL )
+	if( (view == NULL) || (framestore.valid == FALSE) )
 		return;
 
-	if( (view->scan_axis_id == -1) || ( framestore.valid == FALSE ))
-		return;
-	else
-		n_scan_entries = *(view->variable->size + view->scan_axis_id);
-	for( i=0L; i<n_scan_entries; i++ )
-		*(framestore.frame_valid+i) = FALSE;
+	framestore_invalidate_all();
 }
 
 /**************************************************************************************/
@@ -1388,6 +2069,16 @@ init_view( View **view, NCVar *var )
 
 	(*view)->plot_XY_axis   = -1;
 	(*view)->plot_XY_nlines = 0;
+
+	(*view)->have_frame_range    = FALSE;
+	(*view)->frame_range_current = FALSE;
+	(*view)->have_prev_range     = FALSE;
+	(*view)->n_frame_ranges      = 0L;
+	(*view)->frame_ranges        = NULL;
+
+	(*view)->data_bytes   = 0L;
+	(*view)->pixels_bytes = 0L;
+	(*view)->scratch      = NULL;
 }
 
 /**************************************************************************************/
@@ -1669,6 +2360,7 @@ redraw_dimension_info()
 
 	var     = view->variable;
 	dimlist = fi_scannable_dims( var->first_file->id, var->name );
+	load_var_dims( var );
 
 	y_dim      = *(var->dim+view->y_axis_id);
 	cur_y_name = y_dim->name;
@@ -1793,7 +2485,11 @@ view_report_position( int x, int y, unsigned int button_mask )
 	if( view->variable->effective_dimensionality == 1 ) 
 		return;
 
-	if( view->data_status == VDS_INVALID ) {
+	/* Or if there wasn't memory to show the variable */
+	if( view->data == NULL )
+		return;
+
+	if( (view->data_status == VDS_INVALID) || (view->data_status == VDS_COARSE) ) {
 		fill_view_data( view );
 		view->data_status = VDS_VALID;
 		}
@@ -1880,7 +2576,10 @@ set_dataedit_place()
 	int	x, y;
 	size_t	index;
 
-	if( view->data_status == VDS_INVALID ) {
+	if( view->data == NULL )
+		return;
+
+	if( (view->data_status == VDS_INVALID) || (view->data_status == VDS_COARSE) ) {
 		fill_view_data( view );
 		view->data_status = VDS_VALID;
 		}
@@ -1920,7 +2619,10 @@ set_min_from_curdata()
 	int	x, y;
 	float	val;
 
-	if( view->data_status == VDS_INVALID ) {
+	if( view->data == NULL )
+		return;
+
+	if( (view->data_status == VDS_INVALID) || (view->data_status == VDS_COARSE) ) {
 		fill_view_data( view );
 		view->data_status = VDS_VALID;
 		}
@@ -1947,6 +2649,7 @@ set_min_from_curdata()
 	val = *((float *)view->data + data_x + data_y*x_size);
 
 	view->variable->user_min = val;
+	options.range_mode = RANGE_MODE_GLOBAL;
 	set_range_labels( val, view->variable->user_max );
 	init_saveframes();
 	view_draw( TRUE ); /* 'TRUE' because we just invalidated saveframes */
@@ -1962,7 +2665,10 @@ set_max_from_curdata()
 	int	x, y;
 	float	val;
 
-	if( view->data_status == VDS_INVALID ) {
+	if( view->data == NULL )
+		return;
+
+	if( (view->data_status == VDS_INVALID) || (view->data_status == VDS_COARSE) ) {
 		fill_view_data( view );
 		view->data_status = VDS_VALID;
 		}
@@ -1989,6 +2695,7 @@ set_max_from_curdata()
 	val = *((float *)view->data + data_x + data_y*x_size);
 
 	view->variable->user_max = val;
+	options.range_mode = RANGE_MODE_GLOBAL;
 	set_range_labels( val, view->variable->user_max );
 	init_saveframes();
 	view_draw( TRUE ); /* 'TRUE' because we just invalidated saveframes */
@@ -2006,6 +2713,12 @@ view_data_edit( void )
 	size_t	index, n_entries;
 	float	val;
 
+	if( (view == NULL) || (view->data == NULL) )
+		return;
+
+	if( view->data_status == VDS_COARSE )
+		fill_view_data( view );
+
 	x_size = *(view->variable->size + view->x_axis_id);
 	y_size = *(view->variable->size + view->y_axis_id);
 
@@ -2035,6 +2748,9 @@ view_change_dat( size_t index, float new_val )
 {
 	size_t	x_size, y_size, scaled_x_size, scaled_y_size, x, y;
 
+	if( view->data == NULL )
+		return;
+
 	view->data_status = VDS_EDITED;
 
 	x_size = *(view->variable->size + view->x_axis_id);
@@ -2050,8 +2766,11 @@ view_change_dat( size_t index, float new_val )
 		*((float *)view->data + x + (x_size)*y), new_val );
 
 	*((float *)view->data + x + (x_size)*y) = new_val;
+	slabcache_forget( view->variable, view->var_place, view->x_axis_id, view->y_axis_id );
 	init_saveframes();
 	lockout_view_changes = TRUE;
+	view->frame_range_current = FALSE;
+	update_frame_range();
 	if( data_to_pixels( view ) < 0 ) {
 		in_timer_clear();
 		if( view->variable->global_min == view->variable->global_max )
@@ -2072,6 +2791,9 @@ view_data_edit_dump( void )
 	size_t	x_size, y_size, start[2], count[2];
 	int	x_dimid, y_dimid, varid, err;
 
+	if( view->data == NULL )
+		return;
+
 	if( view->data_status != VDS_EDITED ) {
 		fprintf( stderr, "Warning!  Data is NOT CHANGED!\n" );
 		}
@@ -2080,6 +2802,7 @@ view_data_edit_dump( void )
 	
 	message = in_dialog( "Filename to dump data to:", filename, TRUE );
 	if( message == MESSAGE_OK ) {
+		fi_lock();
 		ncid = nccreate( filename, NC_CLOBBER );
 
 		x_size = *(view->variable->size + view->x_axis_id);
@@ -2109,6 +2832,7 @@ view_data_edit_dump( void )
 			fprintf( stderr, "%s\n", nc_strerror(err) );
 			}
 		ncclose( ncid );
+		fi_unlock();
 		}
 }
 
@@ -2134,7 +2858,7 @@ view_data_edit_warn()
 plot_XY()
 {
 	int	X_axis, i, x_window, y_window;
-	size_t	*start, *count, data_x, data_y, x_size, y_size, n;
+	size_t	start[MAX_VAR_DIMS], count[MAX_VAR_DIMS], data_x, data_y, x_size, y_size, n;
 
 	X_axis = view->plot_XY_axis;
 	if( X_axis == -1 ) {
@@ -2168,9 +2892,6 @@ plot_XY()
 	if( !options.invert_physical )
 		data_y = y_size - data_y - 1;
 
-	start = (size_t *)malloc(view->variable->n_dims*sizeof(size_t));
-	count = (size_t *)malloc(view->variable->n_dims*sizeof(size_t));
-
 	/* Compute start and count arrays for data to plot.  Note that
 	 * the ordering of the following lines is important.  We first
 	 * set to the base variable place.  We then insert the place
@@ -2213,7 +2934,7 @@ plot_XY()
 view_set_XY_plot_axis( String label )
 {
 	int		dim_to_plot, i, j;
-	size_t		*start, *count;
+	size_t		start[MAX_VAR_DIMS], count[MAX_VAR_DIMS];
 	char		message[1024];
 
 	if( options.debug )
@@ -2237,9 +2958,6 @@ view_set_XY_plot_axis( String label )
 
 	view->plot_XY_axis = dim_to_plot;
 
-	start = (size_t *)malloc( sizeof(size_t)*view->variable->n_dims );
-	count = (size_t *)malloc( sizeof(size_t)*view->variable->n_dims );
-
 	unlock_plot();
 
 	for( i=0; i<view->plot_XY_nlines; i++ ) {
@@ -2252,26 +2970,22 @@ view_set_XY_plot_axis( String label )
 		*(count+view->plot_XY_axis) = *(view->variable->size + view->plot_XY_axis);
 		plot_XY_sc( start, count );
 		}
-	free( start );
-	free( count );
 }
 
 /**************************************************************************************
- * Plot all the data along the specified start and count
+ * Plot all the data along the specified start and count.  The data is read
+ * on the worker thread, and plotted by plot_XY_read_done.
  */
 	static void
 plot_XY_sc( size_t *start, size_t *count )
 {
-	size_t	i_size;
-	int	n_misplace, n_missing_eliminated;
-	long	i, j, k, n, misplace_index[5];
-	float	t_xval, t_yval, tol, *tmp_yvals;
-	double	y_min, y_max, temp_double, bound_min, bound_max;
-	char	x_axis_title[132], y_axis_title[132], temp2_string[128], legend[512];
-	char	title[512], *file_title, temp_string[128], *dim_name, *units, *long_name;
-	char	message[512];
-	int	has_bounds, type, all_same, have_done_one, dim_to_plot, plot_index;
-	Stringlist *dimlist;
+	size_t		i_size;
+	long		i, n;
+	double		temp_double, bound_min, bound_max;
+	char		temp_string[128], message[512];
+	int		has_bounds, type, dim_to_plot;
+	PlotRead	*p;
+	WorkerTask	*task;
 
 	if( options.debug ) {
 		fprintf( stderr, "entering plot_XY_sc\n" );
@@ -2280,21 +2994,8 @@ plot_XY_sc( size_t *start, size_t *count )
 				i, *(start+i), *(count+i) );
 		}
 
-	if( options.show_sel ) {
-		printf( "-var %s -start \\(", view->variable->name );
-		for( i=view->variable->n_dims-1; i >= 0; i-- ) {
-			printf( "%1ld", 1 + (*(start+i)) );
-			if( i != 0 )
-				printf( "," );
-			}
-		printf( "\\) -count \\(" );
-		for( i=view->variable->n_dims-1; i >= 0; i-- ) {
-			printf( "%1ld", *(count+i) );
-			if( i != 0 )
-				printf( "," );
-			}
-		printf( "\\) %s\n", view->variable->first_file->filename );
-		}
+	if( options.show_sel )
+		print_selection( view->variable, start, count );
 
 	/* The axis we want to plot must be the one with more
 	 * than one count.
@@ -2312,37 +3013,35 @@ plot_XY_sc( size_t *start, size_t *count )
 		in_error( "Error!  I found no dimension to plot!\n" );
 		return;
 		}
-	dim_name = (*(view->variable->dim + dim_to_plot))->name;
 		
         n = *(view->variable->size + dim_to_plot);
 
-	if( plot_XY_xvals != NULL ) 
-		free( plot_XY_xvals );
-	if( options.debug ) 
-		fprintf( stderr, "about to malloc %ld floats (x vals)\n", n );
-	plot_XY_xvals = (double *)malloc(n*sizeof(double));
-	if( plot_XY_xvals == NULL ) {
-		fprintf( stderr, "malloc failed on allocation of X data for plot!\n" );
-		fprintf( stderr, "requested # bytes=%ld\n", n*sizeof(double) );
+	p = (PlotRead *)malloc( sizeof( PlotRead ));
+	if( p == NULL ) {
+		fprintf( stderr, "ncview: plot_XY_sc: failed on malloc\n" );
 		exit( -1 );
 		}
-
-	if( plot_XY_yvals != NULL )
-		free( plot_XY_yvals );
 	if( options.debug ) 
-		fprintf( stderr, "about to malloc %ld floats (y vals)\n", n );
-	plot_XY_yvals = (double *)malloc(n*sizeof(double));
-	if( plot_XY_yvals == NULL ) {
-		fprintf( stderr, "malloc failed on allocation of Y data for plot!\n" );
-		fprintf( stderr, "requested # bytes=%ld\n", n*sizeof(double) );
-		exit( -1 );
+		fprintf( stderr, "about to malloc %ld doubles (x and y vals)\n", n );
+	p->xvals     = (double *)membudget_malloc( MEM_PLOT, n*sizeof(double) );
+	p->yvals     = (double *)membudget_malloc( MEM_PLOT, n*sizeof(double) );
+	p->tmp_yvals = (float  *)membudget_malloc( MEM_PLOT, n*sizeof(float) );
+	if( (p->xvals == NULL) || (p->yvals == NULL) || (p->tmp_yvals == NULL) ) {
+		membudget_free( MEM_PLOT, p->xvals,     n*sizeof(double) );
+		membudget_free( MEM_PLOT, p->yvals,     n*sizeof(double) );
+		membudget_free( MEM_PLOT, p->tmp_yvals, n*sizeof(float) );
+		free( p );
+		sprintf( message, "Not enough memory to plot %ld values", n );
+		in_error( message );
+		return;
 		}
-
-	tmp_yvals = (float *)malloc(n*sizeof(float));
-	if( tmp_yvals == NULL ) {
-		fprintf( stderr, "malloc failed on allocation of tmp Y data for plot!\n" );
-		fprintf( stderr, "requested # bytes=%ld\n", n*sizeof(float) );
-		exit( -1 );
+	p->var         = view->variable;
+	p->dim_to_plot = dim_to_plot;
+	p->n           = n;
+	p->done        = FALSE;
+	for( i=0; i<view->variable->n_dims; i++ ) {
+		*(p->start+i) = *(start+i);
+		*(p->count+i) = *(count+i);
 		}
 
 	in_set_cursor_busy();
@@ -2352,20 +3051,85 @@ plot_XY_sc( size_t *start, size_t *count )
 		type = fi_dim_value( view->variable, dim_to_plot, i_size, &temp_double, 
 				temp_string, &has_bounds, &bound_min, &bound_max );
 		if( type == NC_DOUBLE ) 
-			*(plot_XY_xvals+i_size) = temp_double;
+			*(p->xvals+i_size) = temp_double;
 		else
-			*(plot_XY_xvals+i_size) = (double)i_size;
+			*(p->xvals+i_size) = (double)i_size;
 		}
 	/* If there is a range of the axis of 0, commonly because
 	 * the dimvar has only fill values, then the plotting widget
 	 * crashes.  Hack to avoid this problem.
 	 */
-	if( *plot_XY_xvals == *(plot_XY_xvals+n-1) ) 
+	if( *p->xvals == *(p->xvals+n-1) ) 
 		for(i=0; i<n; i++ )
-			*(plot_XY_xvals+i) = (double)i;
+			*(p->xvals+i) = (double)i;
 
 	/* Get the y values (values to be plotted) */
-	fi_get_data( view->variable, start, count, tmp_yvals );
+	task = worker_new_task( "Reading the plot", plot_XY_read_work, plot_XY_read_done, p );
+	task->lane = WORKER_LANE_VIEW;
+	worker_run( task );
+}
+
+/**************************************************************************************
+ * Work routine for plot_XY_sc; runs on the worker thread.
+ */
+	static void
+plot_XY_read_work( WorkerTask *task )
+{
+	PlotRead	*p;
+
+	p = (PlotRead *)task->data;
+	if( worker_cancelled( task ))
+		return;
+	fi_get_data( p->var, p->start, p->count, p->tmp_yvals );
+	p->done = TRUE;
+}
+
+/**************************************************************************************
+ * Done routine for plot_XY_sc.  The plot is put up unless the user has gone
+ * on to another variable meanwhile.  Its values replace the saved ones.
+ */
+	static void
+plot_XY_read_done( WorkerTask *task, int use_result )
+{
+	PlotRead	*p;
+
+	p = (PlotRead *)task->data;
+	if( use_result && p->done && (view != NULL) && (view->variable == p->var) ) {
+		membudget_free( MEM_PLOT, plot_XY_xvals, plot_XY_n*sizeof(double) );
+		membudget_free( MEM_PLOT, plot_XY_yvals, plot_XY_n*sizeof(double) );
+		plot_XY_xvals = p->xvals;
+		plot_XY_yvals = p->yvals;
+		plot_XY_n     = p->n;
+		plot_XY_show( p->start, p->dim_to_plot, p->n, p->tmp_yvals );
+		}
+	else
+		{
+		membudget_free( MEM_PLOT, p->xvals, p->n*sizeof(double) );
+		membudget_free( MEM_PLOT, p->yvals, p->n*sizeof(double) );
+		in_set_cursor_normal();
+		}
+	membudget_free( MEM_PLOT, p->tmp_yvals, p->n*sizeof(float) );
+	free( p );
+}
+
+/**************************************************************************************
+ * Put up the plot of the n values in tmp_yvals along dimension dim_to_plot,
+ * which start at 'start'.  The X values are in plot_XY_xvals.
+ */
+	static void
+plot_XY_show( size_t *start, int dim_to_plot, long n, float *tmp_yvals )
+{
+	int	n_misplace, n_missing_eliminated;
+	long	i, j, k, misplace_index[5];
+	float	t_xval, t_yval, tol;
+	double	y_min, y_max, temp_double, bound_min, bound_max;
+	char	x_axis_title[132], y_axis_title[132], temp2_string[128], legend[512];
+	char	title[512], *file_title, temp_string[128], *dim_name, *units, *long_name;
+	char	message[512];
+	int	has_bounds, type, all_same, have_done_one, plot_index;
+	Stringlist *dimlist;
+
+	dim_name = (*(view->variable->dim + dim_to_plot))->name;
 
 	/* Eliminate the missing values */
 	j = 0;
@@ -2387,7 +3151,6 @@ plot_XY_sc( size_t *start, size_t *count )
 				misplace_index[n_missing_eliminated-1] = i;
 			}
 		}
-	free( tmp_yvals );
 	if( n != j ) {
 		printf( "Note: %ld missing values were eliminated along axis \"%s\"; index= ", 
 							n-j, dim_name );
@@ -2544,9 +3307,12 @@ view_plot_XY_fmt_x_val( float val, int dimindex, char *s )
 	void
 view_information( void )
 {
-	in_display_stuff( netcdf_att_string( view->variable->first_file->id,
-						view->variable->name ),  
-			view->variable->name );
+	char	*info;
+
+	fi_lock();
+	info = netcdf_att_string( view->variable->first_file->id, view->variable->name );
+	fi_unlock();
+	in_display_stuff( info, view->variable->name );
 }
 
 /**************************************************************************************/
@@ -2611,7 +3377,7 @@ view_data_has_missing( View *v )
 	size_t 	nx, ny, i;
 	float	dat;
 
-	if( (v == NULL) || (v->variable == NULL))
+	if( (v == NULL) || (v->variable == NULL) || (v->data == NULL) )
 		return(TRUE);
 
 	if( v->x_axis_id < 0 ) 
@@ -2661,19 +3427,93 @@ view_change_transform( int delta )
 /***************************************************************************/
 void view_recompute_colorbar( void )
 {
-	if( options.debug ) {
+	if( options.debug )
 		fprintf( stderr, "view_recompute_colorbar: entering\n" );
-		fprintf( stderr, "view_recompute_colorbar: about to call x_create_colorbar with user_min=%f user_max=%f transform=%d\n",
-				view->variable->user_min, view->variable->user_max, options.transform );
-		}
 
-	x_create_colorbar( view->variable->user_min, view->variable->user_max, options.transform );
+	if( (options.range_mode == RANGE_MODE_FRAME) && view->have_frame_range )
+		make_colorbar( view->frame_min, view->frame_max );
+	else
+		make_colorbar( view->variable->user_min, view->variable->user_max );
 
 	if( options.debug )
-		fprintf( stderr, "view_recompute_colorbar: about to call x_draw_colorbar" );
-	x_draw_colorbar();
+		fprintf( stderr, "view_recompute_colorbar: exiting\n" );
+}
 
+/***************************************************************************/
+	static void
+make_colorbar( float min, float max )
+{
 	if( options.debug )
-		fprintf( stderr, "view_recompute_colorbar: exiting\n" );
+		fprintf( stderr, "make_colorbar: about to call x_create_colorbar with min=%f max=%f transform=%d\n",
+				min, max, options.transform );
+
+	x_create_colorbar( min, max, options.transform );
+
+	if( options.debug )
+		fprintf( stderr, "make_colorbar: about to call x_draw_colorbar" );
+	x_draw_colorbar();
+
+	cbar_min = min;
+	cbar_max = max;
+}
+
+/***************************************************************************
+ * Switch between stretching the colormap over the variable's range, and 
+ * stretching it over each frame's own range.
+ */
+	void
+view_toggle_range_mode( void )
+{
+	if( options.range_mode == RANGE_MODE_FRAME )
+		options.range_mode = RANGE_MODE_GLOBAL;
+	else
+		options.range_mode = RANGE_MODE_FRAME;
+
+	invalidate_all_saveframes();
+	view->frame_range_current = FALSE;
+	if( options.range_mode == RANGE_MODE_GLOBAL )
+		set_range_labels( view->variable->user_min, view->variable->user_max );
+	view_draw( TRUE ); /* 'TRUE' because we just invalidated all saveframes */
+
+	view_recompute_colorbar();
+}
+
+/***************************************************************************
+ * In RANGE_MODE_FRAME, make sure the frame range is set for what is in
+ * view->data, and show it.
+ */
+	static void
+update_frame_range( void )
+{
+	if( options.range_mode != RANGE_MODE_FRAME )
+		return;
+
+	if( ! view->frame_range_current )
+		set_frame_range( view );
+	show_frame_range( view->frame_min, view->frame_max );
+}
+
+/***************************************************************************/
+	static void
+show_frame_range( float min, float max )
+{
+	char	*units, temp_label[1024];
+
+	units = fi_var_units( view->variable->first_file->id, view->variable->name );
+	if( units == NULL )
+		sprintf( temp_label, "displayed range: %g to %g (this frame: %g to %g)",
+			view->variable->global_min,
+			view->variable->global_max,
+			min, max );
+	else
+		sprintf( temp_label, "displayed range: %g to %g %s (this frame: %g to %g)",
+			view->variable->global_min,
+			view->variable->global_max,
+			limit_string(units),
+			min, max );
+	in_set_label( LABEL_DATA_EXTREMA, temp_label );
+
+	if( (min != cbar_min) || (max != cbar_max) )
+		make_colorbar( min, max );
 }
 
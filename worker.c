@@ -0,0 +1,444 @@
+/*
+ * Ncview by David W. Pierce.  A visual netCDF file viewer.
+ * Copyright (C) 1993 through 2008 David W. Pierce
+ *
+ * This program  is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License, version 3, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * David W. Pierce
+ * 6259 Caminito Carrean
+ * San Diego, CA   92122
+ * pierce@cirrus.ucsd.edu
+ */
+
+
+/*******************************************************************************
+ * 	worker.c
+ *
+ *	Runs long jobs, such as scanning a whole variable for its range, on
+ *	a worker thread so that the windows keep working while the data
+ *	is read.  Tasks are queued with worker_run.  There are two lanes, 
+ *	each with its own thread, that each do their tasks one at a time, 
+ *	in order: one for long jobs, and one for reading the frame or plot
+ *	being looked at, so that these don't have to wait for a long job 
+ *	to finish.  The worker threads tell the main thread about progress
+ *	and finished tasks by writing a byte to a pipe that the X event
+ *	loop watches, so the 'done' routines, and anything they do to the
+ *	windows, always run on the main thread.
+ *
+ *	If a task runs for more than half a second, a small window shows
+ *	how far along it is, with a Cancel button.  Cancel, or anything
+ *	that makes the queued work moot (like picking another variable),
+ *	calls worker_cancel_all.  That bumps the generation, so tasks that
+ *	were started before it have their results thrown away even if
+ *	they finish, and asks the ones running to stop.  A task checks
+ *	worker_cancelled between its steps.  The generation and cancel
+ *	flags are only changed on the main thread, with the lock held, 
+ *	and read by the tasks with atomic loads.
+ *
+ *	The netCDF library is not thread safe, so the task must only read
+ *	through the fi_ routines, which hold the file lock.
+ *
+ *	Without worker_init (in batch mode and in the benchmarks) tasks
+ *	are simply run as soon as they are given to worker_run.
+ *******************************************************************************/
+
+#include "ncview.includes.h"
+#include "ncview.defines.h"
+#include "ncview.protos.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* How long a task runs before its progress is shown, in seconds */
+#define WORKER_SHOW_DELAY	0.5
+
+extern Options options;
+
+static int		have_thread = FALSE;
+static int		pipe_fd[2];
+static pthread_t	thread[WORKER_N_LANES];
+static pthread_mutex_t	lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	cond = PTHREAD_COND_INITIALIZER;
+static WorkerTask	*queue[WORKER_N_LANES], *running[WORKER_N_LANES];
+static WorkerTask	*finished = NULL;
+static unsigned long	generation = 0L;
+static int		progress_shown = FALSE;
+
+/* The task worker_run_modal is waiting on, and what happened to it */
+static WorkerTask	*modal_task = NULL;
+static int		modal_done, modal_used;
+
+static void	*worker_thread	( void *arg );
+static void	worker_input	( XtPointer client_data, int *fd, XtInputId *id );
+static void	worker_notify	( char c );
+static void	task_finished	( WorkerTask *task, int use_result );
+static void	show_progress	( void );
+
+/*******************************************************************************
+ * Start the worker thread.  Called once the windows are up.
+ */
+	void
+worker_init( void )
+{
+	long	lane;
+
+	for( lane=0; lane<WORKER_N_LANES; lane++ ) {
+		queue[lane]   = NULL;
+		running[lane] = NULL;
+		}
+
+	if( pipe( pipe_fd ) != 0 ) {
+		fprintf( stderr, "ncview: worker_init: can't make a pipe, long jobs will hold up the windows\n" );
+		return;
+		}
+	for( lane=0; lane<WORKER_N_LANES; lane++ )
+		if( pthread_create( thread+lane, NULL, worker_thread, (void *)lane ) != 0 ) {
+			/* The threads already started just wait, since nothing is queued */
+			fprintf( stderr, "ncview: worker_init: can't start a thread, long jobs will hold up the windows\n" );
+			close( pipe_fd[0] );
+			close( pipe_fd[1] );
+			return;
+			}
+	in_add_input( pipe_fd[0], worker_input, NULL );
+	have_thread = TRUE;
+}
+
+/*******************************************************************************
+ * Returns TRUE if tasks given to worker_run are done on a worker thread, 
+ * rather than right away.
+ */
+	int
+worker_threaded( void )
+{
+	return( have_thread );
+}
+
+/*******************************************************************************
+ * Returns TRUE if there are no tasks queued or running.  Tasks that are done
+ * but whose done routines have not been called yet count as running.
+ */
+	int
+worker_idle( void )
+{
+	int	lane, idle;
+
+	if( ! have_thread )
+		return( TRUE );
+
+	pthread_mutex_lock( &lock );
+	idle = (finished == NULL);
+	for( lane=0; lane<WORKER_N_LANES; lane++ )
+		if( (queue[lane] != NULL) || (running[lane] != NULL) )
+			idle = FALSE;
+	pthread_mutex_unlock( &lock );
+	return( idle );
+}
+
+/*******************************************************************************
+ * Make a task for worker_run.  'title' is not copied.
+ */
+	WorkerTask *
+worker_new_task( char *title, void (*work)( WorkerTask *task ),
+		void (*done)( WorkerTask *task, int use_result ), void *data )
+{
+	WorkerTask	*task;
+
+	task = (WorkerTask *)malloc( sizeof( WorkerTask ));
+	if( task == NULL ) {
+		fprintf( stderr, "ncview: worker_new_task: failed on malloc\n" );
+		exit( -1 );
+		}
+	worker_init_task( task, title, work, done, data );
+	task->keep = FALSE;
+
+	return( task );
+}
+
+/*******************************************************************************
+ * Set up a task that belongs to the caller, for something done over and over
+ * (like reading frames) that shouldn't allocate each time.  The worker does 
+ * not free it, and it can be set up and run again once its done routine
+ * has been called.
+ */
+	void
+worker_init_task( WorkerTask *task, char *title, void (*work)( WorkerTask *task ),
+		void (*done)( WorkerTask *task, int use_result ), void *data )
+{
+	task->title      = title;
+	task->work       = work;
+	task->done       = done;
+	task->data       = data;
+	task->lane       = WORKER_LANE_LONG;
+	task->keep       = TRUE;
+	task->generation = 0L;
+	task->cancel     = FALSE;
+	task->progress   = 0.0;
+	task->started    = 0.0;
+	task->next       = NULL;
+}
+
+/*******************************************************************************
+ * Queue the task.  Its done routine is called later on from the event loop,
+ * and then the task is freed, unless it came from worker_init_task.
+ */
+	void
+worker_run( WorkerTask *task )
+{
+	WorkerTask	*t;
+
+	task->generation = generation;
+
+	if( ! have_thread ) {
+		(*task->work)( task );
+		task_finished( task, ! task->cancel );
+		return;
+		}
+
+	pthread_mutex_lock( &lock );
+	if( queue[task->lane] == NULL )
+		queue[task->lane] = task;
+	else
+		{
+		t = queue[task->lane];
+		while( t->next != NULL )
+			t = t->next;
+		t->next = task;
+		}
+	pthread_cond_broadcast( &cond );
+	pthread_mutex_unlock( &lock );
+}
+
+/*******************************************************************************
+ * Run the task, and wait for it, with the progress window up from the start
+ * and the rest of the windows locked out.  Events are handled meanwhile, so
+ * the windows are redrawn and Cancel works.  Returns TRUE if the task
+ * finished, FALSE if it was cancelled.
+ */
+	int
+worker_run_modal( WorkerTask *task )
+{
+	if( ! have_thread ) {
+		worker_run( task );
+		return( TRUE );
+		}
+
+	modal_task = task;
+	modal_done = FALSE;
+	modal_used = FALSE;
+	worker_run( task );
+
+	in_progress_show( task->title, TRUE );
+	progress_shown = TRUE;
+	while( ! modal_done )
+		in_process_event();
+
+	modal_task = NULL;
+	in_progress_hide();
+	progress_shown = FALSE;
+	show_progress();	/* for whatever is running now */
+	return( modal_used );
+}
+
+/*******************************************************************************
+ * Stop everything: the running tasks are asked to stop, queued ones are
+ * dropped, and the results of any of them that still come in are ignored.
+ */
+	void
+worker_cancel_all( void )
+{
+	WorkerTask	*dropped[WORKER_N_LANES], *next;
+	int		lane;
+
+	pthread_mutex_lock( &lock );
+	__atomic_store_n( &generation, generation+1L, __ATOMIC_RELEASE );
+	for( lane=0; lane<WORKER_N_LANES; lane++ ) {
+		if( running[lane] != NULL )
+			__atomic_store_n( &running[lane]->cancel, TRUE, __ATOMIC_RELEASE );
+		dropped[lane] = queue[lane];
+		queue[lane]   = NULL;
+		}
+	pthread_mutex_unlock( &lock );
+
+	for( lane=0; lane<WORKER_N_LANES; lane++ )
+		while( dropped[lane] != NULL ) {
+			next = dropped[lane]->next;
+			task_finished( dropped[lane], FALSE );
+			dropped[lane] = next;
+			}
+}
+
+/*******************************************************************************
+ * Called by a task's work routine between steps; if this returns TRUE, it
+ * should stop.
+ */
+	int
+worker_cancelled( WorkerTask *task )
+{
+	return( __atomic_load_n( &task->cancel, __ATOMIC_ACQUIRE ) || 
+		(task->generation != __atomic_load_n( &generation, __ATOMIC_ACQUIRE )) );
+}
+
+/*******************************************************************************
+ * Called by a task's work routine to say how far along it is, from 0 to 1.
+ */
+	void
+worker_progress( WorkerTask *task, float fraction )
+{
+	int	changed;
+
+	pthread_mutex_lock( &lock );
+	changed = (fraction - task->progress >= 0.01);
+	if( changed )
+		task->progress = fraction;
+	pthread_mutex_unlock( &lock );
+
+	if( changed && have_thread )
+		worker_notify( 'p' );
+}
+
+/*******************************************************************************/
+	static void *
+worker_thread( void *arg )
+{
+	WorkerTask	*task, *t;
+	int		lane;
+
+	lane = (int)(long)arg;
+	for( ;; ) {
+		pthread_mutex_lock( &lock );
+		while( queue[lane] == NULL )
+			pthread_cond_wait( &cond, &lock );
+		task          = queue[lane];
+		queue[lane]   = task->next;
+		task->next    = NULL;
+		task->started = timing_now();
+		running[lane] = task;
+		pthread_mutex_unlock( &lock );
+
+		(*task->work)( task );
+
+		pthread_mutex_lock( &lock );
+		running[lane] = NULL;
+		if( finished == NULL )
+			finished = task;
+		else
+			{
+			t = finished;
+			while( t->next != NULL )
+				t = t->next;
+			t->next = task;
+			}
+		pthread_mutex_unlock( &lock );
+
+		worker_notify( 'd' );
+		}
+
+	return( NULL );
+}
+
+/*******************************************************************************
+ * Write to the pipe, which wakes up the event loop and has worker_input
+ * called.
+ */
+	static void
+worker_notify( char c )
+{
+	while( (write( pipe_fd[1], &c, 1 ) < 0) && (errno == EINTR) )
+		;
+}
+
+/*******************************************************************************
+ * Called from the event loop when the worker thread has written to the pipe.
+ */
+	static void
+worker_input( XtPointer client_data, int *fd, XtInputId *id )
+{
+	char		buf[64];
+	WorkerTask	*done, *next;
+
+	if( read( *fd, buf, sizeof(buf) ) < 0 )
+		return;
+
+	pthread_mutex_lock( &lock );
+	done     = finished;
+	finished = NULL;
+	pthread_mutex_unlock( &lock );
+
+	while( done != NULL ) {
+		next = done->next;
+		task_finished( done, (! done->cancel) && (done->generation == generation) );
+		done = next;
+		}
+
+	show_progress();
+}
+
+/*******************************************************************************/
+	static void
+task_finished( WorkerTask *task, int use_result )
+{
+	int	keep;
+
+	if( task == modal_task ) {
+		modal_done = TRUE;
+		modal_used = use_result;
+		}
+
+	if( options.debug )
+		fprintf( stderr, "worker: %s %s\n", task->title, use_result ? "done" : "cancelled" );
+
+	keep = task->keep;
+	(*task->done)( task, use_result );
+	if( ! keep )
+		free( task );
+}
+
+/*******************************************************************************
+ * Put up, update, or take down the progress window, as the running tasks
+ * need.  The modal task, if there is one, is the one shown.
+ */
+	static void
+show_progress( void )
+{
+	char		message[1024];
+	int		lane;
+	WorkerTask	*shown;
+
+	pthread_mutex_lock( &lock );
+	shown = NULL;
+	for( lane=0; lane<WORKER_N_LANES; lane++ ) {
+		if( running[lane] == NULL )
+			continue;
+		if( running[lane] == modal_task ) {
+			shown = running[lane];
+			break;
+			}
+		if( (shown == NULL) && (timing_now() - running[lane]->started > WORKER_SHOW_DELAY) )
+			shown = running[lane];
+		}
+	if( shown != NULL )
+		snprintf( message, sizeof(message), "%s: %d%% done", shown->title,
+			(int)(100.0*shown->progress) );
+	pthread_mutex_unlock( &lock );
+
+	if( shown != NULL ) {
+		in_progress_show( message, modal_task != NULL );
+		progress_shown = TRUE;
+		}
+	else if( progress_shown && ((modal_task == NULL) || modal_done) ) {
+		in_progress_hide();
+		progress_shown = FALSE;
+		}
+}